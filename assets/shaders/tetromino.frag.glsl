@@ -5,22 +5,32 @@ out vec4 FragColor;
 in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoords;
+flat in vec4 Color;
+flat in int IsGhost;
 
-uniform vec4 u_color;
-uniform vec3 u_viewPos;
-uniform float u_time;
-uniform bool u_isGhost;
+// Per-frame data, uploaded once by FrameUniformBuffer (binding 0)
+layout(std140, binding = 0) uniform FrameData {
+  mat4 u_view;
+  mat4 u_projection;
+  mat4 u_viewProjection;
+  mat4 u_hudProjection;
+  mat4 u_screenProjection;
+  vec4 u_cameraPos;
+  float u_time;
+};
 
 void main() {
-  vec3 baseColor = u_color.rgb;
-  float alpha = u_color.a;
+  vec3 baseColor = Color.rgb;
+  float alpha = Color.a;
+  // Merged stack faces span several cells, keep the bevel per cell
+  vec2 uv = fract(TexCoords);
 
   vec3 norm = normalize(Normal);
-  vec3 viewDir = normalize(u_viewPos - FragPos);
+  vec3 viewDir = normalize(u_cameraPos.xyz - FragPos);
 
-  if (u_isGhost) {
-    float edge = step(0.95, TexCoords.x) + step(0.95, TexCoords.y) +
-        step(TexCoords.x, 0.05) + step(TexCoords.y, 0.05);
+  if (IsGhost != 0) {
+    float edge = step(0.95, uv.x) + step(0.95, uv.y) +
+        step(uv.x, 0.05) + step(uv.y, 0.05);
     edge = clamp(edge, 0.0, 1.0);
 
     vec3 ghostColor = baseColor;
@@ -44,10 +54,10 @@ void main() {
 
     // Bevel look
     float edgeWidth = 0.05;
-    float vignette = smoothstep(0.0, edgeWidth, TexCoords.x)
-        * smoothstep(1.0, 1.0 - edgeWidth, TexCoords.x)
-        * smoothstep(0.0, edgeWidth, TexCoords.y)
-        * smoothstep(1.0, 1.0 - edgeWidth, TexCoords.y);
+    float vignette = smoothstep(0.0, edgeWidth, uv.x)
+        * smoothstep(1.0, 1.0 - edgeWidth, uv.x)
+        * smoothstep(0.0, edgeWidth, uv.y)
+        * smoothstep(1.0, 1.0 - edgeWidth, uv.y);
 
     FragColor = vec4(combinedRGB * (0.8 + 0.2 * vignette), alpha);
   }
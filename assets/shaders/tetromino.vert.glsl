@@ -3,24 +3,70 @@
 layout(location = 0) in vec3 aPos;
 layout(location = 1) in vec3 aNormal;
 layout(location = 2) in vec2 aTexCoords;
+layout(location = 3) in vec4 aColor; // stack mesh only
 
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoords;
+flat out vec4 Color;
+flat out int IsGhost;
+
+// Board cells, one per instance (TetrisRenderer::CellInstance)
+struct CellInstance {
+  vec4 position; // xyz: world position, w: 1 for ghost cells
+  vec4 color;
+};
+
+layout(std430, binding = 0) readonly buffer CellInstances {
+  CellInstance cells[];
+};
+
+// Per-frame data, uploaded once by FrameUniformBuffer (binding 0)
+layout(std140, binding = 0) uniform FrameData {
+  mat4 u_view;
+  mat4 u_projection;
+  mat4 u_viewProjection;
+  mat4 u_hudProjection;
+  mat4 u_screenProjection;
+  vec4 u_cameraPos;
+  float u_time;
+};
 
 uniform mat4 u_model;
-uniform mat4 u_view;
-uniform mat4 u_projection;
+uniform vec4 u_color;
+uniform bool u_isGhost;
+uniform bool u_instanced;
+uniform bool u_stackMesh;
+uniform bool u_hud; // hold / queue previews, drawn without the camera
 
 void main() {
-  // Calculate the position in world space
-  FragPos = vec3(u_model * vec4(aPos, 1.0));
+  if (u_stackMesh) {
+    // Pre-built in world space by StackMesher
+    FragPos = aPos;
+    Normal = aNormal;
+    Color = aColor;
+    IsGhost = 0;
+  } else if (u_instanced) {
+    CellInstance cell = cells[gl_InstanceID];
+
+    // Cells are only translated, so normals need no correction
+    FragPos = aPos + cell.position.xyz;
+    Normal = aNormal;
+    Color = cell.color;
+    IsGhost = cell.position.w > 0.5 ? 1 : 0;
+  } else {
+    // Calculate the position in world space
+    FragPos = vec3(u_model * vec4(aPos, 1.0));
 
-  // Transform normals to world space
-  // (We use a Normal Matrix to handle scaling correctly)
-  Normal = mat3(transpose(inverse(u_model))) * aNormal;
+    // Transform normals to world space
+    // (We use a Normal Matrix to handle scaling correctly)
+    Normal = mat3(transpose(inverse(u_model))) * aNormal;
+    Color = u_color;
+    IsGhost = u_isGhost ? 1 : 0;
+  }
 
   TexCoords = aTexCoords;
 
-  gl_Position = u_projection * u_view * vec4(FragPos, 1.0);
+  gl_Position = u_hud ? u_hudProjection * vec4(FragPos, 1.0)
+                     : u_viewProjection * vec4(FragPos, 1.0);
 }
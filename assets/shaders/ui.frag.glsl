@@ -1,17 +1,23 @@
 #version 450 core
 out vec4 FragColor;
 in vec2 TexCoords;
+in vec4 Color;
+flat in float Textured;
 
 uniform sampler2D u_icon;
-uniform vec4 u_color;
-uniform bool u_hasTexture;
 
 void main() {
-  if (u_hasTexture) {
+  if (Textured > 1.5) {
+    // Signed distance field text: the edge sits at 0.5, antialiased over
+    // about one screen pixel whatever the scale
+    float d = texture(u_icon, TexCoords).a;
+    float w = fwidth(d);
+    FragColor = vec4(Color.rgb, Color.a * smoothstep(0.5 - w, 0.5 + w, d));
+  } else if (Textured > 0.5) {
     vec4 sampled = texture(u_icon, TexCoords);
-    // Multiply by u_color to allow "tinting" icons
-    FragColor = sampled * u_color;
+    // Multiply by the vertex color to allow "tinting" icons
+    FragColor = sampled * Color;
   } else {
-    FragColor = u_color;
+    FragColor = Color;
   }
 }
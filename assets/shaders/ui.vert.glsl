@@ -1,15 +1,30 @@
 #version 450 core
 layout(location = 0) in vec2 aPos;
 layout(location = 1) in vec2 aTexCoords;
+layout(location = 2) in vec4 aColor;
+layout(location = 3) in float aTextured;
 
 out vec2 TexCoords;
+out vec4 Color;
+flat out float Textured;
 
-uniform mat4 u_projection;
-uniform mat4 u_model;
-uniform vec2 u_uv_min = vec2(0.0, 0.0);
-uniform vec2 u_uv_max = vec2(1.0, 1.0);
+// Per-frame data, uploaded once by FrameUniformBuffer (binding 0)
+layout(std140, binding = 0) uniform FrameData {
+  mat4 u_view;
+  mat4 u_projection;
+  mat4 u_viewProjection;
+  mat4 u_hudProjection;
+  mat4 u_screenProjection;
+  vec4 u_cameraPos;
+  float u_time;
+};
+
+uniform bool u_hud; // borders around the 3D previews share their space
 
 void main() {
-  TexCoords = u_uv_min + aTexCoords * (u_uv_max - u_uv_min);
-  gl_Position = u_projection * u_model * vec4(aPos, 0.0, 1.0);
+  TexCoords = aTexCoords;
+  Color = aColor;
+  Textured = aTextured;
+  mat4 projection = u_hud ? u_hudProjection : u_screenProjection;
+  gl_Position = projection * vec4(aPos, 0.0, 1.0);
 }
@@ -3,6 +3,7 @@
 
 #include "glm/fwd.hpp"
 #include <cmath>
+#include <cstdint>
 #include <glad/gl.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -19,12 +20,13 @@ const float ZOOM = 45.0f;
 class Camera {
 public:
   // Camera Attributes
-  glm::vec3 Position;
   float MovementSpeed;
   float MouseSensitivity;
   float Zoom;
 
 private:
+  glm::vec3 m_position;
+
   // Euler Angles
   float m_yaw;
   float m_pitch;
@@ -38,6 +40,16 @@ private:
   float m_sceneWidth = 800.0f;
   float m_sceneHeight = 600.0f;
 
+  // Matrices are rebuilt lazily, only after something they depend on
+  // changed (see the setters below)
+  mutable glm::mat4 m_view{1.0f};
+  mutable glm::mat4 m_projection{1.0f};
+  mutable glm::mat4 m_viewProjection{1.0f};
+  mutable bool m_viewDirty = true;
+  mutable bool m_projectionDirty = true;
+  // Bumped on every change, lets consumers skip re-uploading matrices
+  uint64_t m_revision = 0;
+
 public:
   // Constructor with vectors
   Camera(glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f),
@@ -46,7 +58,7 @@ public:
       : m_front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED),
         MouseSensitivity(SENSITIVITY), Zoom(ZOOM), m_yaw(yaw), m_pitch(pitch),
         m_worldUp(up) {
-    Position = position;
+    m_position = position;
     updateCameraVectors();
   }
 
@@ -55,20 +67,29 @@ public:
          float yaw, float pitch)
       : m_front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED),
         MouseSensitivity(SENSITIVITY), Zoom(ZOOM), m_yaw(yaw), m_pitch(pitch) {
-    Position = glm::vec3(posX, posY, posZ);
+    m_position = glm::vec3(posX, posY, posZ);
     m_worldUp = glm::vec3(upX, upY, upZ);
     updateCameraVectors();
   }
 
   // Matrix Getters
-  glm::mat4 GetViewMatrix() const {
-    return glm::lookAt(Position, Position + m_front, m_up);
+  const glm::mat4 &GetViewMatrix() const {
+    _updateMatrices();
+    return m_view;
   }
 
-  glm::mat4 GetProjectionMatrix() const {
-    return glm::perspective(glm::radians(Zoom), GetAspect(), 0.1f, 100.0f);
+  const glm::mat4 &GetProjectionMatrix() const {
+    _updateMatrices();
+    return m_projection;
   }
 
+  const glm::mat4 &GetViewProjectionMatrix() const {
+    _updateMatrices();
+    return m_viewProjection;
+  }
+
+  uint64_t GetRevision() const { return m_revision; }
+
   float GetAspect() const {
     return (m_sceneHeight > 0) ? (m_sceneWidth / m_sceneHeight) : 1.0f;
   }
@@ -77,13 +98,15 @@ public:
   void ProcessKeyboard(Camera_Movement direction, float deltaTime) {
     float velocity = MovementSpeed * deltaTime;
     if (direction == FORWARD)
-      Position += m_front * velocity;
+      m_position += m_front * velocity;
     if (direction == BACKWARD)
-      Position -= m_front * velocity;
+      m_position -= m_front * velocity;
     if (direction == LEFT)
-      Position -= m_right * velocity;
+      m_position -= m_right * velocity;
     if (direction == RIGHT)
-      Position += m_right * velocity;
+      m_position += m_right * velocity;
+
+    _markViewDirty();
   }
 
   void ProcessMouseMovement(float xoffset, float yoffset,
@@ -110,10 +133,15 @@ public:
       Zoom = 1.0f;
     if (Zoom > 45.0f)
       Zoom = 45.0f;
+
+    _markProjectionDirty();
   }
 
   // Setters & Getters
   void SetYaw(float yaw, bool update_camera_vectors = true) {
+    if (yaw == m_yaw)
+      return;
+
     m_yaw = yaw;
 
     if (update_camera_vectors)
@@ -121,16 +149,25 @@ public:
   }
 
   void SetPitch(float pitch, bool update_camera_vectors = true) {
+    pitch = glm::clamp(pitch, -89.0f, 89.0f);
+    if (pitch == m_pitch)
+      return;
+
     m_pitch = pitch;
-    if (m_pitch > 89.0f)
-      m_pitch = 89.0f;
-    if (m_pitch < -89.0f)
-      m_pitch = -89.0f;
 
     if (update_camera_vectors)
       updateCameraVectors();
   }
 
+  void SetPosition(glm::vec3 position) {
+    if (position == m_position)
+      return;
+
+    m_position = position;
+    _markViewDirty();
+  }
+
+  glm::vec3 GetPosition() const { return m_position; }
   float GetYaw() const { return m_yaw; }
   float GetPitch() const { return m_pitch; }
 
@@ -140,6 +177,7 @@ public:
   void UpdateSceneSize(float width, float height) {
     m_sceneWidth = width;
     m_sceneHeight = height;
+    _markProjectionDirty();
   }
 
 private:
@@ -153,6 +191,32 @@ private:
     m_front = glm::normalize(front);
     m_right = glm::normalize(glm::cross(m_front, m_worldUp));
     m_up = glm::normalize(glm::cross(m_right, m_front));
+    _markViewDirty();
+  }
+
+  void _markViewDirty() {
+    m_viewDirty = true;
+    m_revision++;
+  }
+
+  void _markProjectionDirty() {
+    m_projectionDirty = true;
+    m_revision++;
+  }
+
+  void _updateMatrices() const {
+    if (!m_viewDirty && !m_projectionDirty)
+      return;
+
+    if (m_viewDirty)
+      m_view = glm::lookAt(m_position, m_position + m_front, m_up);
+    if (m_projectionDirty)
+      m_projection =
+          glm::perspective(glm::radians(Zoom), GetAspect(), 0.1f, 100.0f);
+
+    m_viewProjection = m_projection * m_view;
+    m_viewDirty = false;
+    m_projectionDirty = false;
   }
 };
 
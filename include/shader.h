@@ -9,10 +9,30 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Uniform location resolved once after linking. The value type is part of
+// the handle so Shader::set() picks the matching glProgramUniform call
+// without a name lookup. A location of -1 (optimized out) is a no-op.
+template <typename T> struct Uniform {
+  GLint location = -1;
+
+  bool isValid() const { return location >= 0; }
+};
 
 class Shader {
 public:
-  unsigned int ID;
+  // One entry per active uniform, filled by reflection at link time
+  struct UniformInfo {
+    std::string name;
+    GLenum type;
+    GLint size;
+    GLint location;
+  };
+
+  unsigned int ID = 0;
   // constructor generates the shader on the fly
   // ------------------------------------------------------------------------
   Shader(const char *vertexPath, const char *fragmentPath,
@@ -54,6 +74,107 @@ public:
       std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what()
                 << std::endl;
     }
+    compile(vertexCode, fragmentCode,
+            geometryPath != nullptr ? &geometryCode : nullptr);
+  }
+
+  // build from source already in memory
+  // ------------------------------------------------------------------------
+  static Shader fromSource(const std::string &vertexCode,
+                           const std::string &fragmentCode) {
+    Shader shader;
+    shader.compile(vertexCode, fragmentCode, nullptr);
+    return shader;
+  }
+  // take ownership of an already linked program (e.g. one restored with
+  // glProgramBinary)
+  // ------------------------------------------------------------------------
+  static Shader fromProgram(GLuint program) {
+    Shader shader;
+    shader.ID = program;
+    shader.reflectUniforms();
+    return shader;
+  }
+
+  ~Shader() { glDeleteProgram(ID); }
+  Shader(const Shader &) = delete;
+  Shader &operator=(const Shader &) = delete;
+  Shader(Shader &&other) noexcept
+      : ID(other.ID), m_uniforms(std::move(other.m_uniforms)) {
+    other.ID = 0;
+  }
+
+  // activate the shader
+  // ------------------------------------------------------------------------
+  void use() const { glUseProgram(ID); }
+  // uniform handles
+  // ------------------------------------------------------------------------
+  // Resolve once (at load time) and keep the handle; this walks the
+  // reflected table and is not meant for the per-draw path.
+  template <typename T> Uniform<T> uniform(std::string_view name) const {
+    for (const UniformInfo &info : m_uniforms) {
+      if (info.name != name)
+        continue;
+
+      if (!matchesType<T>(info.type)) {
+        std::cout << "WARNING::SHADER::UNIFORM_TYPE_MISMATCH: " << name
+                  << std::endl;
+      }
+      return {info.location};
+    }
+
+    return {};
+  }
+
+  const std::vector<UniformInfo> &getUniforms() const { return m_uniforms; }
+
+  // utility uniform functions
+  // ------------------------------------------------------------------------
+  void set(Uniform<bool> u, bool value) const {
+    glProgramUniform1i(ID, u.location, (int)value);
+  }
+  // ------------------------------------------------------------------------
+  void set(Uniform<int> u, int value) const {
+    glProgramUniform1i(ID, u.location, value);
+  }
+  // ------------------------------------------------------------------------
+  void set(Uniform<float> u, float value) const {
+    glProgramUniform1f(ID, u.location, value);
+  }
+  // ------------------------------------------------------------------------
+  void set(Uniform<glm::vec2> u, const glm::vec2 &value) const {
+    glProgramUniform2fv(ID, u.location, 1, &value[0]);
+  }
+  // ------------------------------------------------------------------------
+  void set(Uniform<glm::vec3> u, const glm::vec3 &value) const {
+    glProgramUniform3fv(ID, u.location, 1, &value[0]);
+  }
+  // ------------------------------------------------------------------------
+  void set(Uniform<glm::vec4> u, const glm::vec4 &value) const {
+    glProgramUniform4fv(ID, u.location, 1, &value[0]);
+  }
+  // ------------------------------------------------------------------------
+  void set(Uniform<glm::mat2> u, const glm::mat2 &mat) const {
+    glProgramUniformMatrix2fv(ID, u.location, 1, GL_FALSE, &mat[0][0]);
+  }
+  // ------------------------------------------------------------------------
+  void set(Uniform<glm::mat3> u, const glm::mat3 &mat) const {
+    glProgramUniformMatrix3fv(ID, u.location, 1, GL_FALSE, &mat[0][0]);
+  }
+  // ------------------------------------------------------------------------
+  void set(Uniform<glm::mat4> u, const glm::mat4 &mat) const {
+    glProgramUniformMatrix4fv(ID, u.location, 1, GL_FALSE, &mat[0][0]);
+  }
+
+private:
+  std::vector<UniformInfo> m_uniforms;
+
+  Shader() = default;
+
+  // compile and link the given stages into ID
+  // ------------------------------------------------------------------------
+  void compile(const std::string &vertexCode, const std::string &fragmentCode,
+               const std::string *geometryCode) {
     const char *vShaderCode = vertexCode.c_str();
     const char *fShaderCode = fragmentCode.c_str();
     // 2. compile shaders
@@ -70,8 +191,8 @@ public:
     checkCompileErrors(fragment, "FRAGMENT");
     // if geometry shader is given, compile geometry shader
     unsigned int geometry;
-    if (geometryPath != nullptr) {
-      const char *gShaderCode = geometryCode.c_str();
+    if (geometryCode != nullptr) {
+      const char *gShaderCode = geometryCode->c_str();
       geometry = glCreateShader(GL_GEOMETRY_SHADER);
       glShaderSource(geometry, 1, &gShaderCode, NULL);
       glCompileShader(geometry);
@@ -79,79 +200,80 @@ public:
     }
     // shader Program
     ID = glCreateProgram();
+    // allow the linked program to be saved with glGetProgramBinary
+    glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glAttachShader(ID, vertex);
     glAttachShader(ID, fragment);
-    if (geometryPath != nullptr)
+    if (geometryCode != nullptr)
       glAttachShader(ID, geometry);
     glLinkProgram(ID);
     checkCompileErrors(ID, "PROGRAM");
+    reflectUniforms();
     // delete the shaders as they're linked into our program now and no longer
     // necessary
     glDeleteShader(vertex);
     glDeleteShader(fragment);
-    if (geometryPath != nullptr)
+    if (geometryCode != nullptr)
       glDeleteShader(geometry);
   }
 
-  ~Shader() { glDeleteShader(ID); }
-  Shader(const Shader &) = delete;
-  Shader &operator=(const Shader &) = delete;
-  Shader(Shader &&other) noexcept : ID(other.ID) { other.ID = 0; }
-
-  // activate the shader
-  // ------------------------------------------------------------------------
-  void use() const { glUseProgram(ID); }
-  // utility uniform functions
-  // ------------------------------------------------------------------------
-  void setBool(const std::string &name, bool value) const {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
-  }
-  // ------------------------------------------------------------------------
-  void setInt(const std::string &name, int value) const {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
-  }
-  // ------------------------------------------------------------------------
-  void setFloat(const std::string &name, float value) const {
-    glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
-  }
+  // enumerate active uniforms into a flat table
   // ------------------------------------------------------------------------
-  void setVec2(const std::string &name, const glm::vec2 &value) const {
-    glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
-  }
-  void setVec2(const std::string &name, float x, float y) const {
-    glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
-  }
-  // ------------------------------------------------------------------------
-  void setVec3(const std::string &name, const glm::vec3 &value) const {
-    glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
-  }
-  void setVec3(const std::string &name, float x, float y, float z) const {
-    glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
-  }
-  // ------------------------------------------------------------------------
-  void setVec4(const std::string &name, const glm::vec4 &value) const {
-    glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
-  }
-  void setVec4(const std::string &name, float x, float y, float z, float w) {
-    glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
-  }
-  // ------------------------------------------------------------------------
-  void setMat2(const std::string &name, const glm::mat2 &mat) const {
-    glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE,
-                       &mat[0][0]);
-  }
-  // ------------------------------------------------------------------------
-  void setMat3(const std::string &name, const glm::mat3 &mat) const {
-    glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE,
-                       &mat[0][0]);
+  void reflectUniforms() {
+    GLint count = 0;
+    GLint max_length = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+
+    std::string name(max_length, '\0');
+    m_uniforms.clear();
+    m_uniforms.reserve(count);
+
+    for (GLint i = 0; i < count; ++i) {
+      GLsizei length = 0;
+      GLint size = 0;
+      GLenum type = 0;
+      glGetActiveUniform(ID, i, max_length, &length, &size, &type,
+                         name.data());
+
+      std::string_view view(name.data(), length);
+      // arrays are reported as "name[0]"
+      if (view.ends_with("[0]"))
+        view.remove_suffix(3);
+
+      GLint location = glGetUniformLocation(ID, name.c_str());
+      // uniforms inside blocks have no location of their own
+      if (location < 0)
+        continue;
+
+      m_uniforms.push_back({std::string(view), type, size, location});
+    }
   }
-  // ------------------------------------------------------------------------
-  void setMat4(const std::string &name, const glm::mat4 &mat) const {
-    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE,
-                       &mat[0][0]);
+
+  template <typename T> static bool matchesType(GLenum type) {
+    if constexpr (std::is_same_v<T, bool>)
+      return type == GL_BOOL;
+    else if constexpr (std::is_same_v<T, int>)
+      return type == GL_INT || type == GL_SAMPLER_2D ||
+             type == GL_SAMPLER_2D_ARRAY;
+    else if constexpr (std::is_same_v<T, float>)
+      return type == GL_FLOAT;
+    else if constexpr (std::is_same_v<T, glm::vec2>)
+      return type == GL_FLOAT_VEC2;
+    else if constexpr (std::is_same_v<T, glm::vec3>)
+      return type == GL_FLOAT_VEC3;
+    else if constexpr (std::is_same_v<T, glm::vec4>)
+      return type == GL_FLOAT_VEC4;
+    else if constexpr (std::is_same_v<T, glm::mat2>)
+      return type == GL_FLOAT_MAT2;
+    else if constexpr (std::is_same_v<T, glm::mat3>)
+      return type == GL_FLOAT_MAT3;
+    else if constexpr (std::is_same_v<T, glm::mat4>)
+      return type == GL_FLOAT_MAT4;
+    else
+      return false;
   }
 
-private:
   // utility function for checking shader compilation/linking errors.
   // ------------------------------------------------------------------------
   void checkCompileErrors(GLuint shader, std::string type) {
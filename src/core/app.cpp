@@ -1,7 +1,11 @@
 #include "core/app.hpp"
 #include "GLFW/glfw3.h"
+#include "core/asset_archive.hpp"
 #include "core/camera_controller.hpp"
+#include "core/gl_state.hpp"
 #include "core/shader_manager.hpp"
+#include "core/texture_manager.hpp"
+#include "core/trace.hpp"
 #include "game/space.hpp"
 #include "game/tetris_manager.hpp"
 #include "game/tetromino.hpp"
@@ -9,164 +13,367 @@
 #include "glm/fwd.hpp"
 #include "ui/ui_manager.hpp"
 
-void App::render(double delta_time) {
+#include <cmath>
+#include <format>
+#include <print>
+#include <span>
 
-  _handleProcessInput(delta_time);
-  m_camera_controller.Update(delta_time);
-
-  if (m_appState.gameStarted) {
-    m_game.update(delta_time);
-  }
+bool App::needsFrame() {
+  if (m_game.acquireFrame().revision != m_drawnRevision)
+    m_scheduler.invalidate(FrameScheduler::GAME_STATE);
+  return m_scheduler.shouldRender(glfwGetTime());
+}
 
-  _updateUIElements();
+void App::waitForChanges() {
+  m_scheduler.wait(glfwGetTime());
+  // An idle gap is not a frame interval
+  m_pacer.reset();
+}
 
-  m_game.render(delta_time, m_camera);
+void App::present() {
+  if (m_capture) {
+    m_capture->endFrame();
+    return;
+  }
+  m_pacer.present(m_window);
+}
 
-  const Shader &tetromino_shader =
-      ShaderManager::getShader(ShaderType::TETROMINO);
-  const Shader &ui_shader = ShaderManager::getShader(ShaderType::UI);
+void App::render(double delta_time) {
+  TRACE_SCOPE("App::render");
+  m_scheduler.beginFrame(glfwGetTime());
 
-  m_gameUIRenderer.renderHoldPiece(
-      m_game.getHold().transform(&Tetromino::getType).value_or(BlockType::None),
-      {5.0f, 10.0f, 0.0f}, tetromino_shader, ui_shader, 1.2f);
-  m_gameUIRenderer.renderPieceQueue(m_game.getPiecesQueue(),
-                                    {5.0f, 30.0f, 0.0f}, 5.0f, tetromino_shader,
-                                    ui_shader);
+  _handleProcessInput(delta_time);
+  m_camera_controller.Update(delta_time);
+  if (m_camera_controller.IsMoving())
+    m_scheduler.invalidate(FrameScheduler::CAMERA);
+
+  m_stream.beginFrame();
+  m_gpuProfiler.beginFrame();
+  m_textureLoader.update();
+  m_font.update();
+  m_frameUniforms.update(m_camera, static_cast<float>(glfwGetTime()));
+
+  // The frame time is a fixed virtual step here, so every frame runs the
+  // same number of ticks
+  if (m_capture)
+    m_game.step(
+        static_cast<int>(std::lround(delta_time * GameThread::TICK_RATE)));
+  const GameFrame &frame = m_game.acquireFrame();
+  m_appState.gameStarted = frame.started;
+  m_drawnRevision = frame.revision;
+
+  _updateUIElements(frame);
+  if (m_capture) {
+    // Captures must not depend on how many glyphs fit in the budget
+    m_uiManager.layoutText();
+    m_font.flush();
+  }
 
+  m_renderer.render(frame.board, m_camera);
+  m_gameUIRenderer.renderHoldPiece(frame.board.heldType, {5.0f, 10.0f, 0.0f},
+                                   1.2f);
+  m_gameUIRenderer.renderPieceQueue(
+      std::span(frame.board.queue.data(), frame.board.queueCount),
+      {5.0f, 30.0f, 0.0f}, 5.0f);
   m_uiManager.render(m_appState.windowWidth, m_appState.windowHeight);
+
+  m_renderQueue.execute();
+
+  // What has to keep drawing after this frame
+  if (m_textureLoader.getPendingCount() > 0 || m_font.isLoading() ||
+      m_renderer.isMeshing())
+    m_scheduler.invalidate(FrameScheduler::LOADING);
+  if (!m_appState.gameStarted || frame.board.queueCount > 0 ||
+      frame.board.heldType != BlockType::None)
+    m_scheduler.requestAnimation(ANIMATION_FPS);
+  if (m_appState.showGpuStats)
+    m_scheduler.invalidate(FrameScheduler::PROFILING);
+
+  m_gpuProfiler.endFrame();
+  m_stream.endFrame();
+  GLState::endFrame();
 }
 
-App::App(GLFWwindow *window)
-    : m_window(window), m_camera(glm::vec3(0.0f, 10.0f, 30.0f)),
-      m_camera_controller(m_camera),
-      m_gameUIRenderer(m_game.getVAO(), m_uiManager.getVAO(), m_camera) {
+App::App(GLFWwindow *window, const LaunchOptions &options)
+    : m_window(window), m_pacer(options.pacing),
+      m_camera(glm::vec3(0.0f, 10.0f, 30.0f)),
+      m_camera_controller(m_camera), m_frameUniforms(m_stream),
+      m_renderQueue(m_gpuProfiler), m_textureLoader(m_stream),
+      m_gpuProfilePath(options.gpuProfilePath),
+      m_tracePath(options.tracePath), m_game(options),
+      m_renderer(m_stream, m_renderQueue), m_uiManager(m_stream, m_renderQueue),
+      m_gameUIRenderer(m_renderer.getVAO(), m_stream, m_renderQueue) {
 
   glfwSetWindowUserPointer(m_window, (void *)this);
 
+  TRACE_THREAD_NAME("render");
+  if (m_tracePath)
+    trace::setEnabled(true);
+
   glfwSetKeyCallback(m_window, _glfwKeyCallback);
   glfwSetCursorPosCallback(m_window, _glfwMouseMoveCallback);
   glfwSetMouseButtonCallback(m_window, _glfwMouseButtonCallback);
   glfwSetScrollCallback(m_window, _glfwScrollCallback);
   glfwSetFramebufferSizeCallback(m_window, _glfwFramebufferSizeCallback);
+  glfwSetWindowRefreshCallback(m_window, _glfwWindowRefreshCallback);
 
-  _setupResources();
+  // Without a packed archive assets are read loose from ASSETS_PATH
+  AssetManager::mount(options.assetArchivePath, ASSETS_PATH);
+  _setupResources(options);
   _setupUIElements();
 
   int width, height;
-  glfwGetWindowSize(m_window, &width, &height);
-
-  m_camera.UpdateSceneSize(width, height);
+  glfwGetFramebufferSize(m_window, &width, &height);
+  if (options.headless) {
+    m_capture = std::make_unique<FrameCapture>(*options.headless);
+    width = m_capture->getWidth();
+    height = m_capture->getHeight();
+    m_renderer.setWaitForMesh(true);
+  }
+  // No resize event is guaranteed before the first frame (and a hidden
+  // window never gets one), so size the viewport, UI and camera up front
+  _handleFramebufferSizeCallback(width, height);
   m_camera_controller.SetPreset(CameraPreset::FRONT);
+
+  m_scheduler.setIdleEnabled(options.idleRendering);
+  // A static board stops the render loop; new game states wake it
+  m_game.setChangeCallback(glfwPostEmptyEvent);
+  m_game.start();
 }
 
-App::~App() = default;
+App::~App() {
+  m_game.stop();
 
-void App::_setupResources() {
-  ShaderManager::loadShader(ShaderType::UI, UI_VERTEX_SHADER_PATH,
-                            UI_FRAGMENT_SHADER_PATH);
-  ShaderManager::loadShader(ShaderType::TETROMINO, TETROMINO_VERTEX_SHADER_PATH,
-                            TETROMINO_FRAGMENT_SHADER_PATH);
+  if (m_gpuProfilePath)
+    _dumpGpuProfile();
+  if (m_tracePath)
+    _dumpTrace();
 
-  m_font.loadDefaultFont();
+  // The managers are static; release their textures while GL is alive
+  TextureManager::clear();
+}
+
+void App::_setupResources(const LaunchOptions &options) {
+  ShaderManager::setCacheDirectory(options.cachePath);
+  ShaderManager::loadShader(ShaderType::UI, UI_VERTEX_SHADER_ASSET,
+                            UI_FRAGMENT_SHADER_ASSET);
+  ShaderManager::loadShader(ShaderType::TETROMINO,
+                            TETROMINO_VERTEX_SHADER_ASSET,
+                            TETROMINO_FRAGMENT_SHADER_ASSET);
+
+  if (!m_font.loadFont(AssetManager::load(FONT_ASSET), options.cachePath))
+    m_font.loadDefaultFont(options.cachePath);
+
+  // All text goes through --font or a packed TrueType font. Otherwise the
+  // bitmap font draws ASCII and a system font, if any, the rest. Headless
+  // runs keep to the bitmap font unless given --font, so captures look the
+  // same on every machine.
+  if (!options.fontPath.empty()) {
+    m_font.loadTrueType(options.fontPath);
+  } else if (options.headless) {
+    std::println("Headless: text uses the bitmap font (--font to change)");
+  } else if (AssetManager::contains(TRUETYPE_FONT_ASSET)) {
+    m_font.loadTrueType(AssetManager::load(TRUETYPE_FONT_ASSET));
+  } else {
+    for (const char *path : SYSTEM_FONTS) {
+      if (m_font.loadFallbackFont(path))
+        break;
+    }
+  }
 }
 
 void App::_setupUIElements() {
   // Virtual coordinates: Y is 0 to 40.
-  m_uiManager.addTextElement("next_label", {3.0f, 4.0f, 0, 0}, "NEXT", m_font,
+  m_uiManager.addTextElement({3.0f, 4.0f, 0, 0}, "NEXT", m_font,
                              glm::vec4(1.0f), 0.125f);
 
-  m_uiManager.addInteractiveElement("hold_btn", {2.0f, 24.0f, 6.0f, 2.0f},
-                                    glm::vec4(0.0f),
-                                    [this]() { this->m_game.hold(); });
+  m_uiManager.addInteractiveElement(
+      {2.0f, 24.0f, 6.0f, 2.0f}, glm::vec4(0.0f),
+      [this]() { this->_sendInput(FrameInput::HOLD); });
 
-  m_uiManager.addTextElement("hold_label", {3.0f, 24.5f, 0, 0}, "HOLD", m_font,
+  m_uiManager.addTextElement({3.0f, 24.5f, 0, 0}, "HOLD", m_font,
                              glm::vec4(1.0f), 0.125f);
 
   // Score UI
-  m_uiManager.addTextElement("score_label", {3.0f, 32.0f, 0, 0}, "SCORE",
-                             m_font, glm::vec4(1.0f, 0.8f, 0.0f, 1.0f), 0.1f);
-  m_uiManager.addTextElement("score_value", {3.0f, 34.0f, 0, 0}, "0", m_font,
-                             glm::vec4(1.0f), 0.15f);
+  m_hud.scoreLabel =
+      m_uiManager.addTextElement({3.0f, 32.0f, 0, 0}, "SCORE", m_font,
+                                 glm::vec4(1.0f, 0.8f, 0.0f, 1.0f), 0.1f);
+  m_hud.scoreValue = m_uiManager.addTextElement({3.0f, 34.0f, 0, 0}, "",
+                                                m_font, glm::vec4(1.0f), 0.15f);
+  m_uiManager.bindText(m_hud.scoreValue, m_hudModel.score, "{}");
 
   // Level UI
-  m_uiManager.addTextElement("level_label", {3.0f, 36.5f, 0, 0}, "LEVEL",
-                             m_font, glm::vec4(0.0f, 0.8f, 1.0f, 1.0f), 0.1f);
-  m_uiManager.addTextElement("level_value", {3.0f, 38.5f, 0, 0}, "0", m_font,
-                             glm::vec4(1.0f), 0.15f);
+  m_hud.levelLabel =
+      m_uiManager.addTextElement({3.0f, 36.5f, 0, 0}, "LEVEL", m_font,
+                                 glm::vec4(0.0f, 0.8f, 1.0f, 1.0f), 0.1f);
+  m_hud.levelValue = m_uiManager.addTextElement({3.0f, 38.5f, 0, 0}, "",
+                                                m_font, glm::vec4(1.0f), 0.15f);
+  m_uiManager.bindText(m_hud.levelValue, m_hudModel.level, "{}");
+
+  // Opponent UI
+  if (m_game.isOnline()) {
+    m_hud.opponentLabel =
+        m_uiManager.addTextElement({3.0f, 36.5f, 0, 0}, "RIVAL", m_font,
+                                   glm::vec4(1.0f, 0.4f, 0.4f, 1.0f), 0.1f);
+    m_hud.opponentValue = m_uiManager.addTextElement(
+        {3.0f, 38.5f, 0, 0}, "", m_font, glm::vec4(1.0f), 0.15f);
+    m_uiManager.bindText(m_hud.opponentValue, m_hudModel.opponentScore, "{}");
+  }
 
   // Start Screen
-  m_uiManager.addInteractiveElement(
-      "darken_screen", {0.0f, 0.0f, 100, 40.0f}, {0.0f, 0.0f, 0.0f, 0.7f},
-      [this]() { this->m_appState.gameStarted = true; });
-
-  m_uiManager.addTextElement("start_message", {0.0f, 20.5f, 0, 0},
-                             "press any key to start!", m_font, glm::vec4(1.0f),
-                             0.15f);
+  m_hud.darkenScreen = m_uiManager.addInteractiveElement(
+      {0.0f, 0.0f, 100, 40.0f}, {0.0f, 0.0f, 0.0f, 0.7f},
+      [this]() { this->m_game.requestStart(); });
+
+  m_hud.startMessage = m_uiManager.addTextElement(
+      {0.0f, 20.5f, 0, 0}, "press any key to start!", m_font, glm::vec4(1.0f),
+      0.15f);
+
+  m_hudModel.started.subscribe([this](bool started) {
+    if (auto darken_screen = m_uiManager.get(m_hud.darkenScreen))
+      darken_screen->visible = !started;
+    if (auto start_message = m_uiManager.get(m_hud.startMessage))
+      start_message->visible = !started;
+  });
+
+  // GPU pass timings and state-change counts (F3), one line per pass
+  m_hud.glStateStats = m_uiManager.addTextElement(
+      {0, 0, 0, 0}, "", m_font, glm::vec4(0.6f, 1.0f, 0.6f, 1.0f), 0.08f);
+  m_hud.framePacing = m_uiManager.addTextElement(
+      {0, 0, 0, 0}, "", m_font, glm::vec4(0.6f, 1.0f, 0.6f, 1.0f), 0.08f);
+  for (TextHandle &line : m_hud.gpuPasses) {
+    line = m_uiManager.addTextElement({0, 0, 0, 0}, "", m_font,
+                                      glm::vec4(0.6f, 1.0f, 0.6f, 1.0f),
+                                      0.08f);
+  }
 }
 
-void App::_updateUIElements() {
-  // Update UI text and positions
+void App::_updateUIElements(const GameFrame &frame) {
+  // Bound text is reformatted only when a value actually changes
+  bool changed = m_hudModel.level.set(frame.board.level);
+  changed |= m_hudModel.score.set(frame.board.score);
+  changed |= m_hudModel.opponentScore.set(frame.opponentScore.value_or(0));
+  m_hudModel.started.set(frame.started);
+
   float vWidth = m_uiManager.getVirtualWidth();
-  float rightMargin = 2.0f;
+  if (changed || vWidth != m_hud.layoutWidth)
+    _layoutHud(vWidth);
 
-  if (auto level_label =
-          dynamic_cast<TextElement *>(m_uiManager.getElement("level_label"))) {
-    float w = m_font.getTextWidth(level_label->text, level_label->scale);
-    level_label->bounds.x = vWidth - rightMargin - w;
-    level_label->bounds.y = 1.5f;
+  if (auto start_message = m_uiManager.get(m_hud.startMessage);
+      start_message && start_message->visible) {
+    start_message->color.a =
+        0.3f + 0.7f * (0.5f * (std::cos(glfwGetTime() * 2.0) + 1.0f));
   }
 
-  if (auto level_value =
-          dynamic_cast<TextElement *>(m_uiManager.getElement("level_value"))) {
-    level_value->text = std::to_string(m_game.getLevel());
-    float w = m_font.getTextWidth(level_value->text, level_value->scale);
-    level_value->bounds.x = vWidth - rightMargin - w;
-    level_value->bounds.y = 3.5f;
-  }
+  _updateGpuStats();
+}
 
-  if (auto score_label =
-          dynamic_cast<TextElement *>(m_uiManager.getElement("score_label"))) {
-    float w = m_font.getTextWidth(score_label->text, score_label->scale);
-    score_label->bounds.x = vWidth - rightMargin - w;
-    score_label->bounds.y = 6.0f;
-  }
+void App::_layoutHud(float vWidth) {
+  m_hud.layoutWidth = vWidth;
+  float rightMargin = 2.0f;
 
-  if (auto score_value =
-          dynamic_cast<TextElement *>(m_uiManager.getElement("score_value"))) {
-    score_value->text = std::to_string(m_game.getScore());
-    float w = m_font.getTextWidth(score_value->text, score_value->scale);
-    score_value->bounds.x = vWidth - rightMargin - w;
-    score_value->bounds.y = 7.5f;
-  }
+  auto alignRight = [&](TextHandle handle, float y) {
+    if (TextElement *text = m_uiManager.get(handle)) {
+      text->bounds.x = vWidth - rightMargin - text->getWidth();
+      text->bounds.y = y;
+    }
+  };
+
+  alignRight(m_hud.levelLabel, 1.5f);
+  alignRight(m_hud.levelValue, 3.5f);
+  alignRight(m_hud.scoreLabel, 6.0f);
+  alignRight(m_hud.scoreValue, 7.5f);
+  alignRight(m_hud.opponentLabel, 10.0f);
+  alignRight(m_hud.opponentValue, 11.5f);
 
-  if (auto darken_screen = dynamic_cast<InteractiveElement *>(
-          m_uiManager.getElement("darken_screen"))) {
+  if (auto darken_screen = m_uiManager.get(m_hud.darkenScreen))
     darken_screen->bounds.w = vWidth;
-    darken_screen->visible = !m_appState.gameStarted;
-  }
 
-  if (auto start_message = dynamic_cast<TextElement *>(
-          m_uiManager.getElement("start_message"))) {
-    float w = m_font.getTextWidth(start_message->text, start_message->scale);
+  if (auto start_message = m_uiManager.get(m_hud.startMessage)) {
+    float w = start_message->getWidth();
     start_message->bounds.x = (vWidth - rightMargin - w) / 2;
     start_message->bounds.y = 20.0f;
-    start_message->color.a =
-        0.3f + 0.7f * (0.5f * (std::cos(glfwGetTime() * 2.0) + 1.0f));
-    start_message->visible = !m_appState.gameStarted;
   }
 }
 
+void App::_updateGpuStats() {
+  std::span<const GpuProfiler::PassStats> passes = m_gpuProfiler.getPasses();
+  float vWidth = m_uiManager.getVirtualWidth();
+  float rightMargin = 2.0f;
+
+  for (uint32_t i = 0; i < GpuProfiler::MAX_PASSES; ++i) {
+    TextElement *line = m_uiManager.get(m_hud.gpuPasses[i]);
+    if (!line)
+      continue;
+
+    line->visible = m_appState.showGpuStats && i < passes.size();
+    if (!line->visible)
+      continue;
+
+    const GpuProfiler::PassStats &pass = passes[i];
+    line->setText(formatInline("{} {:.3f}ms (max {:.3f})", pass.name,
+                               pass.averageMs, pass.maxMs)
+                      .view());
+    float w = line->getWidth();
+    line->bounds.x = vWidth - rightMargin - w;
+    line->bounds.y = 14.0f + 1.2f * i;
+  }
+
+  if (auto pacing_line = m_uiManager.get(m_hud.framePacing)) {
+    pacing_line->visible = m_appState.showGpuStats;
+    if (pacing_line->visible) {
+      FramePacer::Stats pacing = m_pacer.getStats();
+      pacing_line->setText(
+          formatInline("frame {:.2f}ms sd {:.2f} err {:.2f} (max {:.2f}) "
+                       "target {:.2f}",
+                       pacing.meanMs, pacing.stdDevMs, pacing.meanErrorMs,
+                       pacing.maxErrorMs, pacing.targetMs)
+              .view());
+      float w = pacing_line->getWidth();
+      pacing_line->bounds.x = vWidth - rightMargin - w;
+      pacing_line->bounds.y = 14.0f + 1.2f * (passes.size() + 1);
+    }
+  }
+
+  if (auto state_line = m_uiManager.get(m_hud.glStateStats)) {
+    state_line->visible = m_appState.showGpuStats;
+    if (!state_line->visible)
+      return;
+
+    const GLState::Stats &stats = GLState::getFrameStats();
+    state_line->setText(
+        formatInline("gl state {} issued {} skipped, {} packets",
+                     stats.issued, stats.skipped,
+                     m_renderQueue.getLastPacketCount())
+            .view());
+    float w = state_line->getWidth();
+    state_line->bounds.x = vWidth - rightMargin - w;
+    state_line->bounds.y = 14.0f + 1.2f * passes.size();
+  }
+}
+
+void App::_dumpGpuProfile() const {
+  std::string path = m_gpuProfilePath.value_or("gpu_profile.json");
+  if (m_gpuProfiler.dumpJson(path))
+    std::println("GPU profile written to {}", path);
+}
+
+void App::_dumpTrace() const {
+  std::string path = m_tracePath.value_or("trace.json");
+  if (trace::dumpChrome(path, TRACE_DUMP_SECONDS))
+    std::println("CPU trace written to {}", path);
+}
+
 void App::_handleProcessInput(double delta_time) {
+  TRACE_SCOPE("App::input");
   // Movement
   bool left = glfwGetKey(m_window, GLFW_KEY_A) == GLFW_PRESS;
   bool right = glfwGetKey(m_window, GLFW_KEY_D) == GLFW_PRESS;
   bool up = glfwGetKey(m_window, GLFW_KEY_W) == GLFW_PRESS;
   bool down = glfwGetKey(m_window, GLFW_KEY_S) == GLFW_PRESS;
 
-  if (m_appState.gameStarted) {
-    bool softDropActive = (glfwGetKey(m_window, GLFW_KEY_SPACE) == GLFW_PRESS);
-    m_game.setSoftDrop(softDropActive);
-  }
+  bool softDropActive = (glfwGetKey(m_window, GLFW_KEY_SPACE) == GLFW_PRESS);
+  m_game.setHeldBits(softDropActive ? FrameInput::SOFT_DROP : 0);
 
   // Preset Selection
   if (glfwGetKey(m_window, GLFW_KEY_1) == GLFW_PRESS)
@@ -177,15 +384,39 @@ void App::_handleProcessInput(double delta_time) {
     m_camera_controller.SetPreset(CameraPreset::ISOMETRIC);
 
   m_camera_controller.HandleRotationInput(left, right, up, down, delta_time);
+  // Held orbit keys only show up in polling, not as events
+  if (left || right || up || down)
+    m_scheduler.invalidate(FrameScheduler::INPUT);
 }
 
 void App::_handleKeyCallback(int key, int scancode, int action, int mods) {
+  TRACE_SCOPE("App::key");
+  m_scheduler.invalidate(FrameScheduler::INPUT);
   using RelativeDir = TetrisManager::RelativeDir;
   using RelativeRotation = TetrisManager::RelativeRotation;
 
+  // Profiling keys work on the start screen too
+  if (action == GLFW_PRESS && key == GLFW_KEY_F3) {
+    m_appState.showGpuStats = !m_appState.showGpuStats;
+    return;
+  }
+  if (action == GLFW_PRESS && key == GLFW_KEY_F4) {
+    _dumpGpuProfile();
+    return;
+  }
+  if (action == GLFW_PRESS && key == GLFW_KEY_F5) {
+    trace::setEnabled(!trace::isEnabled());
+    std::println("CPU tracing {}", trace::isEnabled() ? "on" : "off");
+    return;
+  }
+  if (action == GLFW_PRESS && key == GLFW_KEY_F6) {
+    _dumpTrace();
+    return;
+  }
+
   if (action == GLFW_PRESS || action == GLFW_REPEAT) {
     if (!m_appState.gameStarted) {
-      m_appState.gameStarted = true;
+      m_game.requestStart();
       return;
     }
 
@@ -195,47 +426,67 @@ void App::_handleKeyCallback(int key, int scancode, int action, int mods) {
     switch (key) {
     case GLFW_KEY_UP:
       if (shift)
-        m_game.rotateRelative(RelativeRotation::PITCH, true, m_camera);
+        _rotateActive(RelativeRotation::PITCH, true);
       else
-        m_game.moveRelative(RelativeDir::BACK, m_camera);
+        _moveActive(RelativeDir::BACK);
       break;
 
     case GLFW_KEY_DOWN:
       if (shift)
-        m_game.rotateRelative(RelativeRotation::PITCH, false, m_camera);
+        _rotateActive(RelativeRotation::PITCH, false);
       else
-        m_game.moveRelative(RelativeDir::FORWARD, m_camera);
+        _moveActive(RelativeDir::FORWARD);
       break;
 
     case GLFW_KEY_LEFT:
       if (shift)
-        m_game.rotateRelative(RelativeRotation::ROLL, true, m_camera);
+        _rotateActive(RelativeRotation::ROLL, true);
       else if (ctrl)
-        m_game.rotateRelative(RelativeRotation::Y_AXIS, true, m_camera);
+        _rotateActive(RelativeRotation::Y_AXIS, true);
       else
-        m_game.moveRelative(RelativeDir::LEFT, m_camera);
+        _moveActive(RelativeDir::LEFT);
       break;
 
     case GLFW_KEY_RIGHT:
       if (shift)
-        m_game.rotateRelative(RelativeRotation::ROLL, false, m_camera);
+        _rotateActive(RelativeRotation::ROLL, false);
       else if (ctrl)
-        m_game.rotateRelative(RelativeRotation::Y_AXIS, false, m_camera);
+        _rotateActive(RelativeRotation::Y_AXIS, false);
       else
-        m_game.moveRelative(RelativeDir::RIGHT, m_camera);
+        _moveActive(RelativeDir::RIGHT);
       break;
 
     case GLFW_KEY_ENTER:
-      m_game.hardDrop();
+      _sendInput(FrameInput::HARD_DROP);
       break;
 
     case GLFW_KEY_H:
-      m_game.hold();
+      _sendInput(FrameInput::HOLD);
       break;
     }
   }
 }
 
+void App::_moveActive(TetrisManager::RelativeDir direction) {
+  FrameInput input;
+  input.addMove(TetrisManager::relativeMoveToGrid(direction, m_camera));
+  m_game.pushInput(input);
+}
+
+void App::_rotateActive(TetrisManager::RelativeRotation type,
+                        bool clockwise) {
+  FrameInput input;
+  input.addRotation(TetrisManager::relativeRotationToGridAxis(type, m_camera),
+                    clockwise);
+  m_game.pushInput(input);
+}
+
+void App::_sendInput(FrameInput::Bit bit) {
+  FrameInput input;
+  input.add(bit);
+  m_game.pushInput(input);
+}
+
 // internal event handler
 void App::_handleMouseMoveCallback(double pos_x, double pos_y) {
   m_appState.inputState.mouseLastX = pos_x;
@@ -243,6 +494,7 @@ void App::_handleMouseMoveCallback(double pos_x, double pos_y) {
 }
 
 void App::_handleMouseClickCallback(int button, int action, int mods) {
+  m_scheduler.invalidate(FrameScheduler::INPUT);
   if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
     m_uiManager.handleClick(m_appState.inputState.mouseLastX,
                             m_appState.inputState.mouseLastY);
@@ -262,6 +514,7 @@ void App::_handleScrollCallback(double offset_x, double offset_y) {
 }
 
 void App::_handleFramebufferSizeCallback(int width, int height) {
+  m_scheduler.invalidate(FrameScheduler::WINDOW);
   glViewport(0, 0, width, height);
   m_appState.windowWidth = width;
   m_appState.windowHeight = height;
@@ -312,3 +565,12 @@ void App::_glfwFramebufferSizeCallback(GLFWwindow *window, int width,
     app->_handleFramebufferSizeCallback(width, height);
   }
 }
+
+void App::_glfwWindowRefreshCallback(GLFWwindow *window) {
+  App *app = static_cast<App *>(glfwGetWindowUserPointer(window));
+
+  // Exposed or damaged by the window system: draw again even when idle
+  if (app) {
+    app->m_scheduler.invalidate(FrameScheduler::WINDOW);
+  }
+}
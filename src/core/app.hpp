@@ -2,22 +2,60 @@
 
 #include "camera.h"
 #include "core/camera_controller.hpp"
+#include "core/frame_capture.hpp"
+#include "core/frame_pacer.hpp"
+#include "core/frame_scheduler.hpp"
+#include "core/frame_uniforms.hpp"
+#include "core/game_thread.hpp"
+#include "core/gpu_profiler.hpp"
+#include "core/observable.hpp"
+#include "core/render_queue.hpp"
+#include "core/texture_loader.hpp"
+#include "core/stream_buffer.hpp"
+#include "game/frame_input.hpp"
 #include "game/tetris_manager.hpp"
+#include "game/tetris_renderer.hpp"
+#include "game/tetris_ui_renderer.hpp"
 #include "ui/ui_manager.hpp"
 #include <GLFW/glfw3.h>
 
-#ifndef SHADER_PATH
-#define SHADER_PATH ASSETS_PATH "/shaders"
+#include <array>
+#include <memory>
+
+#ifndef ASSETS_PATH
+#define ASSETS_PATH "./assets"
 #endif
 
-#ifndef ICONS_PATH
-#define ICONS_PATH ASSETS_PATH "/icons"
+// Asset names, relative to assets/
+#define UI_VERTEX_SHADER_ASSET "shaders/ui.vert.glsl"
+#define UI_FRAGMENT_SHADER_ASSET "shaders/ui.frag.glsl"
+#define TETROMINO_VERTEX_SHADER_ASSET "shaders/tetromino.vert.glsl"
+#define TETROMINO_FRAGMENT_SHADER_ASSET "shaders/tetromino.frag.glsl"
+#define FONT_ASSET "fonts/font8x8.bin"
+// Optional; draws all text when packed, as --font does
+#define TRUETYPE_FONT_ASSET "fonts/ui.ttf"
+
+// Without either, the first one found draws only what the bitmap font
+// lacks (code points beyond ASCII)
+inline constexpr const char *SYSTEM_FONTS[] = {
+    "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf",
+    "/usr/share/fonts/TTF/DejaVuSans.ttf",
+    "/usr/share/fonts/dejavu-sans-fonts/DejaVuSans.ttf",
+    "/System/Library/Fonts/Supplemental/Arial Unicode.ttf",
+    "C:/Windows/Fonts/arial.ttf",
+};
+
+// Startup caches: program binaries and the SDF font sheet
+#ifndef CACHE_PATH
+#define CACHE_PATH "./cache"
 #endif
 
-#define UI_VERTEX_SHADER_PATH SHADER_PATH "/ui.vert.glsl"
-#define UI_FRAGMENT_SHADER_PATH SHADER_PATH "/ui.frag.glsl"
-#define TETROMINO_VERTEX_SHADER_PATH SHADER_PATH "/tetromino.vert.glsl"
-#define TETROMINO_FRAGMENT_SHADER_PATH SHADER_PATH "/tetromino.frag.glsl"
+// Refresh rate for animations on an otherwise static screen (start screen
+// pulse, spinning preview pieces)
+#define ANIMATION_FPS 30.0
+
+// How much history a CPU trace dump covers
+#define TRACE_DUMP_SECONDS 10.0
 
 struct InputState {
   bool isFirstMouse = false;
@@ -26,32 +64,86 @@ struct InputState {
   void setMousePosition(float pos_x, float pos_y) {}
 };
 
+// Game values the HUD shows, fed from each GameFrame. Bound elements are
+// only touched when one of them changes.
+struct HudModel {
+  Observable<uint64_t> score;
+  Observable<uint8_t> level;
+  Observable<uint64_t> opponentScore;
+  Observable<bool> started;
+};
+
+// Handles to the HUD elements App updates
+struct HudElements {
+  TextHandle levelLabel, levelValue;
+  TextHandle scoreLabel, scoreValue;
+  TextHandle opponentLabel, opponentValue; // online only
+  InteractiveHandle darkenScreen;
+  TextHandle startMessage;
+  // F3 overlay, one line per GPU pass
+  TextHandle glStateStats;
+  TextHandle framePacing;
+  std::array<TextHandle, GpuProfiler::MAX_PASSES> gpuPasses;
+
+  // Virtual width the right-aligned labels were last placed for
+  float layoutWidth = 0.0f;
+};
+
 struct AppState {
   int windowWidth, windowHeight;
   InputState inputState;
   bool gameStarted = false;
+  bool showGpuStats = false;
 };
 
 class App {
 private:
   GLFWwindow *m_window;
+  FrameScheduler m_scheduler;
+  FramePacer m_pacer;
+  // Headless only: the offscreen target frames are drawn to and read from
+  std::unique_ptr<FrameCapture> m_capture;
+  uint64_t m_drawnRevision = 0; // GameFrame::revision last drawn
 
   Camera m_camera;
   CameraController m_camera_controller;
 
+  // Per-frame GPU data (uniforms, instances, UI quads) is written here
+  StreamBuffer m_stream;
+  FrameUniformBuffer m_frameUniforms;
+  GpuProfiler m_gpuProfiler;
+  // Every draw of the frame is submitted here and issued in sorted order
+  RenderQueue m_renderQueue;
+  // Icons and skins decode in the background and upload over several frames
+  TextureLoader m_textureLoader;
+  std::optional<std::string> m_gpuProfilePath;
+  std::optional<std::string> m_tracePath;
+
   AppState m_appState;
 
-  TetrisManager m_game;
+  // The simulation runs on its own thread, we only draw its snapshots
+  GameThread m_game;
+  TetrisRenderer m_renderer;
+  // Declared before the UI manager, whose bindings point into it
+  HudModel m_hudModel;
   UIManager m_uiManager;
+  HudElements m_hud;
   BitmapFont m_font;
 
   TetrisUIRenderer m_gameUIRenderer;
 
 public:
-  App(GLFWwindow *window);
+  App(GLFWwindow *window, const LaunchOptions &options = {});
   ~App();
   void render(double delta_time);
 
+  // Main loop: render only when this says so, otherwise waitForChanges()
+  bool needsFrame();
+  void waitForChanges();
+  // Swaps at the pace set by LaunchOptions::pacing; headless, reads the
+  // frame back instead
+  void present();
+
 private:
   // GLFW static callbacks adapters
   static void _glfwKeyCallback(GLFWwindow *window, int key, int scancode,
@@ -64,6 +156,7 @@ private:
                                   double offset_y);
   static void _glfwFramebufferSizeCallback(GLFWwindow *window, int width,
                                            int height);
+  static void _glfwWindowRefreshCallback(GLFWwindow *window);
   // internal event handler
   void _handleKeyCallback(int key, int scancode, int action, int mods);
   void _handleProcessInput(double delta_time);
@@ -72,7 +165,16 @@ private:
   void _handleScrollCallback(double offset_x, double offset_y);
   void _handleFramebufferSizeCallback(int width, int height);
 
-  void _setupResources();
+  // player actions, resolved against the camera and sent to the game thread
+  void _moveActive(TetrisManager::RelativeDir direction);
+  void _rotateActive(TetrisManager::RelativeRotation type, bool clockwise);
+  void _sendInput(FrameInput::Bit bit);
+
+  void _setupResources(const LaunchOptions &options);
   void _setupUIElements();
-  void _updateUIElements();
+  void _updateUIElements(const GameFrame &frame);
+  void _layoutHud(float virtual_width);
+  void _updateGpuStats();
+  void _dumpGpuProfile() const;
+  void _dumpTrace() const;
 };
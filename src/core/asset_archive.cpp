@@ -0,0 +1,197 @@
+#include "asset_archive.hpp"
+#include "core/trace.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <print>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+AssetArchive AssetManager::s_archive;
+std::filesystem::path AssetManager::s_looseRoot;
+std::map<std::string, std::vector<std::byte>, std::less<>>
+    AssetManager::s_looseFiles;
+
+AssetArchive::~AssetArchive() { close(); }
+
+bool AssetArchive::open(const std::filesystem::path &path) {
+  close();
+
+#ifdef _WIN32
+  HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return false;
+
+  LARGE_INTEGER size{};
+  HANDLE mapping = nullptr;
+  if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+    mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  void *view =
+      mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+  if (!view) {
+    if (mapping)
+      CloseHandle(mapping);
+    CloseHandle(file);
+    return false;
+  }
+
+  m_file = file;
+  m_mapping = mapping;
+  m_data = static_cast<const std::byte *>(view);
+  m_size = static_cast<size_t>(size.QuadPart);
+#else
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat info{};
+  void *view = MAP_FAILED;
+  if (fstat(fd, &info) == 0 && info.st_size > 0)
+    view = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping keeps the file alive on its own
+  ::close(fd);
+  if (view == MAP_FAILED)
+    return false;
+
+  m_data = static_cast<const std::byte *>(view);
+  m_size = static_cast<size_t>(info.st_size);
+#endif
+
+  if (!_validate()) {
+    std::println("AssetArchive: {} is not a valid archive", path.string());
+    close();
+    return false;
+  }
+
+  asset_archive::Header header;
+  std::memcpy(&header, m_data, sizeof(header));
+  // The mapping is page aligned, so the entry table is aligned too
+  m_entries = {reinterpret_cast<const asset_archive::Entry *>(
+                   m_data + sizeof(asset_archive::Header)),
+               header.entryCount};
+  return true;
+}
+
+void AssetArchive::close() {
+  if (!m_data)
+    return;
+
+#ifdef _WIN32
+  UnmapViewOfFile(m_data);
+  CloseHandle(m_mapping);
+  CloseHandle(m_file);
+  m_mapping = m_file = nullptr;
+#else
+  munmap(const_cast<std::byte *>(m_data), m_size);
+#endif
+
+  m_data = nullptr;
+  m_size = 0;
+  m_entries = {};
+}
+
+// Checked once at open, so find() can trust every offset
+bool AssetArchive::_validate() const {
+  using namespace asset_archive;
+  if (m_size < sizeof(Header))
+    return false;
+
+  Header header;
+  std::memcpy(&header, m_data, sizeof(header));
+  if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+      header.version != VERSION ||
+      header.entryCount > (m_size - sizeof(Header)) / sizeof(Entry))
+    return false;
+
+  auto *entries = reinterpret_cast<const Entry *>(m_data + sizeof(Header));
+  for (uint32_t i = 0; i < header.entryCount; ++i) {
+    const Entry &entry = entries[i];
+    if (entry.nameOffset > m_size ||
+        entry.nameLength > m_size - entry.nameOffset ||
+        entry.dataOffset > m_size || entry.dataSize > m_size - entry.dataOffset)
+      return false;
+  }
+  return true;
+}
+
+std::string_view AssetArchive::_name(const asset_archive::Entry &entry) const {
+  return {reinterpret_cast<const char *>(m_data + entry.nameOffset),
+          entry.nameLength};
+}
+
+std::span<const std::byte> AssetArchive::find(std::string_view name) const {
+  uint64_t hash = asset_archive::hashName(name);
+  auto it = std::ranges::lower_bound(
+      m_entries, hash, {}, &asset_archive::Entry::nameHash);
+  for (; it != m_entries.end() && it->nameHash == hash; ++it) {
+    if (_name(*it) == name)
+      return {m_data + it->dataOffset, static_cast<size_t>(it->dataSize)};
+  }
+  return {};
+}
+
+bool AssetManager::mount(const std::filesystem::path &archive_path,
+                         std::filesystem::path loose_root) {
+  TRACE_SCOPE("AssetManager::mount");
+  s_looseRoot = std::move(loose_root);
+
+  if (!s_archive.open(archive_path)) {
+    std::println("AssetManager: no archive at {}, reading loose files from {}",
+                 archive_path.string(), s_looseRoot.string());
+    return false;
+  }
+
+  std::println("AssetManager: mounted {} ({} assets)", archive_path.string(),
+               s_archive.getEntryCount());
+  return true;
+}
+
+bool AssetManager::contains(std::string_view name) {
+  if (s_archive.isOpen())
+    return !s_archive.find(name).empty();
+
+  std::error_code error;
+  return s_looseFiles.contains(name) ||
+         std::filesystem::is_regular_file(s_looseRoot / name, error);
+}
+
+std::span<const std::byte> AssetManager::load(std::string_view name) {
+  if (s_archive.isOpen()) {
+    std::span<const std::byte> data = s_archive.find(name);
+    if (data.empty())
+      std::println("AssetManager: {} is not in the archive", name);
+    return data;
+  }
+
+  if (auto it = s_looseFiles.find(name); it != s_looseFiles.end())
+    return it->second;
+
+  std::filesystem::path path = s_looseRoot / name;
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file) {
+    std::println("AssetManager: cannot read {}", path.string());
+    return {};
+  }
+
+  std::vector<std::byte> contents(static_cast<size_t>(file.tellg()));
+  file.seekg(0);
+  file.read(reinterpret_cast<char *>(contents.data()), contents.size());
+  return s_looseFiles.emplace(std::string(name), std::move(contents))
+      .first->second;
+}
+
+std::string_view AssetManager::loadText(std::string_view name) {
+  std::span<const std::byte> data = load(name);
+  return {reinterpret_cast<const char *>(data.data()), data.size()};
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "core/asset_archive_format.hpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <map>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Read-only view of an assets.pak mapped into memory. Lookups return spans
+// into the mapping, so nothing is copied or read until it is touched.
+class AssetArchive {
+private:
+  const std::byte *m_data = nullptr;
+  size_t m_size = 0;
+  std::span<const asset_archive::Entry> m_entries;
+#ifdef _WIN32
+  void *m_file = nullptr;
+  void *m_mapping = nullptr;
+#endif
+
+public:
+  AssetArchive() = default;
+  ~AssetArchive();
+  AssetArchive(const AssetArchive &) = delete;
+  AssetArchive &operator=(const AssetArchive &) = delete;
+
+  // Maps and validates the archive; false if missing or malformed
+  bool open(const std::filesystem::path &path);
+  void close();
+
+  bool isOpen() const { return m_data != nullptr; }
+  size_t getEntryCount() const { return m_entries.size(); }
+
+  // Empty span when the archive has no such asset
+  std::span<const std::byte> find(std::string_view name) const;
+
+private:
+  std::string_view _name(const asset_archive::Entry &entry) const;
+  bool _validate() const;
+};
+
+// Where the game gets asset bytes from: the mounted archive, or loose files
+// under a directory when no archive was built (e.g. running from the source
+// tree). Loose files are read once and kept, so spans stay valid either way.
+class AssetManager {
+public:
+  static bool mount(const std::filesystem::path &archive_path,
+                    std::filesystem::path loose_root);
+
+  // Empty span (and a message) when the asset does not exist
+  static std::span<const std::byte> load(std::string_view name);
+  static std::string_view loadText(std::string_view name);
+  // For optional assets, without the missing-asset message
+  static bool contains(std::string_view name);
+
+private:
+  static AssetArchive s_archive;
+  static std::filesystem::path s_looseRoot;
+  static std::map<std::string, std::vector<std::byte>, std::less<>>
+      s_looseFiles;
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+// On-disk layout of assets.pak, shared by AssetArchive and
+// tools/pack_assets. All integers are little-endian.
+//
+//   Header
+//   Entry[entryCount]   sorted by (nameHash, name)
+//   name bytes          asset paths relative to assets/, '/' separated
+//   blobs               each aligned to ALIGNMENT
+namespace asset_archive {
+
+constexpr char MAGIC[4] = {'T', '3', 'D', 'A'};
+constexpr uint32_t VERSION = 1;
+constexpr uint64_t ALIGNMENT = 16;
+
+struct Header {
+  char magic[4];
+  uint32_t version;
+  uint32_t entryCount;
+  uint32_t reserved;
+};
+
+struct Entry {
+  uint64_t nameHash;
+  uint64_t dataOffset; // from the start of the archive
+  uint64_t dataSize;
+  uint32_t nameOffset;
+  uint32_t nameLength;
+};
+
+static_assert(sizeof(Header) == 16 && sizeof(Entry) == 32,
+              "archive structs must have no padding");
+
+// FNV-1a
+constexpr uint64_t hashName(std::string_view name) {
+  uint64_t hash = 14695981039346656037ull;
+  for (char c : name) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+} // namespace asset_archive
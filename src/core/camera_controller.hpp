@@ -4,6 +4,8 @@
 #include "glm/common.hpp"
 #include <glm/gtx/compatibility.hpp>
 
+#include <cmath>
+
 enum class CameraPreset { FRONT, TOP, ISOMETRIC };
 
 class CameraController {
@@ -55,6 +57,12 @@ public:
     m_curDistance =
         glm::lerp(m_curDistance, m_targetDistance, lerpSpeed * delta_time);
 
+    // The lerp only approaches its target; snap the last bit so the camera
+    // comes to rest and idle frames can stop
+    m_curYaw = Settle(m_curYaw, m_targetYaw);
+    m_curPitch = Settle(m_curPitch, m_targetPitch);
+    m_curDistance = Settle(m_curDistance, m_targetDistance);
+
     // Update Camera orientation
     m_camera.SetYaw(m_curYaw);
     m_camera.SetPitch(m_curPitch);
@@ -68,7 +76,13 @@ public:
     offset.z = m_curDistance * sin(glm::radians(m_curYaw)) *
                cos(glm::radians(m_curPitch));
 
-    m_camera.Position = m_target + offset;
+    m_camera.SetPosition(m_target + offset);
+  }
+
+  // False once the camera has reached its preset / orbit target
+  bool IsMoving() const {
+    return m_curYaw != m_targetYaw || m_curPitch != m_targetPitch ||
+           m_curDistance != m_targetDistance;
   }
 
   void HandleRotationInput(bool left, bool right, bool up, bool down,
@@ -87,4 +101,9 @@ public:
 
     m_targetPitch = glm::clamp(m_targetPitch, -89.0f, 89.0f);
   }
+
+private:
+  static float Settle(float current, float target) {
+    return std::abs(target - current) < 0.001f ? target : current;
+  }
 };
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <type_traits>
+
+// Bump allocator for data that lives exactly one frame. Nothing is
+// destroyed, reset() just rewinds, so only trivial types are allowed.
+class FrameArena {
+private:
+  std::unique_ptr<std::byte[]> m_data;
+  size_t m_capacity;
+  size_t m_used = 0;
+
+public:
+  explicit FrameArena(size_t capacity)
+      : m_data(std::make_unique<std::byte[]>(capacity)), m_capacity(capacity) {}
+
+  // Returns an empty span when the arena is full
+  template <typename T> std::span<T> allocate(size_t count = 1) {
+    static_assert(std::is_trivially_copyable_v<T> &&
+                      std::is_trivially_destructible_v<T>,
+                  "FrameArena never runs destructors");
+
+    size_t start = (m_used + alignof(T) - 1) / alignof(T) * alignof(T);
+    if (start + count * sizeof(T) > m_capacity)
+      return {};
+
+    m_used = start + count * sizeof(T);
+    return {reinterpret_cast<T *>(m_data.get() + start), count};
+  }
+
+  void reset() { m_used = 0; }
+
+  size_t getUsed() const { return m_used; }
+  size_t getCapacity() const { return m_capacity; }
+};
@@ -0,0 +1,270 @@
+#include "core/frame_capture.hpp"
+#include "core/trace.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <print>
+#include <system_error>
+
+namespace {
+
+uint32_t crc32(const uint8_t *data, size_t size, uint32_t crc = 0) {
+  static const std::array<uint32_t, 256> table = [] {
+    std::array<uint32_t, 256> entries{};
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t c = i;
+      for (int bit = 0; bit < 8; ++bit)
+        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+      entries[i] = c;
+    }
+    return entries;
+  }();
+
+  crc = ~crc;
+  for (size_t i = 0; i < size; ++i)
+    crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  return ~crc;
+}
+
+void appendBE32(std::vector<uint8_t> &out, uint32_t value) {
+  for (int shift = 24; shift >= 0; shift -= 8)
+    out.push_back(static_cast<uint8_t>(value >> shift));
+}
+
+void appendChunk(std::vector<uint8_t> &out, const char (&type)[5],
+                 const std::vector<uint8_t> &data) {
+  appendBE32(out, static_cast<uint32_t>(data.size()));
+  size_t start = out.size();
+  out.insert(out.end(), type, type + 4);
+  out.insert(out.end(), data.begin(), data.end());
+  appendBE32(out, crc32(out.data() + start, out.size() - start));
+}
+
+// 8-bit RGB PNG in stored (uncompressed) deflate blocks. Captures are
+// compared or converted, not archived, so size matters less than keeping
+// the encoder small and the writer thread fast.
+std::vector<uint8_t> encodePng(const std::vector<uint8_t> &rgb, int width,
+                               int height) {
+  const size_t row_bytes = size_t(width) * 3;
+
+  // Scanlines, each behind filter type 0
+  std::vector<uint8_t> raw;
+  raw.reserve((row_bytes + 1) * height);
+  for (int y = 0; y < height; ++y) {
+    raw.push_back(0);
+    const uint8_t *row = rgb.data() + y * row_bytes;
+    raw.insert(raw.end(), row, row + row_bytes);
+  }
+
+  std::vector<uint8_t> zlib = {0x78, 0x01};
+  size_t offset = 0;
+  do {
+    uint16_t length =
+        static_cast<uint16_t>(std::min<size_t>(raw.size() - offset, 0xFFFF));
+    uint16_t inverse = static_cast<uint16_t>(~length);
+    bool last = offset + length == raw.size();
+    zlib.insert(zlib.end(), {static_cast<uint8_t>(last),
+                             static_cast<uint8_t>(length),
+                             static_cast<uint8_t>(length >> 8),
+                             static_cast<uint8_t>(inverse),
+                             static_cast<uint8_t>(inverse >> 8)});
+    zlib.insert(zlib.end(), raw.begin() + offset,
+                raw.begin() + offset + length);
+    offset += length;
+  } while (offset < raw.size());
+
+  uint32_t a = 1, b = 0; // Adler-32
+  for (uint8_t byte : raw) {
+    a = (a + byte) % 65521;
+    b = (b + a) % 65521;
+  }
+  appendBE32(zlib, (b << 16) | a);
+
+  std::vector<uint8_t> header;
+  appendBE32(header, static_cast<uint32_t>(width));
+  appendBE32(header, static_cast<uint32_t>(height));
+  header.insert(header.end(), {8, 2, 0, 0, 0}); // 8-bit RGB
+
+  std::vector<uint8_t> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+  appendChunk(png, "IHDR", header);
+  appendChunk(png, "IDAT", zlib);
+  appendChunk(png, "IEND", {});
+  return png;
+}
+
+} // namespace
+
+FrameCapture::FrameCapture(const HeadlessConfig &config) : m_config(config) {
+  const GLsizei width = m_config.width;
+  const GLsizei height = m_config.height;
+
+  glCreateRenderbuffers(1, &m_color);
+  glNamedRenderbufferStorage(m_color, GL_RGBA8, width, height);
+  glCreateRenderbuffers(1, &m_depth);
+  glNamedRenderbufferStorage(m_depth, GL_DEPTH_COMPONENT24, width, height);
+
+  glCreateFramebuffers(1, &m_framebuffer);
+  glNamedFramebufferRenderbuffer(m_framebuffer, GL_COLOR_ATTACHMENT0,
+                                 GL_RENDERBUFFER, m_color);
+  glNamedFramebufferRenderbuffer(m_framebuffer, GL_DEPTH_ATTACHMENT,
+                                 GL_RENDERBUFFER, m_depth);
+  if (glCheckNamedFramebufferStatus(m_framebuffer, GL_FRAMEBUFFER) !=
+      GL_FRAMEBUFFER_COMPLETE)
+    std::println("FrameCapture: {}x{} framebuffer is incomplete", width,
+                 height);
+
+  glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+  glViewport(0, 0, width, height);
+
+  if (m_config.captureDir.empty())
+    return;
+
+  std::error_code error;
+  std::filesystem::create_directories(m_config.captureDir, error);
+  if (error) {
+    std::println("FrameCapture: cannot create {}: {}", m_config.captureDir,
+                 error.message());
+    m_config.captureDir.clear();
+    return;
+  }
+
+  const GLsizeiptr size = GLsizeiptr(width) * height * 4;
+  for (Readback &readback : m_readbacks) {
+    glCreateBuffers(1, &readback.buffer);
+    glNamedBufferStorage(readback.buffer, size, nullptr, GL_MAP_READ_BIT);
+  }
+  m_config.captureEvery = std::max<uint32_t>(m_config.captureEvery, 1);
+  m_writer = std::thread(&FrameCapture::_run, this);
+}
+
+FrameCapture::~FrameCapture() {
+  // Oldest first, so files land in frame order
+  for (uint32_t i = 0; i < READBACK_DEPTH; ++i)
+    _collect(m_readbacks[(m_nextReadback + i) % READBACK_DEPTH]);
+
+  if (m_writer.joinable()) {
+    {
+      std::lock_guard lock(m_mutex);
+      m_stopping = true;
+    }
+    m_wake.notify_all();
+    m_writer.join();
+  }
+
+  for (Readback &readback : m_readbacks) {
+    if (readback.buffer != 0)
+      glDeleteBuffers(1, &readback.buffer);
+  }
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glDeleteFramebuffers(1, &m_framebuffer);
+  glDeleteRenderbuffers(1, &m_color);
+  glDeleteRenderbuffers(1, &m_depth);
+}
+
+void FrameCapture::endFrame() {
+  TRACE_SCOPE("FrameCapture::endFrame");
+  uint32_t frame = m_frame++;
+  if (!_isCaptured(frame))
+    return;
+
+  // The slot's previous frame was queued READBACK_DEPTH captures ago
+  Readback &readback = m_readbacks[m_nextReadback];
+  m_nextReadback = (m_nextReadback + 1) % READBACK_DEPTH;
+  _collect(readback);
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+  glReadPixels(0, 0, m_config.width, m_config.height, GL_RGBA,
+               GL_UNSIGNED_BYTE, nullptr);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  readback.frame = frame;
+}
+
+bool FrameCapture::_isCaptured(uint32_t frame) const {
+  return !m_config.captureDir.empty() && frame % m_config.captureEvery == 0;
+}
+
+void FrameCapture::_collect(Readback &readback) {
+  if (!readback.fence)
+    return;
+
+  GLenum result = glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                   FENCE_TIMEOUT_NS);
+  glDeleteSync(readback.fence);
+  readback.fence = nullptr;
+  if (result == GL_WAIT_FAILED || result == GL_TIMEOUT_EXPIRED) {
+    std::println("FrameCapture: readback of frame {} failed", readback.frame);
+    return;
+  }
+
+  const size_t width = m_config.width;
+  const size_t height = m_config.height;
+  const auto *rgba = static_cast<const uint8_t *>(glMapNamedBufferRange(
+      readback.buffer, 0, GLsizeiptr(width * height * 4), GL_MAP_READ_BIT));
+  if (!rgba)
+    return;
+
+  // GL rows start at the bottom; images start at the top. Alpha is dropped:
+  // blended UI leaves it below 1, which would show through in a viewer.
+  WriteJob job;
+  job.pixels.resize(width * height * 3);
+  for (size_t y = 0; y < height; ++y) {
+    const uint8_t *src = rgba + (height - 1 - y) * width * 4;
+    uint8_t *dst = job.pixels.data() + y * width * 3;
+    for (size_t x = 0; x < width; ++x)
+      std::memcpy(dst + x * 3, src + x * 4, 3);
+  }
+  glUnmapNamedBuffer(readback.buffer);
+
+  const char *extension = m_config.format == ImageFormat::PNG ? "png" : "ppm";
+  job.path = std::filesystem::path(m_config.captureDir) /
+             std::format("frame_{:05}.{}", readback.frame, extension);
+
+  std::unique_lock lock(m_mutex);
+  // A slow disk or encoder holds the render thread back instead of letting
+  // frames pile up in memory
+  m_drained.wait(lock, [this] { return m_jobs.size() < MAX_QUEUED_WRITES; });
+  m_jobs.push_back(std::move(job));
+  lock.unlock();
+  m_wake.notify_one();
+}
+
+void FrameCapture::_run() {
+  TRACE_THREAD_NAME("capture");
+  while (true) {
+    WriteJob job;
+    {
+      std::unique_lock lock(m_mutex);
+      m_wake.wait(lock, [this] { return m_stopping || !m_jobs.empty(); });
+      if (m_jobs.empty())
+        return;
+      job = std::move(m_jobs.front());
+      m_jobs.pop_front();
+    }
+    m_drained.notify_one();
+    _write(job);
+  }
+}
+
+void FrameCapture::_write(const WriteJob &job) const {
+  TRACE_SCOPE("FrameCapture::write");
+  const int width = m_config.width;
+  const int height = m_config.height;
+  std::ofstream file(job.path, std::ios::binary);
+
+  if (m_config.format == ImageFormat::PNG) {
+    std::vector<uint8_t> png = encodePng(job.pixels, width, height);
+    file.write(reinterpret_cast<const char *>(png.data()),
+               static_cast<std::streamsize>(png.size()));
+  } else {
+    file << "P6\n" << width << ' ' << height << "\n255\n";
+    file.write(reinterpret_cast<const char *>(job.pixels.data()),
+               static_cast<std::streamsize>(job.pixels.size()));
+  }
+
+  if (!file)
+    std::println("FrameCapture: failed to write {}", job.path.string());
+}
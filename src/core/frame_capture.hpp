@@ -0,0 +1,94 @@
+#pragma once
+
+#include "glad/gl.h"
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class ImageFormat { PNG, PPM };
+
+// --headless: draw into an offscreen target instead of a visible window
+struct HeadlessConfig {
+  int width = 800;
+  int height = 600;
+  uint32_t frames = 600;     // rendered before exiting
+  std::string captureDir;    // empty renders without readback (benchmarks)
+  uint32_t captureEvery = 1; // write every nth frame
+  ImageFormat format = ImageFormat::PNG;
+  // --autostart: the game begins on the first frame with this seed, so
+  // runs with the same seed capture the same gameplay
+  std::optional<uint32_t> autostartSeed;
+};
+
+// Offscreen render target whose frames are read back without stalling the
+// render thread. Each captured frame is read into one of READBACK_DEPTH
+// pixel pack buffers behind a fence and only mapped when that buffer comes
+// around again, by which time the GPU (or llvmpipe) has long finished it.
+// Encoding and file writes then happen on a writer thread. The target is an
+// FBO rather than the window's back buffer, whose pixels are undefined for
+// a hidden window.
+class FrameCapture {
+public:
+  static constexpr uint32_t READBACK_DEPTH = 3;
+  // Frames waiting for the writer before the render thread holds back
+  static constexpr size_t MAX_QUEUED_WRITES = 8;
+  static constexpr GLuint64 FENCE_TIMEOUT_NS = 1'000'000'000;
+
+private:
+  struct Readback {
+    GLuint buffer = 0;
+    GLsync fence = nullptr;
+    uint32_t frame = 0;
+  };
+
+  struct WriteJob {
+    std::filesystem::path path;
+    std::vector<uint8_t> pixels; // RGB, top row first
+  };
+
+  HeadlessConfig m_config;
+  GLuint m_framebuffer = 0;
+  GLuint m_color = 0;
+  GLuint m_depth = 0;
+
+  std::array<Readback, READBACK_DEPTH> m_readbacks{};
+  uint32_t m_nextReadback = 0;
+  uint32_t m_frame = 0;
+
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::condition_variable m_drained;
+  std::deque<WriteJob> m_jobs;
+  bool m_stopping = false;
+  std::thread m_writer;
+
+public:
+  // Binds the target; nothing in src/ binds another framebuffer, so it
+  // stays bound for the life of the capture
+  explicit FrameCapture(const HeadlessConfig &config);
+  // Reads back and writes every frame still in flight
+  ~FrameCapture();
+  FrameCapture(const FrameCapture &) = delete;
+  FrameCapture &operator=(const FrameCapture &) = delete;
+
+  // After the frame is drawn; starts its readback when it is captured
+  void endFrame();
+
+  int getWidth() const { return m_config.width; }
+  int getHeight() const { return m_config.height; }
+
+private:
+  bool _isCaptured(uint32_t frame) const;
+  // Maps a finished readback and queues it for the writer
+  void _collect(Readback &readback);
+  void _run();
+  void _write(const WriteJob &job) const;
+};
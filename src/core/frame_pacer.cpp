@@ -0,0 +1,95 @@
+#include "frame_pacer.hpp"
+#include "core/trace.hpp"
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+FramePacer::FramePacer(FramePacing config) : m_config(config) {
+  glfwSwapInterval(config.mode == FramePacing::Mode::VSYNC ? 1 : 0);
+
+  double fps = 0.0;
+  if (config.mode == FramePacing::Mode::FIXED) {
+    fps = config.fps;
+  } else if (config.mode == FramePacing::Mode::VSYNC) {
+    const GLFWvidmode *mode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+    fps = mode && mode->refreshRate > 0 ? mode->refreshRate : 60.0;
+  }
+
+  if (fps > 0.0) {
+    m_period = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1.0 / fps));
+  }
+}
+
+void FramePacer::present(GLFWwindow *window) {
+  if (m_config.mode == FramePacing::Mode::FIXED) {
+    TRACE_SCOPE("FramePacer::wait");
+    Clock::time_point now = Clock::now();
+    Clock::time_point deadline = m_hasDeadline ? m_deadline : now;
+    if (now > deadline + m_period)
+      deadline = now;
+
+    _waitUntil(deadline);
+    m_deadline = deadline + m_period;
+    m_hasDeadline = true;
+  }
+
+  glfwSwapBuffers(window);
+  // With vsync the swap is what blocks, so measure after it
+  _record(Clock::now());
+}
+
+void FramePacer::reset() {
+  m_hasDeadline = false;
+  m_hasLastPresent = false;
+}
+
+void FramePacer::_waitUntil(Clock::time_point deadline) const {
+  if (deadline - Clock::now() > SPIN_THRESHOLD)
+    std::this_thread::sleep_until(deadline - SPIN_THRESHOLD);
+
+  while (Clock::now() < deadline)
+    std::this_thread::yield();
+}
+
+void FramePacer::_record(Clock::time_point now) {
+  if (m_hasLastPresent) {
+    m_intervalsMs[m_next] =
+        std::chrono::duration<double, std::milli>(now - m_lastPresent).count();
+    m_next = (m_next + 1) % HISTORY;
+    m_count = std::min(m_count + 1, HISTORY);
+  }
+  m_lastPresent = now;
+  m_hasLastPresent = true;
+}
+
+FramePacer::Stats FramePacer::getStats() const {
+  Stats stats;
+  stats.targetMs = std::chrono::duration<double, std::milli>(m_period).count();
+  stats.samples = m_count;
+  if (m_count == 0)
+    return stats;
+
+  double sum = 0.0;
+  for (size_t i = 0; i < m_count; ++i)
+    sum += m_intervalsMs[i];
+  stats.meanMs = sum / m_count;
+
+  double squares = 0.0;
+  double errors = 0.0;
+  for (size_t i = 0; i < m_count; ++i) {
+    double interval = m_intervalsMs[i];
+    squares += (interval - stats.meanMs) * (interval - stats.meanMs);
+    if (stats.targetMs > 0.0) {
+      double error = std::abs(interval - stats.targetMs);
+      errors += error;
+      stats.maxErrorMs = std::max(stats.maxErrorMs, error);
+    }
+  }
+  stats.stdDevMs = std::sqrt(squares / m_count);
+  stats.meanErrorMs = errors / m_count;
+  return stats;
+}
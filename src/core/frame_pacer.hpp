@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+
+struct GLFWwindow;
+
+struct FramePacing {
+  enum class Mode {
+    VSYNC,    // swap interval 1, the display sets the rate
+    FIXED,    // swap interval 0, paced to fps by the CPU
+    UNCAPPED, // swap interval 0, as fast as possible
+  };
+
+  Mode mode = Mode::VSYNC;
+  double fps = 60.0; // FIXED only
+};
+
+// Presents frames at a steady rate. In FIXED mode each frame is held back
+// until its slot on a monotonic timeline: sleep until SPIN_THRESHOLD before
+// the deadline (sleep overshoots by up to a scheduler tick), then spin the
+// rest. A frame that falls more than a period behind restarts the
+// timeline instead of bursting to catch up. Every presented frame's
+// interval is recorded, so jitter and error against the target are
+// measurable in all modes.
+class FramePacer {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr Clock::duration SPIN_THRESHOLD =
+      std::chrono::microseconds(2000);
+  static constexpr size_t HISTORY = 240;
+
+  struct Stats {
+    double targetMs = 0.0; // 0 when uncapped
+    double meanMs = 0.0;
+    double stdDevMs = 0.0;
+    double meanErrorMs = 0.0; // mean |interval - target|
+    double maxErrorMs = 0.0;
+    size_t samples = 0;
+  };
+
+private:
+  FramePacing m_config;
+  Clock::duration m_period{0};
+
+  Clock::time_point m_deadline;
+  bool m_hasDeadline = false;
+  Clock::time_point m_lastPresent;
+  bool m_hasLastPresent = false;
+
+  std::array<double, HISTORY> m_intervalsMs{};
+  size_t m_next = 0;
+  size_t m_count = 0;
+
+public:
+  // Sets the swap interval, so the window's context must be current
+  explicit FramePacer(FramePacing config = {});
+
+  // Waits for the frame's slot, then swaps
+  void present(GLFWwindow *window);
+  // Forget the timeline, e.g. after the loop sat idle; the next interval
+  // is not recorded
+  void reset();
+
+  const FramePacing &getConfig() const { return m_config; }
+  // Over the last HISTORY frames
+  Stats getStats() const;
+
+private:
+  void _waitUntil(Clock::time_point deadline) const;
+  void _record(Clock::time_point now);
+};
@@ -0,0 +1,22 @@
+#include "frame_scheduler.hpp"
+#include "core/trace.hpp"
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+
+void FrameScheduler::requestAnimation(double max_fps) {
+  m_deadline = std::min(m_deadline, m_lastFrame + 1.0 / max_fps);
+}
+
+void FrameScheduler::beginFrame(double now) {
+  m_lastFrame = now;
+  m_dirty = 0;
+  m_deadline = NEVER;
+}
+
+void FrameScheduler::wait(double now) const {
+  TRACE_SCOPE("FrameScheduler::wait");
+  double timeout = std::clamp(m_deadline - now, 0.0, MAX_WAIT);
+  glfwWaitEventsTimeout(timeout);
+}
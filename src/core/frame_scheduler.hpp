@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+// Decides when the main loop draws. Anything that changes the picture
+// (input, a new game state, the camera still easing, a resize) invalidates
+// the next frame; animations instead ask for a refresh at a capped rate.
+// With neither pending the loop blocks in glfwWaitEventsTimeout until an
+// event (the game thread posts one when its state changes) or the next
+// animation deadline, so a static screen costs next to no CPU.
+class FrameScheduler {
+public:
+  enum Reason : uint32_t {
+    INPUT = 1 << 0,
+    GAME_STATE = 1 << 1,
+    CAMERA = 1 << 2,
+    WINDOW = 1 << 3,
+    LOADING = 1 << 4,   // textures, glyphs or stack meshes still coming in
+    PROFILING = 1 << 5, // the F3 overlay times continuous frames
+  };
+
+  // Upper bound on a single wait, in case a wake-up is ever lost
+  static constexpr double MAX_WAIT = 0.5;
+  // Frame delta used for the first frame after waiting; time spent idle is
+  // not time anything should have moved for
+  static constexpr double RESUME_DELTA = 1.0 / 60.0;
+
+private:
+  static constexpr double NEVER = std::numeric_limits<double>::infinity();
+
+  bool m_idleEnabled = true;
+  uint32_t m_dirty = ~0u; // the first frame always draws
+  double m_lastFrame = 0.0;
+  double m_deadline = NEVER;
+
+public:
+  // Off: draw every iteration, as fast as the swap allows (benchmarks)
+  void setIdleEnabled(bool enabled) { m_idleEnabled = enabled; }
+
+  void invalidate(Reason reason) { m_dirty |= reason; }
+  // The next frame should follow the current one within 1 / max_fps
+  void requestAnimation(double max_fps);
+
+  bool shouldRender(double now) const {
+    return !m_idleEnabled || m_dirty != 0 || now >= m_deadline;
+  }
+  // Reasons and animation requests collected so far start over
+  void beginFrame(double now);
+  // Blocks until an event arrives or the next animation deadline
+  void wait(double now) const;
+};
@@ -0,0 +1,36 @@
+#include "frame_uniforms.hpp"
+#include "ui/ui_manager.hpp"
+
+#include <cstring>
+#include <glm/gtc/matrix_transform.hpp>
+
+void FrameUniformBuffer::update(const Camera &camera, float time) {
+  if (camera.GetRevision() != m_cameraRevision) {
+    m_data.view = camera.GetViewMatrix();
+    m_data.projection = camera.GetProjectionMatrix();
+    m_data.viewProjection = camera.GetViewProjectionMatrix();
+    m_data.cameraPos = glm::vec4(camera.GetPosition(), 1.0f);
+    m_cameraRevision = camera.GetRevision();
+  }
+
+  // The 2D projections only depend on the aspect ratio
+  if (float aspect = camera.GetAspect(); aspect != m_aspect) {
+    float height = UIManager::VIRTUAL_HEIGHT;
+    float width = height * aspect;
+
+    m_data.hudProjection = glm::ortho(0.0f, width, 0.0f, height, -10.0f, 10.0f);
+    m_data.screenProjection = glm::ortho(0.0f, width, height, 0.0f);
+    m_aspect = aspect;
+  }
+
+  m_data.time = time;
+
+  StreamBuffer::Allocation allocation =
+      m_stream.allocate(sizeof(FrameData), m_stream.getUniformAlignment());
+  if (!allocation)
+    return;
+
+  std::memcpy(allocation.data, &m_data, sizeof(FrameData));
+  glBindBufferRange(GL_UNIFORM_BUFFER, BINDING, allocation.buffer,
+                    allocation.offset, sizeof(FrameData));
+}
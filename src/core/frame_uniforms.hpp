@@ -0,0 +1,48 @@
+#pragma once
+
+#include "camera.h"
+#include "core/stream_buffer.hpp"
+#include "glad/gl.h"
+
+#include <cstdint>
+#include <glm/glm.hpp>
+
+// Per-frame data shared by every program through one std140 uniform block
+// (FrameData in the shaders). Must match the GLSL declaration exactly.
+struct FrameData {
+  glm::mat4 view;
+  glm::mat4 projection;
+  glm::mat4 viewProjection;
+  glm::mat4 hudProjection;    // 3D HUD previews (hold / queue), y up
+  glm::mat4 screenProjection; // UIManager virtual screen, y down
+  glm::vec4 cameraPos;        // xyz, w unused
+  float time;
+  float _padding[3];
+};
+
+static_assert(sizeof(FrameData) == 5 * 64 + 16 + 16,
+              "FrameData must follow std140 layout");
+
+// Keeps the FrameData block. update() is called once per frame, before
+// anything is drawn; it writes the block into the stream buffer and binds
+// that range for all programs.
+class FrameUniformBuffer {
+public:
+  static constexpr GLuint BINDING = 0;
+
+private:
+  StreamBuffer &m_stream;
+  FrameData m_data{};
+
+  uint64_t m_cameraRevision = UINT64_MAX;
+  float m_aspect = 0.0f;
+
+public:
+  explicit FrameUniformBuffer(StreamBuffer &stream) : m_stream(stream) {}
+  FrameUniformBuffer(const FrameUniformBuffer &) = delete;
+  FrameUniformBuffer &operator=(const FrameUniformBuffer &) = delete;
+
+  void update(const Camera &camera, float time);
+
+  const FrameData &getData() const { return m_data; }
+};
@@ -0,0 +1,209 @@
+#include "core/game_thread.hpp"
+#include "core/trace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <print>
+
+namespace {
+
+bool samePiece(const Tetromino &a, const Tetromino &b) {
+  return a.getType() == b.getType() && a.getPosition() == b.getPosition() &&
+         std::ranges::equal(a.getOffsets(), b.getOffsets());
+}
+
+// Everything the renderer and HUD read from a frame; boardRevision stands
+// in for the cells
+bool looksSame(const GameFrame &a, const GameFrame &b) {
+  const TetrisManager::RenderState &x = a.board;
+  const TetrisManager::RenderState &y = b.board;
+  return x.boardRevision == y.boardRevision &&
+         samePiece(x.activePiece, y.activePiece) &&
+         x.ghostOffset == y.ghostOffset &&
+         x.clearingLayers == y.clearingLayers && x.queue == y.queue &&
+         x.queueCount == y.queueCount && x.heldType == y.heldType &&
+         x.state == y.state && x.score == y.score &&
+         x.linesCleared == y.linesCleared && x.level == y.level &&
+         a.opponentScore == b.opponentScore && a.started == b.started;
+}
+
+} // namespace
+
+GameThread::GameThread(const LaunchOptions &options) {
+  if (const auto &netplay = options.netplay; netplay.has_value()) {
+    m_opponent.emplace(netplay->seed);
+
+    bool is_host = netplay->localPlayer == 0;
+    TetrisManager &player_one = is_host ? m_game : *m_opponent;
+    TetrisManager &player_two = is_host ? *m_opponent : m_game;
+    m_netplay =
+        std::make_unique<RollbackSession>(player_one, player_two, *netplay);
+
+    std::println("netplay: listening on port {}", m_netplay->getLocalPort());
+  }
+
+  if (options.spectator.has_value()) {
+    m_spectatorServer = std::make_unique<SpectatorServer>();
+
+    if (m_spectatorServer->open(*options.spectator)) {
+      m_game.setJournalEnabled(true);
+    } else {
+      m_spectatorServer.reset();
+    }
+  }
+
+  if (const auto &headless = options.headless; headless.has_value()) {
+    m_manualTicks = true;
+    // Netplay starts when both peers are connected, not on a flag
+    if (headless->autostartSeed.has_value() && !m_netplay) {
+      m_game.reset(*headless->autostartSeed);
+      m_started = true;
+    }
+  }
+
+  // Make sure the first acquireFrame() already sees a valid board
+  _publishFrame();
+}
+
+GameThread::~GameThread() { stop(); }
+
+void GameThread::start() {
+  if (m_running.exchange(true))
+    return;
+
+  if (!m_manualTicks)
+    m_thread = std::thread(&GameThread::_run, this);
+  if (m_spectatorServer)
+    m_spectatorThread = std::thread(&GameThread::_runSpectators, this);
+}
+
+void GameThread::stop() {
+  m_running.store(false);
+
+  if (m_thread.joinable())
+    m_thread.join();
+  if (m_spectatorThread.joinable())
+    m_spectatorThread.join();
+}
+
+void GameThread::step(int ticks) {
+  for (int i = 0; i < ticks; ++i)
+    _tick();
+}
+
+void GameThread::_run() {
+  TRACE_THREAD_NAME("game");
+
+  using Clock = std::chrono::steady_clock;
+  const auto tick_delay = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(TICK_DELAY));
+
+  auto next_tick = Clock::now();
+
+  while (m_running.load(std::memory_order_relaxed)) {
+    int ticks = 0;
+    while (Clock::now() >= next_tick && ticks < MAX_CATCH_UP_TICKS) {
+      _tick();
+      next_tick += tick_delay;
+      ticks++;
+    }
+
+    // Too far behind (debugger, suspended laptop): drop the backlog instead
+    // of fast forwarding through it
+    if (ticks == MAX_CATCH_UP_TICKS)
+      next_tick = Clock::now() + tick_delay;
+
+    std::this_thread::sleep_until(next_tick);
+  }
+}
+
+void GameThread::_runSpectators() {
+  TRACE_THREAD_NAME("spectators");
+
+  const auto poll_delay = std::chrono::duration<double>(TICK_DELAY);
+
+  while (m_running.load(std::memory_order_relaxed)) {
+    while (auto message = m_spectatorOut.pop()) {
+      m_spectatorServer->publish(message->bytes, message->keyframe);
+      m_spectatorFree.push(std::move(message->bytes));
+    }
+    m_spectatorServer->poll();
+
+    std::this_thread::sleep_for(poll_delay);
+  }
+}
+
+void GameThread::_tick() {
+  TRACE_SCOPE("GameThread::tick");
+  uint16_t held_bits = m_heldBits.load(std::memory_order_relaxed);
+
+  if (m_startRequested.exchange(false, std::memory_order_relaxed))
+    m_started = true;
+
+  if (m_netplay) {
+    while (auto input = m_inputs.pop()) {
+      m_netplay->queueLocalInput(*input);
+    }
+    m_netplay->setLocalHeldBits(held_bits);
+    m_netplay->advance(TICK_DELAY);
+    m_started = m_netplay->isRunning();
+  } else {
+    while (auto input = m_inputs.pop()) {
+      if (m_started)
+        applyFrameInput(m_game, {static_cast<uint16_t>(input->bits |
+                                                       held_bits)});
+    }
+    if (m_started) {
+      m_game.setSoftDrop((held_bits & FrameInput::SOFT_DROP) != 0);
+      m_game.update(TICK_DELAY);
+    }
+  }
+
+  m_tick++;
+  _publishSpectatorFrame();
+  _publishFrame();
+}
+
+void GameThread::_publishSpectatorFrame() {
+  if (!m_spectatorServer)
+    return;
+
+  using Result = SpectatorEncoder::Result;
+
+  if (m_spectatorBuffer.capacity() == 0) {
+    if (auto buffer = m_spectatorFree.pop())
+      m_spectatorBuffer = std::move(*buffer);
+  }
+
+  Result result = m_spectatorEncoder.encode(m_game, m_spectatorBuffer);
+  if (result == Result::NONE)
+    return;
+
+  SpectatorMessage message{std::move(m_spectatorBuffer),
+                           result == Result::KEYFRAME};
+  m_spectatorBuffer = {};
+  // The spectator thread fell behind: the next message resyncs everyone
+  if (!m_spectatorOut.push(std::move(message)))
+    m_spectatorEncoder.requestKeyframe();
+}
+
+void GameThread::_publishFrame() {
+  TRACE_SCOPE("GameThread::publish");
+  GameFrame &frame = m_frames.back();
+
+  m_game.captureRenderState(frame.board);
+  frame.opponentScore = m_opponent.transform(&TetrisManager::getScore);
+  frame.started = m_started;
+  frame.tick = m_tick;
+
+  bool changed = !looksSame(frame, m_lastChanged);
+  if (changed) {
+    ++m_revision;
+    m_lastChanged = frame; // copies the board, but only on a change
+  }
+  frame.revision = m_revision;
+
+  m_frames.publish();
+  if (changed && m_onChange)
+    m_onChange();
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "core/frame_capture.hpp"
+#include "core/frame_pacer.hpp"
+#include "core/spsc_queue.hpp"
+#include "core/triple_buffer.hpp"
+#include "game/frame_input.hpp"
+#include "game/tetris_manager.hpp"
+#include "net/rollback_session.hpp"
+#include "net/spectator_server.hpp"
+#include "net/spectator_stream.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct LaunchOptions {
+  std::optional<NetplayConfig> netplay;
+  std::optional<SpectatorConfig> spectator;
+  std::optional<std::string> gpuProfilePath; // GPU timings written on exit
+  std::optional<std::string> tracePath;      // CPU trace written on exit
+  std::string cachePath; // program binaries and SDF font, empty to disable
+  std::string assetArchivePath; // assets.pak built by tools/pack_assets
+  std::string fontPath;         // TrueType font for UI text, empty to search
+  bool idleRendering = true;    // skip frames while nothing changes
+  FramePacing pacing;
+  std::optional<HeadlessConfig> headless; // offscreen, no visible window
+};
+
+// Everything the render thread needs from one simulation tick
+struct GameFrame {
+  TetrisManager::RenderState board;
+  std::optional<uint64_t> opponentScore; // set during online versus
+  bool started = false;
+  uint64_t tick = 0;
+  // Bumped only when something drawn from the frame changed, so the render
+  // thread can tell a new frame from a new tick of a static board
+  uint64_t revision = 0;
+};
+
+// Runs the simulation (and netplay / spectator networking) at a fixed tick
+// rate on its own thread. The render thread only pushes inputs and reads the
+// newest published GameFrame, so a slow frame never stalls the game and the
+// game never touches GL. Headless runs have no game thread: the render
+// thread steps the simulation itself, in time with its virtual clock.
+class GameThread {
+public:
+  static constexpr double TICK_RATE = 120.0;
+  static constexpr double TICK_DELAY = 1.0 / TICK_RATE;
+  static constexpr int MAX_CATCH_UP_TICKS = 8;
+  static constexpr size_t INPUT_QUEUE_SIZE = 256;
+  static constexpr size_t SPECTATOR_QUEUE_SIZE = 64;
+
+private:
+  struct SpectatorMessage {
+    std::vector<uint8_t> bytes;
+    bool keyframe = false;
+  };
+
+  TetrisManager m_game;
+  std::optional<TetrisManager> m_opponent;
+  std::unique_ptr<RollbackSession> m_netplay;
+
+  // Only encoding happens on the game thread. Accepting spectators and
+  // flushing their sockets runs on a separate thread, so a slow client
+  // never delays a tick.
+  std::unique_ptr<SpectatorServer> m_spectatorServer;
+  SpectatorEncoder m_spectatorEncoder;
+  std::vector<uint8_t> m_spectatorBuffer;
+  // game thread -> spectator thread; buffers come back through
+  // m_spectatorFree, so steady state never allocates
+  SpscQueue<SpectatorMessage, SPECTATOR_QUEUE_SIZE> m_spectatorOut;
+  SpscQueue<std::vector<uint8_t>, SPECTATOR_QUEUE_SIZE> m_spectatorFree;
+  std::thread m_spectatorThread;
+
+  // render thread -> game thread
+  SpscQueue<FrameInput, INPUT_QUEUE_SIZE> m_inputs;
+  std::atomic<uint16_t> m_heldBits{0};
+  std::atomic<bool> m_startRequested{false};
+
+  // game thread -> render thread
+  TripleBuffer<GameFrame> m_frames;
+
+  bool m_started = false;
+  uint64_t m_tick = 0;
+  // Headless: ticks come only from step(), never from the wall clock
+  bool m_manualTicks = false;
+
+  // Last frame that bumped the revision, to compare new ones against
+  GameFrame m_lastChanged;
+  uint64_t m_revision = 0;
+  void (*m_onChange)() = nullptr;
+
+  std::atomic<bool> m_running{false};
+  std::thread m_thread;
+
+public:
+  explicit GameThread(const LaunchOptions &options = {});
+  ~GameThread();
+
+  GameThread(const GameThread &) = delete;
+  GameThread &operator=(const GameThread &) = delete;
+
+  // Called on the game thread after publishing a frame with a new
+  // revision, e.g. glfwPostEmptyEvent to wake an idle render loop. Set it
+  // before start().
+  void setChangeCallback(void (*callback)()) { m_onChange = callback; }
+
+  void start();
+  void stop();
+
+  // Headless: runs `ticks` ticks on the calling thread and publishes the
+  // result, so the next acquireFrame() sees it
+  void step(int ticks);
+
+  // --- Render thread side ---
+  bool pushInput(FrameInput input) { return m_inputs.push(input); }
+  void setHeldBits(uint16_t bits) {
+    m_heldBits.store(bits & FrameInput::HELD_BITS, std::memory_order_relaxed);
+  }
+  void requestStart() {
+    m_startRequested.store(true, std::memory_order_relaxed);
+  }
+
+  // Swaps in the newest frame, if any, and returns the current one
+  const GameFrame &acquireFrame() {
+    m_frames.acquire();
+    return m_frames.front();
+  }
+
+  bool isOnline() const { return m_netplay != nullptr; }
+
+private:
+  void _run();
+  void _runSpectators();
+  void _tick();
+  void _publishSpectatorFrame();
+  void _publishFrame();
+};
@@ -8,9 +8,4 @@ struct TetrominoVertex {
   glm::vec2 uv;
 };
 
-struct UIVertex {
-  glm::vec2 pos;
-  glm::vec2 uv;
-};
-
 // void draw_ui_quad(GLuint ui_vao);
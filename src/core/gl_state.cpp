@@ -0,0 +1,65 @@
+#include "gl_state.hpp"
+
+GLState::State GLState::s_state;
+GLState::Stats GLState::s_frame;
+GLState::Stats GLState::s_lastFrame;
+
+void GLState::useProgram(GLuint program) {
+  if (_change(s_state.program, program))
+    glUseProgram(program);
+}
+
+void GLState::bindVertexArray(GLuint vao) {
+  if (_change(s_state.vao, vao))
+    glBindVertexArray(vao);
+}
+
+void GLState::bindTexture(uint32_t unit, GLuint texture) {
+  if (unit >= TEXTURE_UNITS) {
+    glBindTextureUnit(unit, texture);
+    return;
+  }
+
+  if (_change(s_state.textures[unit], texture))
+    glBindTextureUnit(unit, texture);
+}
+
+void GLState::setDepthTest(bool enabled) {
+  _setCapability(s_state.depthTest, GL_DEPTH_TEST, enabled);
+}
+
+void GLState::setDepthMask(bool enabled) {
+  if (_change(s_state.depthMask, enabled))
+    glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+}
+
+void GLState::setBlend(bool enabled) {
+  _setCapability(s_state.blend, GL_BLEND, enabled);
+}
+
+void GLState::setBlendFunc(GLenum src, GLenum dst) {
+  if (_change(s_state.blendFunc, {src, dst}))
+    glBlendFunc(src, dst);
+}
+
+void GLState::setCullFace(bool enabled) {
+  _setCapability(s_state.cullFace, GL_CULL_FACE, enabled);
+}
+
+void GLState::invalidate() { s_state = {}; }
+
+void GLState::endFrame() {
+  s_lastFrame = s_frame;
+  s_frame = {};
+}
+
+void GLState::_setCapability(std::optional<bool> &shadow, GLenum cap,
+                             bool enabled) {
+  if (!_change(shadow, enabled))
+    return;
+
+  if (enabled)
+    glEnable(cap);
+  else
+    glDisable(cap);
+}
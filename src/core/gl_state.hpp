@@ -0,0 +1,70 @@
+#pragma once
+
+#include "glad/gl.h"
+#include "shader.h"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+
+// Shadow copy of the GL state the renderers change every frame (program,
+// VAO, texture units, enables, blend func, depth mask). Each setter compares
+// against the shadow and only reaches GL on a real change. All state changes
+// in src/ go through here; anything that bypasses it must call invalidate().
+class GLState {
+public:
+  static constexpr uint32_t TEXTURE_UNITS = 8;
+
+  struct Stats {
+    uint32_t issued = 0;
+    uint32_t skipped = 0;
+  };
+
+  static void useProgram(const Shader &shader) { useProgram(shader.ID); }
+  static void useProgram(GLuint program);
+  static void bindVertexArray(GLuint vao);
+  static void bindTexture(uint32_t unit, GLuint texture);
+
+  static void setDepthTest(bool enabled);
+  static void setDepthMask(bool enabled);
+  static void setBlend(bool enabled);
+  static void setBlendFunc(GLenum src, GLenum dst);
+  static void setCullFace(bool enabled);
+
+  // Forget the shadow copy; the next call of every setter reaches GL
+  static void invalidate();
+
+  // Closes the frame's counters; getFrameStats() reports the last frame
+  static void endFrame();
+  static const Stats &getFrameStats() { return s_lastFrame; }
+
+private:
+  struct State {
+    std::optional<GLuint> program;
+    std::optional<GLuint> vao;
+    std::array<std::optional<GLuint>, TEXTURE_UNITS> textures;
+    std::optional<bool> depthTest;
+    std::optional<bool> depthMask;
+    std::optional<bool> blend;
+    std::optional<std::array<GLenum, 2>> blendFunc;
+    std::optional<bool> cullFace;
+  };
+
+  static State s_state;
+  static Stats s_frame;
+  static Stats s_lastFrame;
+
+  template <typename T>
+  static bool _change(std::optional<T> &shadow, const T &value) {
+    if (shadow == value) {
+      ++s_frame.skipped;
+      return false;
+    }
+    shadow = value;
+    ++s_frame.issued;
+    return true;
+  }
+
+  static void _setCapability(std::optional<bool> &shadow, GLenum cap,
+                             bool enabled);
+};
@@ -0,0 +1,176 @@
+#include "gpu_profiler.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <print>
+
+namespace {
+constexpr uint32_t NO_SCOPE = UINT32_MAX;
+} // namespace
+
+GpuProfiler::GpuProfiler() {
+  // A counter width of 0 means timestamps are not implemented
+  GLint bits = 0;
+  glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+  m_supported = bits > 0;
+
+  if (!m_supported) {
+    std::println("GpuProfiler: GL_TIMESTAMP queries unsupported, disabled");
+    return;
+  }
+
+  for (FrameSlot &slot : m_frames)
+    glCreateQueries(GL_TIMESTAMP, slot.queries.size(), slot.queries.data());
+
+  m_stats.reserve(MAX_PASSES);
+  m_history.reserve(MAX_PASSES);
+}
+
+GpuProfiler::~GpuProfiler() {
+  if (!m_supported)
+    return;
+
+  for (FrameSlot &slot : m_frames)
+    glDeleteQueries(slot.queries.size(), slot.queries.data());
+}
+
+void GpuProfiler::beginFrame() {
+  if (!m_supported)
+    return;
+
+  m_frame = (m_frame + 1) % FRAME_LATENCY;
+  FrameSlot &slot = m_frames[m_frame];
+  if (slot.pending)
+    _collect(slot);
+
+  slot.scopeCount = 0;
+  m_inFrame = m_enabled;
+}
+
+void GpuProfiler::endFrame() {
+  if (!m_inFrame)
+    return;
+
+  FrameSlot &slot = m_frames[m_frame];
+  slot.pending = slot.scopeCount > 0;
+  m_inFrame = false;
+}
+
+GpuProfiler::Scope GpuProfiler::scope(const char *name) {
+  if (!m_inFrame)
+    return {nullptr, NO_SCOPE};
+
+  FrameSlot &slot = m_frames[m_frame];
+  uint32_t pass = _passIndex(name);
+  if (slot.scopeCount == MAX_SCOPES || pass == NO_SCOPE)
+    return {nullptr, NO_SCOPE};
+
+  uint32_t index = slot.scopeCount++;
+  slot.pass[index] = static_cast<uint8_t>(pass);
+  glQueryCounter(slot.queries[2 * index], GL_TIMESTAMP);
+  return {this, index};
+}
+
+void GpuProfiler::_endScope(uint32_t scope) {
+  FrameSlot &slot = m_frames[m_frame];
+  glQueryCounter(slot.queries[2 * scope + 1], GL_TIMESTAMP);
+}
+
+uint32_t GpuProfiler::_passIndex(const char *name) {
+  for (uint32_t i = 0; i < m_stats.size(); ++i) {
+    if (m_stats[i].name == name || std::strcmp(m_stats[i].name, name) == 0)
+      return i;
+  }
+
+  if (m_stats.size() == MAX_PASSES)
+    return NO_SCOPE;
+
+  m_stats.push_back({name});
+  m_history.emplace_back();
+  return static_cast<uint32_t>(m_stats.size() - 1);
+}
+
+void GpuProfiler::_collect(FrameSlot &slot) {
+  slot.pending = false;
+
+  // Queries finish in submission order, so the last one covers the frame
+  GLint available = 0;
+  GLuint last = slot.queries[2 * slot.scopeCount - 1];
+  glGetQueryObjectiv(last, GL_QUERY_RESULT_AVAILABLE, &available);
+  if (!available) {
+    // Still in flight after FRAME_LATENCY frames; drop it rather than stall
+    ++m_framesDropped;
+    return;
+  }
+
+  // A pass may be scoped more than once per frame, its time is the sum
+  std::array<double, MAX_PASSES> totals{};
+  std::array<bool, MAX_PASSES> seen{};
+
+  for (uint32_t i = 0; i < slot.scopeCount; ++i) {
+    GLuint64 start = 0;
+    GLuint64 end = 0;
+    glGetQueryObjectui64v(slot.queries[2 * i], GL_QUERY_RESULT, &start);
+    glGetQueryObjectui64v(slot.queries[2 * i + 1], GL_QUERY_RESULT, &end);
+
+    uint8_t pass = slot.pass[i];
+    totals[pass] += end > start ? (end - start) / 1.0e6 : 0.0;
+    seen[pass] = true;
+  }
+
+  for (uint32_t pass = 0; pass < m_stats.size(); ++pass) {
+    if (seen[pass])
+      _record(pass, totals[pass]);
+  }
+  ++m_framesCollected;
+}
+
+void GpuProfiler::_record(uint32_t pass, double ms) {
+  PassHistory &history = m_history[pass];
+  history.samples[history.cursor] = static_cast<float>(ms);
+  history.cursor = (history.cursor + 1) % HISTORY;
+  history.count = std::min(history.count + 1, HISTORY);
+
+  std::span<const float> window(history.samples.data(), history.count);
+  double sum = 0.0;
+  for (float sample : window)
+    sum += sample;
+
+  PassStats &stats = m_stats[pass];
+  stats.lastMs = ms;
+  stats.averageMs = sum / history.count;
+  stats.maxMs = *std::ranges::max_element(window);
+  ++stats.samples;
+}
+
+std::string GpuProfiler::toJson() const {
+  std::string json = std::format(
+      "{{\n  \"frames_collected\": {},\n  \"frames_dropped\": {},\n"
+      "  \"window\": {},\n  \"passes\": [",
+      m_framesCollected, m_framesDropped, HISTORY);
+
+  for (size_t i = 0; i < m_stats.size(); ++i) {
+    const PassStats &stats = m_stats[i];
+    std::format_to(std::back_inserter(json),
+                   "{}\n    {{\"name\": \"{}\", \"last_ms\": {:.4f}, "
+                   "\"avg_ms\": {:.4f}, \"max_ms\": {:.4f}, \"samples\": {}}}",
+                   i == 0 ? "" : ",", stats.name, stats.lastMs,
+                   stats.averageMs, stats.maxMs, stats.samples);
+  }
+
+  json += "\n  ]\n}\n";
+  return json;
+}
+
+bool GpuProfiler::dumpJson(const std::filesystem::path &path) const {
+  std::ofstream file(path);
+  if (!file) {
+    std::println("GpuProfiler: cannot write {}", path.string());
+    return false;
+  }
+
+  file << toJson();
+  return static_cast<bool>(file);
+}
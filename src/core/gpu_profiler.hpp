@@ -0,0 +1,101 @@
+#pragma once
+
+#include "glad/gl.h"
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <vector>
+
+// Scoped GPU pass timing. Every scope writes a GL_TIMESTAMP query at its
+// start and end; queries live in a ring FRAME_LATENCY frames deep and are
+// only read back once that frame slot comes around again, so the CPU never
+// waits on the GPU. Timestamps (rather than GL_TIME_ELAPSED) allow scopes
+// to nest, and work on Mesa llvmpipe.
+class GpuProfiler {
+public:
+  static constexpr uint32_t FRAME_LATENCY = 4;
+  static constexpr uint32_t MAX_SCOPES = 32; // per frame
+  static constexpr uint32_t MAX_PASSES = 8;
+  static constexpr uint32_t HISTORY = 120; // frames in the rolling average
+
+  struct PassStats {
+    const char *name;
+    double lastMs = 0.0;
+    double averageMs = 0.0;
+    double maxMs = 0.0; // over the rolling window
+    uint64_t samples = 0;
+  };
+
+  // Ends its scope on destruction; inert when profiling is off
+  class Scope {
+  public:
+    Scope(GpuProfiler *profiler, uint32_t scope)
+        : m_profiler(profiler), m_scope(scope) {}
+    ~Scope() {
+      if (m_profiler)
+        m_profiler->_endScope(m_scope);
+    }
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+  private:
+    GpuProfiler *m_profiler;
+    uint32_t m_scope;
+  };
+
+private:
+  struct PassHistory {
+    std::array<float, HISTORY> samples{};
+    uint32_t cursor = 0;
+    uint32_t count = 0;
+  };
+
+  struct FrameSlot {
+    std::array<GLuint, 2 * MAX_SCOPES> queries{};
+    std::array<uint8_t, MAX_SCOPES> pass{};
+    uint32_t scopeCount = 0;
+    bool pending = false;
+  };
+
+  std::vector<PassStats> m_stats;
+  std::vector<PassHistory> m_history;
+  std::array<FrameSlot, FRAME_LATENCY> m_frames{};
+  uint32_t m_frame = 0;
+  uint64_t m_framesCollected = 0;
+  uint64_t m_framesDropped = 0;
+
+  bool m_supported = false;
+  bool m_enabled = true;
+  bool m_inFrame = false;
+
+public:
+  GpuProfiler();
+  ~GpuProfiler();
+  GpuProfiler(const GpuProfiler &) = delete;
+  GpuProfiler &operator=(const GpuProfiler &) = delete;
+
+  // Collects the oldest slot's results, then starts recording into it
+  void beginFrame();
+  void endFrame();
+
+  // name must outlive the profiler (a string literal)
+  [[nodiscard]] Scope scope(const char *name);
+
+  void setEnabled(bool enabled) { m_enabled = enabled; }
+  bool isEnabled() const { return m_enabled && m_supported; }
+  bool isSupported() const { return m_supported; }
+
+  std::span<const PassStats> getPasses() const { return m_stats; }
+
+  std::string toJson() const;
+  bool dumpJson(const std::filesystem::path &path) const;
+
+private:
+  uint32_t _passIndex(const char *name);
+  void _endScope(uint32_t scope);
+  void _collect(FrameSlot &slot);
+  void _record(uint32_t pass, double ms);
+};
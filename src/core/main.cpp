@@ -10,12 +10,22 @@
 
 #include <GLFW/glfw3.h>
 
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <filesystem>
+#include <print>
+#include <string_view>
+
 #include "app.hpp"
 
 #ifndef ASSETS_PATH
 #define ASSETS_PATH "./assets"
 #endif
 
+// Virtual time step between headless frames
+#define HEADLESS_FRAME_TIME (1.0 / 60.0)
+
 #ifndef SHADER_PATH
 #define SHADER_PATH ASSETS_PATH "/shader"
 #endif
@@ -25,7 +35,8 @@ void process_input(GLFWwindow *window) {
     glfwSetWindowShouldClose(window, 1);
 }
 
-GLFWwindow *initialize_window(int width, int height, const char *title) {
+GLFWwindow *initialize_window(int width, int height, const char *title,
+                              bool visible = true) {
   if (!glfwInit())
     exit(EXIT_FAILURE);
 
@@ -36,6 +47,9 @@ GLFWwindow *initialize_window(int width, int height, const char *title) {
   glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
   glfwWindowHint(GLFW_DEPTH_BITS, 24); // Add this before glfwCreateWindow
+  // Headless runs still need a context; under Xvfb + llvmpipe it is all
+  // software
+  glfwWindowHint(GLFW_VISIBLE, visible ? GLFW_TRUE : GLFW_FALSE);
   GLFWwindow *window = glfwCreateWindow(width, height, title, NULL, NULL);
   if (!window) {
     fprintf(stderr, "Failed to create GLFW window\n");
@@ -51,20 +65,195 @@ GLFWwindow *initialize_window(int width, int height, const char *title) {
   return window;
 }
 
+template <typename T> bool parse_number(std::string_view text, T &out) {
+  auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), out);
+  return ec == std::errc() && ptr == text.data() + text.size();
+}
+
+// Netplay:   --host <port> | --join <ip:port> [--port <port>] [--seed <n>]
+//            [--latency <ms>] [--jitter <ms>] [--loss <0..1>]
+// Spectator: --spectate-port <port> | --spectate-socket <path>
+// Profiling: --gpu-profile <path> | --trace <path>
+// Startup:   --cache <dir | off> | --assets <archive> | --font <ttf>
+// Display:   --idle <on | off> | --fps <n | vsync | uncapped>
+// Headless:  --headless <WxH> [--frames <n>] [--capture <dir>]
+//            [--capture-every <n>] [--capture-format <png | ppm>]
+//            [--autostart <seed>]
+LaunchOptions parse_launch_options(int argc, char *argv[]) {
+  LaunchOptions options;
+  options.cachePath = CACHE_PATH;
+  // The build and install both put the archive next to the executable
+  options.assetArchivePath =
+      (std::filesystem::path(argv[0]).parent_path() / "assets.pak").string();
+  NetplayConfig netplay;
+  SpectatorConfig spectator;
+  bool netplay_enabled = false;
+  bool spectator_enabled = false;
+  HeadlessConfig headless;
+  bool headless_enabled = false;
+
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string_view flag = argv[i];
+    std::string_view value = argv[i + 1];
+    bool ok = true;
+
+    if (flag == "--host") {
+      netplay_enabled = true;
+      netplay.localPlayer = 0;
+      ok = parse_number(value, netplay.localPort);
+    } else if (flag == "--join") {
+      netplay_enabled = true;
+      netplay.localPlayer = 1;
+      netplay.peer = UdpAddress::parse(value);
+      ok = netplay.peer.has_value();
+    } else if (flag == "--port") {
+      ok = parse_number(value, netplay.localPort);
+    } else if (flag == "--seed") {
+      ok = parse_number(value, netplay.seed);
+    } else if (flag == "--latency") {
+      ok = parse_number(value, netplay.link.latencyMs);
+    } else if (flag == "--jitter") {
+      ok = parse_number(value, netplay.link.jitterMs);
+    } else if (flag == "--loss") {
+      ok = parse_number(value, netplay.link.lossRate);
+    } else if (flag == "--spectate-port") {
+      spectator_enabled = true;
+      ok = parse_number(value, spectator.tcpPort);
+    } else if (flag == "--spectate-socket") {
+      spectator_enabled = true;
+      spectator.unixPath = value;
+    } else if (flag == "--gpu-profile") {
+      options.gpuProfilePath = std::string(value);
+    } else if (flag == "--trace") {
+      options.tracePath = std::string(value);
+    } else if (flag == "--cache") {
+      options.cachePath = value == "off" ? "" : std::string(value);
+    } else if (flag == "--assets") {
+      options.assetArchivePath = std::string(value);
+    } else if (flag == "--font") {
+      options.fontPath = std::string(value);
+    } else if (flag == "--fps") {
+      if (value == "vsync") {
+        options.pacing.mode = FramePacing::Mode::VSYNC;
+      } else if (value == "uncapped") {
+        options.pacing.mode = FramePacing::Mode::UNCAPPED;
+      } else {
+        options.pacing.mode = FramePacing::Mode::FIXED;
+        ok = parse_number(value, options.pacing.fps) && options.pacing.fps > 0;
+      }
+    } else if (flag == "--headless") {
+      headless_enabled = true;
+      size_t split = value.find('x');
+      ok = split != std::string_view::npos &&
+           parse_number(value.substr(0, split), headless.width) &&
+           parse_number(value.substr(split + 1), headless.height) &&
+           headless.width > 0 && headless.height > 0;
+    } else if (flag == "--frames") {
+      ok = parse_number(value, headless.frames);
+    } else if (flag == "--capture") {
+      headless.captureDir = value;
+    } else if (flag == "--capture-every") {
+      ok = parse_number(value, headless.captureEvery) &&
+           headless.captureEvery > 0;
+    } else if (flag == "--capture-format") {
+      ok = value == "png" || value == "ppm";
+      headless.format = value == "png" ? ImageFormat::PNG : ImageFormat::PPM;
+    } else if (flag == "--autostart") {
+      uint32_t seed = 0;
+      ok = parse_number(value, seed);
+      headless.autostartSeed = seed;
+    } else if (flag == "--idle") {
+      ok = value == "on" || value == "off";
+      options.idleRendering = value == "on";
+    } else {
+      ok = false;
+    }
+
+    if (!ok) {
+      fprintf(stderr, "Invalid argument: %s %s\n", argv[i], argv[i + 1]);
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  if (netplay_enabled)
+    options.netplay = netplay;
+  if (spectator_enabled)
+    options.spectator = spectator;
+  if (headless_enabled) {
+    options.headless = headless;
+    // Every frame is drawn; there is nothing to wait for
+    options.idleRendering = false;
+  }
+
+  return options;
+}
+
+// Renders the configured number of frames as fast as possible. The clock is
+// virtual (a fixed step per frame), so animations land on the same frames
+// every run and captures can be compared against golden images.
+void run_headless(GLFWwindow *window, App &application,
+                  const HeadlessConfig &config) {
+  auto start = std::chrono::steady_clock::now();
+
+  for (uint32_t frame = 0;
+       frame < config.frames && !glfwWindowShouldClose(window); ++frame) {
+    glfwSetTime(frame * HEADLESS_FRAME_TIME);
+
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    application.render(HEADLESS_FRAME_TIME);
+    application.present();
+    glfwPollEvents();
+  }
+  // Count the GPU's (or llvmpipe's) share of the last frames too
+  glFinish();
+
+  std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::println("Headless: {} frames at {}x{} in {:.1f} ms ({:.2f} ms/frame)",
+               config.frames, config.width, config.height, elapsed.count(),
+               elapsed.count() / std::max<uint32_t>(config.frames, 1));
+}
+
 //_________________________________________________MAIN______________________________________________________________//
 
 int main(int argc, char *argv[]) {
-  GLFWwindow *window = initialize_window(800, 600, "tetris 3D");
+  auto launch_time = std::chrono::steady_clock::now();
+  LaunchOptions options = parse_launch_options(argc, argv);
+  GLFWwindow *window =
+      options.headless
+          ? initialize_window(options.headless->width,
+                              options.headless->height, "tetris 3D", false)
+          : initialize_window(800, 600, "tetris 3D");
 
   double last_frame_time = glfwGetTime();
 
   {
-    App application(window);
+    App application(window, options);
+    if (options.headless) {
+      run_headless(window, application, *options.headless);
+      glfwSetWindowShouldClose(window, 1); // skip the interactive loop
+    }
+    bool first_frame = true;
+    bool resumed = false;
 
     while (!glfwWindowShouldClose(window)) {
+      // Nothing changed: sleep until an event or animation deadline
+      if (!application.needsFrame()) {
+        application.waitForChanges();
+        resumed = true;
+        continue;
+      }
+
       double current_frame_time = glfwGetTime();
       double delta_frame_time = current_frame_time - last_frame_time;
       last_frame_time = current_frame_time;
+      if (resumed) {
+        delta_frame_time =
+            std::min(delta_frame_time, FrameScheduler::RESUME_DELTA);
+        resumed = false;
+      }
 
       process_input(window); // global event (like closing the window)
 
@@ -72,9 +261,15 @@ int main(int argc, char *argv[]) {
       glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
       application.render(delta_frame_time);
-
-      glfwSwapBuffers(window);
+      application.present();
       glfwPollEvents();
+
+      if (first_frame) {
+        std::chrono::duration<double, std::milli> startup =
+            std::chrono::steady_clock::now() - launch_time;
+        std::println("Startup: first frame after {:.1f} ms", startup.count());
+        first_frame = false;
+      }
     }
   }
 
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+// A value that notifies its subscribers when set() changes it. Setting the
+// same value again costs one comparison, so it can be fed every frame.
+// Single-threaded: subscribers run inside set().
+template <typename T> class Observable {
+public:
+  using Callback = std::function<void(const T &)>;
+
+private:
+  T m_value{};
+  std::vector<Callback> m_subscribers;
+
+public:
+  Observable() = default;
+  explicit Observable(T value) : m_value(std::move(value)) {}
+
+  Observable(const Observable &) = delete;
+  Observable &operator=(const Observable &) = delete;
+
+  const T &get() const { return m_value; }
+
+  // True if the value changed
+  bool set(const T &value) {
+    if (value == m_value)
+      return false;
+
+    m_value = value;
+    for (const Callback &callback : m_subscribers)
+      callback(m_value);
+    return true;
+  }
+
+  // Runs callback once with the current value, then on every change
+  void subscribe(Callback callback) {
+    callback(m_value);
+    m_subscribers.push_back(std::move(callback));
+  }
+};
@@ -0,0 +1,236 @@
+#include "render_queue.hpp"
+
+#include "core/gl_state.hpp"
+#include "core/trace.hpp"
+
+#include <algorithm>
+#include <print>
+#include <utility>
+
+namespace {
+
+constexpr std::array<const char *, static_cast<size_t>(RenderPass::COUNT)>
+    PASS_NAMES = {"opaque", "transparent", "hud_background", "hud", "ui"};
+
+constexpr uint64_t DEPTH_BITS = 20;
+constexpr uint64_t DEPTH_MAX = (1u << DEPTH_BITS) - 1;
+
+uint64_t quantizeDepth(float depth) {
+  float t = std::clamp(depth / RenderQueue::MAX_DEPTH, 0.0f, 1.0f);
+  return static_cast<uint64_t>(t * DEPTH_MAX);
+}
+
+} // namespace
+
+RenderQueue::RenderQueue(GpuProfiler &profiler) : m_profiler(profiler) {
+  m_entries.reserve(1024);
+  m_scratch.reserve(1024);
+}
+
+uint64_t RenderQueue::makeKey(const DrawPacket &packet, uint32_t sequence) {
+  uint64_t pass = static_cast<uint64_t>(packet.pass) & 0xF;
+  uint64_t program = static_cast<uint64_t>(packet.material.shader) & 0xFF;
+  uint64_t texture = packet.material.texture & 0xFFFF;
+  uint64_t depth = quantizeDepth(packet.depth);
+  uint64_t seq = sequence & 0xFFFF;
+
+  switch (packet.pass) {
+  case RenderPass::TRANSPARENT:
+    return pass << 60 | (DEPTH_MAX - depth) << 40 | program << 32 |
+           texture << 16 | seq;
+  case RenderPass::HUD_BACKGROUND:
+  case RenderPass::UI:
+    return pass << 60 | seq;
+  default:
+    return pass << 60 | program << 52 | texture << 36 | depth << 16 | seq;
+  }
+}
+
+void RenderQueue::submit(const DrawPacket &packet) {
+  std::span<DrawPacket> slot = m_arena.allocate<DrawPacket>();
+  if (slot.empty()) {
+    if (!m_warnedFull) {
+      std::println("RenderQueue: {} byte arena is full", ARENA_SIZE);
+      m_warnedFull = true;
+    }
+    return;
+  }
+
+  slot[0] = packet;
+  uint32_t sequence = static_cast<uint32_t>(m_entries.size());
+  m_entries.push_back({makeKey(packet, sequence), slot.data()});
+}
+
+void RenderQueue::execute() {
+  TRACE_SCOPE("RenderQueue::execute");
+  _sort();
+
+  size_t i = 0;
+  while (i < m_entries.size()) {
+    RenderPass pass = m_entries[i].packet->pass;
+    const char *name = PASS_NAMES[static_cast<size_t>(pass)];
+
+    TRACE_SCOPE(name);
+    auto scope = m_profiler.scope(name);
+    _beginPass(pass);
+
+    for (; i < m_entries.size() && m_entries[i].packet->pass == pass; ++i)
+      _draw(*m_entries[i].packet);
+  }
+
+  m_lastPacketCount = static_cast<uint32_t>(m_entries.size());
+  m_entries.clear();
+  m_arena.reset();
+}
+
+// LSD radix sort on bytes. Digits every key shares (unused pass bits,
+// empty depth in the flat passes) are detected from the histogram and
+// skipped, so a typical frame takes only a few passes.
+void RenderQueue::_sort() {
+  size_t count = m_entries.size();
+  if (count < 2)
+    return;
+
+  m_scratch.resize(count);
+
+  for (int shift = 0; shift < 64; shift += 8) {
+    std::array<size_t, 256> offsets{};
+    for (const Entry &entry : m_entries)
+      ++offsets[(entry.key >> shift) & 0xFF];
+
+    if (std::ranges::find(offsets, count) != offsets.end())
+      continue;
+
+    size_t sum = 0;
+    for (size_t &offset : offsets)
+      sum += std::exchange(offset, sum);
+
+    for (const Entry &entry : m_entries)
+      m_scratch[offsets[(entry.key >> shift) & 0xFF]++] = entry;
+
+    m_entries.swap(m_scratch);
+  }
+}
+
+void RenderQueue::_beginPass(RenderPass pass) {
+  switch (pass) {
+  case RenderPass::OPAQUE:
+    // Still blended: clearing layers fade out inside the stack mesh
+    GLState::setDepthTest(true);
+    GLState::setDepthMask(true);
+    GLState::setBlend(true);
+    GLState::setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    break;
+
+  case RenderPass::TRANSPARENT:
+    GLState::setDepthTest(true);
+    GLState::setDepthMask(false);
+    GLState::setBlend(true);
+    GLState::setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    break;
+
+  case RenderPass::HUD:
+    // The previews sit over the board; the hold and queue boxes never
+    // overlap, so one depth clear serves all of them
+    GLState::setDepthMask(true);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    GLState::setDepthTest(true);
+    GLState::setBlend(false);
+    GLState::setCullFace(false);
+    break;
+
+  case RenderPass::HUD_BACKGROUND:
+  case RenderPass::UI:
+    GLState::setDepthTest(false);
+    GLState::setBlend(true);
+    GLState::setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    break;
+
+  case RenderPass::COUNT:
+    break;
+  }
+}
+
+void RenderQueue::_applyMaterial(const DrawPacket &packet) {
+  const Material &material = packet.material;
+  const Shader &shader = ShaderManager::getShader(material.shader);
+  GLState::useProgram(shader);
+
+  if (material.texture != 0)
+    GLState::bindTexture(0, material.texture);
+
+  switch (material.shader) {
+  case ShaderType::TETROMINO: {
+    const TetrominoUniforms &uniforms = ShaderManager::getTetrominoUniforms();
+    UniformCache &cache = m_tetrominoCache;
+    uint8_t changed = cache.valid ? cache.flags ^ material.flags : 0xFF;
+
+    if (changed & Material::INSTANCED)
+      shader.set(uniforms.instanced,
+                 (material.flags & Material::INSTANCED) != 0);
+    if (changed & Material::STACK_MESH)
+      shader.set(uniforms.stackMesh,
+                 (material.flags & Material::STACK_MESH) != 0);
+    if (changed & Material::HUD)
+      shader.set(uniforms.hud, (material.flags & Material::HUD) != 0);
+    if (changed & Material::GHOST)
+      shader.set(uniforms.isGhost, (material.flags & Material::GHOST) != 0);
+    if (!cache.valid || cache.color != material.color)
+      shader.set(uniforms.color, material.color);
+    if (!cache.valid || cache.model != packet.model)
+      shader.set(uniforms.model, packet.model);
+
+    cache = {true, material.flags, material.color, packet.model};
+    break;
+  }
+
+  case ShaderType::UI: {
+    const UIUniforms &uniforms = ShaderManager::getUIUniforms();
+    UniformCache &cache = m_uiCache;
+    if (!cache.valid)
+      shader.set(uniforms.icon, 0);
+    if (!cache.valid || ((cache.flags ^ material.flags) & Material::HUD))
+      shader.set(uniforms.hud, (material.flags & Material::HUD) != 0);
+
+    cache.valid = true;
+    cache.flags = material.flags;
+    break;
+  }
+  }
+}
+
+void RenderQueue::_draw(const DrawPacket &packet) {
+  _applyMaterial(packet);
+  GLState::bindVertexArray(packet.vao);
+
+  if (packet.vertexBuffer != 0 &&
+      (m_vertexBinding.vao != packet.vao ||
+       m_vertexBinding.buffer != packet.vertexBuffer ||
+       m_vertexBinding.offset != packet.vertexOffset)) {
+    glVertexArrayVertexBuffer(packet.vao, 0, packet.vertexBuffer,
+                              packet.vertexOffset, packet.vertexStride);
+    m_vertexBinding = {packet.vao, packet.vertexBuffer, packet.vertexOffset};
+  }
+
+  if (packet.storageBuffer != 0) {
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, packet.storageBinding,
+                      packet.storageBuffer, packet.storageOffset,
+                      packet.storageSize);
+  }
+
+  if (packet.indexType != 0) {
+    const void *indices = reinterpret_cast<const void *>(
+        static_cast<uintptr_t>(packet.first));
+    if (packet.instanceCount > 0)
+      glDrawElementsInstanced(packet.primitive, packet.count, packet.indexType,
+                              indices, packet.instanceCount);
+    else
+      glDrawElements(packet.primitive, packet.count, packet.indexType,
+                     indices);
+  } else if (packet.instanceCount > 0) {
+    glDrawArraysInstanced(packet.primitive, packet.first, packet.count,
+                          packet.instanceCount);
+  } else {
+    glDrawArrays(packet.primitive, packet.first, packet.count);
+  }
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "core/frame_arena.hpp"
+#include "core/gpu_profiler.hpp"
+#include "core/shader_manager.hpp"
+#include "glad/gl.h"
+
+#include <array>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+// Executed in this order; each pass sets up its own GL state
+enum class RenderPass : uint8_t {
+  OPAQUE,         // board stack and active piece, front to back
+  TRANSPARENT,    // grid lines and ghost, back to front, no depth writes
+  HUD_BACKGROUND, // preview borders, flat and in submission order
+  HUD,            // 3D previews over a cleared depth buffer
+  UI,             // screen-space sprites, in submission order
+  COUNT
+};
+
+struct Material {
+  enum Flag : uint8_t {
+    INSTANCED = 1 << 0,  // cells from the instance SSBO
+    STACK_MESH = 1 << 1, // pre-baked world-space stack vertices
+    HUD = 1 << 2,        // FrameData::hudProjection instead of the camera
+    GHOST = 1 << 3,
+  };
+
+  ShaderType shader = ShaderType::TETROMINO;
+  GLuint texture = 0; // bound to unit 0, 0 for none
+  uint8_t flags = 0;
+  glm::vec4 color{1.0f};
+};
+
+// Everything needed to issue one draw, with no GL calls at build time
+struct DrawPacket {
+  RenderPass pass = RenderPass::OPAQUE;
+  Material material;
+  glm::mat4 model{1.0f};
+  float depth = 0.0f; // distance from the camera, orders the 3D passes
+
+  GLuint vao = 0;
+  GLenum primitive = GL_TRIANGLES;
+  GLint first = 0;           // first vertex, or byte offset of the indices
+  GLsizei count = 0;
+  GLsizei instanceCount = 0; // 0 for a plain draw
+  GLenum indexType = 0;      // 0 for non-indexed
+
+  // Optional replacement of the VAO's vertex buffer binding 0
+  GLuint vertexBuffer = 0;
+  GLintptr vertexOffset = 0;
+  GLsizei vertexStride = 0;
+
+  // Optional shader storage range
+  GLuint storageBuffer = 0;
+  GLuint storageBinding = 0;
+  GLintptr storageOffset = 0;
+  GLsizeiptr storageSize = 0;
+};
+
+// Renderers submit DrawPackets while building the frame; execute() sorts
+// them by a 64-bit key and issues them in one loop, so GL state changes
+// follow the sort order instead of the order the game happens to draw in.
+//
+// Key, most significant first:
+//   pass (4) | program (8) | texture (16) | depth (20) | sequence (16)
+// TRANSPARENT swaps in inverted depth above program and texture to draw
+// back to front; HUD_BACKGROUND and UI keep only the sequence, so they are
+// painted in submission order.
+class RenderQueue {
+public:
+  static constexpr size_t ARENA_SIZE = 1 << 20;
+  static constexpr float MAX_DEPTH = 200.0f; // quantization range
+
+private:
+  struct Entry {
+    uint64_t key;
+    const DrawPacket *packet;
+  };
+
+  // Last values pushed to each program, to skip redundant uniform writes
+  struct UniformCache {
+    bool valid = false;
+    uint8_t flags = 0;
+    glm::vec4 color{0.0f};
+    glm::mat4 model{0.0f};
+  };
+
+  FrameArena m_arena{ARENA_SIZE};
+  std::vector<Entry> m_entries;
+  std::vector<Entry> m_scratch;
+  GpuProfiler &m_profiler;
+
+  UniformCache m_tetrominoCache;
+  UniformCache m_uiCache;
+  struct {
+    GLuint vao, buffer;
+    GLintptr offset;
+  } m_vertexBinding{};
+
+  uint32_t m_lastPacketCount = 0;
+  bool m_warnedFull = false;
+
+public:
+  explicit RenderQueue(GpuProfiler &profiler);
+
+  void submit(const DrawPacket &packet);
+
+  // Sorts, draws and then clears everything submitted this frame
+  void execute();
+
+  uint32_t getLastPacketCount() const { return m_lastPacketCount; }
+
+  static uint64_t makeKey(const DrawPacket &packet, uint32_t sequence);
+
+private:
+  void _sort();
+  void _beginPass(RenderPass pass);
+  void _applyMaterial(const DrawPacket &packet);
+  void _draw(const DrawPacket &packet);
+};
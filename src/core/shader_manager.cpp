@@ -1,17 +1,228 @@
 #include "shader_manager.hpp"
+#include "core/asset_archive.hpp"
+#include "core/trace.hpp"
+
+#include <chrono>
+#include <format>
+#include <fstream>
+#include <initializer_list>
 #include <memory>
+#include <print>
+#include <system_error>
 #include <unordered_map>
+#include <vector>
 
 std::unordered_map<ShaderType, std::unique_ptr<Shader>> ShaderManager::shaders;
+TetrominoUniforms ShaderManager::s_tetrominoUniforms;
+UIUniforms ShaderManager::s_uiUniforms;
+std::filesystem::path ShaderManager::s_cacheDirectory;
 
-Shader &ShaderManager::loadShader(ShaderType type, const char *vertShaderPath,
-                                  const char *fragShaderPath) {
-  ShaderManager::shaders[type] =
-      std::make_unique<Shader>(Shader(vertShaderPath, fragShaderPath));
+namespace {
 
-  return *ShaderManager::shaders.at(type);
+constexpr uint32_t CACHE_MAGIC = 0x42503354; // "T3PB"
+constexpr uint32_t CACHE_VERSION = 1;
+
+struct CacheHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t key;
+  uint32_t format;
+  uint32_t length;
+};
+
+const char *typeName(ShaderType type) {
+  switch (type) {
+  case ShaderType::TETROMINO:
+    return "tetromino";
+  case ShaderType::UI:
+    return "ui";
+  }
+  return "unknown";
+}
+
+// Defines must follow #version, which has to be the first line
+void injectDefines(std::string &source, std::string_view defines) {
+  if (defines.empty())
+    return;
+
+  size_t line_end = source.find('\n');
+  size_t at = line_end == std::string::npos ? source.size() : line_end + 1;
+  source.insert(at, std::format("{}\n", defines));
+}
+
+// FNV-1a, every part terminated so "ab"+"c" and "a"+"bc" differ
+uint64_t hashParts(std::initializer_list<std::string_view> parts) {
+  uint64_t hash = 14695981039346656037ull;
+  for (std::string_view part : parts) {
+    for (char c : part) {
+      hash ^= static_cast<unsigned char>(c);
+      hash *= 1099511628211ull;
+    }
+    hash ^= 0xFF;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+std::string_view glString(GLenum name) {
+  const GLubyte *value = glGetString(name);
+  return value ? reinterpret_cast<const char *>(value) : "";
+}
+
+bool binariesSupported() {
+  GLint formats = 0;
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+  return formats > 0;
+}
+
+} // namespace
+
+void TetrominoUniforms::resolve(const Shader &shader) {
+  model = shader.uniform<glm::mat4>("u_model");
+  color = shader.uniform<glm::vec4>("u_color");
+  isGhost = shader.uniform<bool>("u_isGhost");
+  instanced = shader.uniform<bool>("u_instanced");
+  stackMesh = shader.uniform<bool>("u_stackMesh");
+  hud = shader.uniform<bool>("u_hud");
+}
+
+void UIUniforms::resolve(const Shader &shader) {
+  hud = shader.uniform<bool>("u_hud");
+  icon = shader.uniform<int>("u_icon");
+}
+
+void ShaderManager::setCacheDirectory(std::filesystem::path directory) {
+  s_cacheDirectory = std::move(directory);
+}
+
+Shader &ShaderManager::loadShader(ShaderType type, const char *vertShaderAsset,
+                                  const char *fragShaderAsset,
+                                  std::string_view defines) {
+  TRACE_SCOPE("ShaderManager::loadShader");
+  auto start = std::chrono::steady_clock::now();
+
+  // Copied out of the archive, the defines are spliced into the source
+  std::string vertexCode(AssetManager::loadText(vertShaderAsset));
+  std::string fragmentCode(AssetManager::loadText(fragShaderAsset));
+  injectDefines(vertexCode, defines);
+  injectDefines(fragmentCode, defines);
+
+  bool use_cache = !s_cacheDirectory.empty() && binariesSupported();
+  uint64_t key = hashParts({glString(GL_VENDOR), glString(GL_RENDERER),
+                            glString(GL_VERSION), vertexCode, fragmentCode,
+                            defines});
+  std::filesystem::path cache_path =
+      s_cacheDirectory / std::format("{}-{:016x}.bin", typeName(type), key);
+
+  GLuint program = use_cache ? _loadBinary(cache_path, key) : 0;
+  bool cached = program != 0;
+  if (cached) {
+    ShaderManager::shaders[type] =
+        std::make_unique<Shader>(Shader::fromProgram(program));
+  } else {
+    ShaderManager::shaders[type] = std::make_unique<Shader>(
+        Shader::fromSource(vertexCode, fragmentCode));
+    if (use_cache)
+      _storeBinary(cache_path, key, ShaderManager::shaders.at(type)->ID);
+  }
+  Shader &shader = *ShaderManager::shaders.at(type);
+
+  std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::println("ShaderManager: {} {} in {:.1f} ms", typeName(type),
+               cached ? "loaded from cache" : "compiled", elapsed.count());
+
+  switch (type) {
+  case ShaderType::TETROMINO:
+    s_tetrominoUniforms.resolve(shader);
+    break;
+  case ShaderType::UI:
+    s_uiUniforms.resolve(shader);
+    break;
+  }
+
+  return shader;
 }
 
 Shader &ShaderManager::getShader(ShaderType type) {
   return *ShaderManager::shaders.at(type);
 }
+
+GLuint ShaderManager::_loadBinary(const std::filesystem::path &path,
+                                  uint64_t key) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file)
+    return 0;
+
+  CacheHeader header{};
+  file.read(reinterpret_cast<char *>(&header), sizeof(header));
+  if (!file || header.magic != CACHE_MAGIC ||
+      header.version != CACHE_VERSION || header.key != key)
+    return 0;
+
+  std::vector<char> binary(header.length);
+  file.read(binary.data(), binary.size());
+  if (!file)
+    return 0;
+
+  GLuint program = glCreateProgram();
+  glProgramBinary(program, header.format, binary.data(),
+                  static_cast<GLsizei>(binary.size()));
+
+  // Drivers may reject binaries from an older build of themselves
+  GLint linked = GL_FALSE;
+  glGetProgramiv(program, GL_LINK_STATUS, &linked);
+  if (!linked) {
+    std::println("ShaderManager: cached {} rejected, recompiling",
+                 path.string());
+    glDeleteProgram(program);
+    return 0;
+  }
+
+  return program;
+}
+
+void ShaderManager::_storeBinary(const std::filesystem::path &path,
+                                 uint64_t key, GLuint program) {
+  GLint length = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0)
+    return;
+
+  std::vector<char> binary(length);
+  GLenum format = 0;
+  glGetProgramBinary(program, length, nullptr, &format, binary.data());
+
+  std::error_code error;
+  std::filesystem::create_directories(path.parent_path(), error);
+
+  // Binaries for older sources or drivers can never match again
+  std::string prefix = path.filename().string();
+  prefix.resize(prefix.find('-') + 1);
+  for (const auto &entry :
+       std::filesystem::directory_iterator(path.parent_path(), error)) {
+    std::string name = entry.path().filename().string();
+    if (name.starts_with(prefix) && entry.path() != path)
+      std::filesystem::remove(entry.path(), error);
+  }
+
+  // Written under a temporary name so a crash never leaves half a binary
+  std::filesystem::path temp = path;
+  temp += ".tmp";
+  {
+    std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+    CacheHeader header{CACHE_MAGIC, CACHE_VERSION, key, format,
+                       static_cast<uint32_t>(length)};
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(binary.data(), binary.size());
+    if (!file) {
+      std::println("ShaderManager: cannot write {}", temp.string());
+      return;
+    }
+  }
+
+  std::filesystem::rename(temp, path, error);
+  if (error)
+    std::println("ShaderManager: cannot write {}: {}", path.string(),
+                 error.message());
+}
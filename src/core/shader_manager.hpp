@@ -1,17 +1,65 @@
 #pragma once
 
 #include "shader.h"
+#include <cstdint>
+#include <filesystem>
 #include <memory>
+#include <string>
+#include <string_view>
 #include <unordered_map>
 
 enum class ShaderType { TETROMINO, UI };
 
+// Pre-resolved uniforms of each shader, filled when the shader is loaded.
+// Camera matrices and time come from the FrameData block instead.
+struct TetrominoUniforms {
+  Uniform<glm::mat4> model;
+  Uniform<glm::vec4> color;
+  Uniform<bool> isGhost;
+  Uniform<bool> instanced;
+  Uniform<bool> stackMesh;
+  Uniform<bool> hud;
+
+  void resolve(const Shader &shader);
+};
+
+struct UIUniforms {
+  Uniform<bool> hud;
+  Uniform<int> icon;
+
+  void resolve(const Shader &shader);
+};
+
+// Linked programs are cached on disk with glGetProgramBinary. The cache key
+// hashes both sources, the defines and the driver's vendor / renderer /
+// version strings, so editing a shader or updating the driver recompiles.
+// A binary the driver rejects falls back to compiling from source.
 class ShaderManager {
 public:
   static std::unordered_map<ShaderType, std::unique_ptr<Shader>> shaders;
 
-  static Shader &loadShader(ShaderType type, const char *vertShaderPath,
-                            const char *fragShaderPath);
+  // An empty directory disables the cache
+  static void setCacheDirectory(std::filesystem::path directory);
+
+  // Stages are AssetManager names; defines are inserted after the #version
+  // line of both
+  static Shader &loadShader(ShaderType type, const char *vertShaderAsset,
+                            const char *fragShaderAsset,
+                            std::string_view defines = {});
 
   static Shader &getShader(ShaderType type);
+
+  static const TetrominoUniforms &getTetrominoUniforms() {
+    return s_tetrominoUniforms;
+  }
+  static const UIUniforms &getUIUniforms() { return s_uiUniforms; }
+
+private:
+  static TetrominoUniforms s_tetrominoUniforms;
+  static UIUniforms s_uiUniforms;
+  static std::filesystem::path s_cacheDirectory;
+
+  static GLuint _loadBinary(const std::filesystem::path &path, uint64_t key);
+  static void _storeBinary(const std::filesystem::path &path, uint64_t key,
+                           GLuint program);
 };
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <utility>
+
+// Lock-free bounded queue for exactly one producer thread and one consumer
+// thread. Head and tail live on separate cache lines so the two sides never
+// contend on the same line.
+template <typename T, size_t Capacity> class SpscQueue {
+  static_assert((Capacity & (Capacity - 1)) == 0,
+                "SpscQueue capacity must be a power of two");
+
+private:
+  std::array<T, Capacity> m_items{};
+  alignas(64) std::atomic<size_t> m_head{0}; // written by the consumer
+  alignas(64) std::atomic<size_t> m_tail{0}; // written by the producer
+
+public:
+  // Producer side; fails when the queue is full. Items are moved through,
+  // so buffers can be handed over without copying.
+  bool push(T item) {
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+    if (tail - m_head.load(std::memory_order_acquire) == Capacity)
+      return false;
+
+    m_items[tail & (Capacity - 1)] = std::move(item);
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side
+  std::optional<T> pop() {
+    size_t head = m_head.load(std::memory_order_relaxed);
+    if (head == m_tail.load(std::memory_order_acquire))
+      return std::nullopt;
+
+    T item = std::move(m_items[head & (Capacity - 1)]);
+    m_head.store(head + 1, std::memory_order_release);
+    return item;
+  }
+};
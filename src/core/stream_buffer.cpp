@@ -0,0 +1,125 @@
+#include "stream_buffer.hpp"
+
+#include <algorithm>
+#include <print>
+
+namespace {
+constexpr GLbitfield MAP_FLAGS =
+    GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+// One second per wait before warning, the driver should never need that
+constexpr GLuint64 FENCE_TIMEOUT_NS = 1'000'000'000;
+
+GLsizeiptr align_up(GLsizeiptr value, GLsizeiptr alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+} // namespace
+
+StreamBuffer::StreamBuffer(GLsizeiptr region_size)
+    : m_regionSize(region_size) {
+  GLint uniform_alignment = 0;
+  GLint storage_alignment = 0;
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniform_alignment);
+  glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storage_alignment);
+  m_uniformAlignment = std::max<GLsizeiptr>(uniform_alignment, 1);
+  m_storageAlignment = std::max<GLsizeiptr>(storage_alignment, 1);
+
+  // Keep every region start aligned for any kind of binding
+  m_regionSize = align_up(m_regionSize,
+                          std::max(m_uniformAlignment, m_storageAlignment));
+
+  GLsizeiptr total = m_regionSize * REGION_COUNT;
+  glCreateBuffers(1, &m_buffer);
+  glNamedBufferStorage(m_buffer, total, nullptr, MAP_FLAGS);
+  m_mapped = static_cast<std::byte *>(
+      glMapNamedBufferRange(m_buffer, 0, total, MAP_FLAGS));
+
+  if (!m_mapped)
+    std::println("StreamBuffer: failed to map {} bytes", total);
+}
+
+StreamBuffer::~StreamBuffer() {
+  for (GLsync fence : m_fences) {
+    if (fence)
+      glDeleteSync(fence);
+  }
+  glUnmapNamedBuffer(m_buffer);
+  glDeleteBuffers(1, &m_buffer);
+}
+
+void StreamBuffer::beginFrame() {
+  m_region = (m_region + 1) % REGION_COUNT;
+  m_head = 0;
+  m_reserved = false;
+
+  GLsync &fence = m_fences[m_region];
+  if (!fence)
+    return;
+
+  GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+  while (true) {
+    GLenum result = glClientWaitSync(fence, flags, FENCE_TIMEOUT_NS);
+    if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED)
+      break;
+    if (result == GL_WAIT_FAILED) {
+      std::println("StreamBuffer: fence wait failed");
+      break;
+    }
+    std::println("StreamBuffer: still waiting for region {}", m_region);
+    flags = 0;
+  }
+
+  glDeleteSync(fence);
+  fence = nullptr;
+}
+
+void StreamBuffer::endFrame() {
+  GLsync &fence = m_fences[m_region];
+  if (fence)
+    glDeleteSync(fence);
+  fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+StreamBuffer::Allocation StreamBuffer::allocate(GLsizeiptr size,
+                                                GLsizeiptr alignment) {
+  Allocation allocation = _carve(size, size, alignment);
+  if (allocation)
+    m_head = allocation.offset - _regionStart() + allocation.size;
+  return allocation;
+}
+
+StreamBuffer::Allocation StreamBuffer::reserve(GLsizeiptr max_size,
+                                               GLsizeiptr alignment) {
+  Allocation reservation = _carve(1, max_size, alignment);
+  m_reserved = static_cast<bool>(reservation);
+  return reservation;
+}
+
+void StreamBuffer::commit(const Allocation &reservation, GLsizeiptr used) {
+  if (!m_reserved || !reservation)
+    return;
+
+  m_head = reservation.offset - _regionStart() +
+           std::min(used, reservation.size);
+  m_reserved = false;
+}
+
+StreamBuffer::Allocation StreamBuffer::_carve(GLsizeiptr min_size,
+                                              GLsizeiptr max_size,
+                                              GLsizeiptr alignment) {
+  if (!m_mapped || m_reserved)
+    return {};
+
+  GLsizeiptr start = align_up(m_head, alignment);
+  GLsizeiptr available = m_regionSize - std::min(start, m_regionSize);
+  if (available < min_size) {
+    if (!m_warnedFull) {
+      std::println("StreamBuffer: {} byte region exhausted", m_regionSize);
+      m_warnedFull = true;
+    }
+    return {};
+  }
+
+  GLintptr offset = _regionStart() + start;
+  return {m_mapped + offset, m_buffer, offset, std::min(max_size, available)};
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "glad/gl.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+// Persistently mapped ring for data rewritten every frame (instances, UI
+// quads, uniforms). The buffer is split into REGION_COUNT regions; each
+// frame writes into one region while the GPU may still read the others, and
+// a fence per region stops the CPU from overwriting data still in flight.
+class StreamBuffer {
+public:
+  static constexpr uint32_t REGION_COUNT = 3;
+  static constexpr GLsizeiptr DEFAULT_REGION_SIZE = 2 * 1024 * 1024;
+  static constexpr GLsizeiptr DEFAULT_ALIGNMENT = 16;
+
+  struct Allocation {
+    std::byte *data = nullptr;
+    GLuint buffer = 0;
+    GLintptr offset = 0; // from the start of buffer, for binding
+    GLsizeiptr size = 0;
+
+    explicit operator bool() const { return data != nullptr; }
+
+    template <typename T> std::span<T> as() const {
+      return {reinterpret_cast<T *>(data), size / sizeof(T)};
+    }
+  };
+
+private:
+  GLuint m_buffer = 0;
+  std::byte *m_mapped = nullptr;
+  GLsizeiptr m_regionSize;
+
+  std::array<GLsync, REGION_COUNT> m_fences{};
+  uint32_t m_region = 0;
+  GLsizeiptr m_head = 0; // bytes used in the current region
+  bool m_reserved = false;
+  bool m_warnedFull = false;
+
+  GLsizeiptr m_uniformAlignment = DEFAULT_ALIGNMENT;
+  GLsizeiptr m_storageAlignment = DEFAULT_ALIGNMENT;
+
+public:
+  explicit StreamBuffer(GLsizeiptr region_size = DEFAULT_REGION_SIZE);
+  ~StreamBuffer();
+  StreamBuffer(const StreamBuffer &) = delete;
+  StreamBuffer &operator=(const StreamBuffer &) = delete;
+
+  // Moves to the next region, waiting for the GPU if it still reads it
+  void beginFrame();
+  // Fences everything issued this frame from the current region
+  void endFrame();
+
+  // Returns an empty Allocation when the region is exhausted
+  Allocation allocate(GLsizeiptr size,
+                      GLsizeiptr alignment = DEFAULT_ALIGNMENT);
+
+  // Open-ended allocation of up to max_size bytes, for writers that do not
+  // know their size up front. Only one reservation may be open at a time;
+  // commit() keeps the first `used` bytes and returns the rest.
+  Allocation reserve(GLsizeiptr max_size,
+                     GLsizeiptr alignment = DEFAULT_ALIGNMENT);
+  void commit(const Allocation &reservation, GLsizeiptr used);
+
+  GLuint getBuffer() const { return m_buffer; }
+  GLsizeiptr getUniformAlignment() const { return m_uniformAlignment; }
+  GLsizeiptr getStorageAlignment() const { return m_storageAlignment; }
+  GLsizeiptr getFrameUsage() const { return m_head; }
+
+private:
+  Allocation _carve(GLsizeiptr min_size, GLsizeiptr max_size,
+                    GLsizeiptr alignment);
+  GLintptr _regionStart() const { return m_region * m_regionSize; }
+};
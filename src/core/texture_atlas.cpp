@@ -0,0 +1,187 @@
+#include "texture_atlas.hpp"
+#include "core/asset_archive.hpp"
+#include "core/texture_manager.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <print>
+
+RectPacker::RectPacker(int width, int height)
+    : m_width(width), m_height(height) {
+  reset();
+}
+
+void RectPacker::reset() {
+  m_skyline.clear();
+  m_skyline.push_back({0, 0, m_width});
+}
+
+int RectPacker::_fit(size_t index, int width, int height) const {
+  int x = m_skyline[index].x;
+  if (x + width > m_width)
+    return -1;
+
+  // The rectangle rests on the highest segment it spans
+  int y = 0;
+  int remaining = width;
+  for (size_t i = index; remaining > 0; ++i) {
+    if (i == m_skyline.size())
+      return -1;
+    y = std::max(y, m_skyline[i].y);
+    if (y + height > m_height)
+      return -1;
+    remaining -= m_skyline[i].width;
+  }
+  return y;
+}
+
+std::optional<glm::ivec2> RectPacker::pack(int width, int height) {
+  int best_y = INT_MAX;
+  int best_width = INT_MAX;
+  size_t best_index = 0;
+
+  // Lowest placement wins, narrower segment breaks ties
+  for (size_t i = 0; i < m_skyline.size(); ++i) {
+    int y = _fit(i, width, height);
+    if (y < 0)
+      continue;
+    if (y + height < best_y ||
+        (y + height == best_y && m_skyline[i].width < best_width)) {
+      best_y = y + height;
+      best_width = m_skyline[i].width;
+      best_index = i;
+    }
+  }
+
+  if (best_y == INT_MAX)
+    return std::nullopt;
+
+  glm::ivec2 position(m_skyline[best_index].x, best_y - height);
+
+  // Raise the skyline under the new rectangle, trimming what it covers
+  Segment placed{position.x, best_y, width};
+  m_skyline.insert(m_skyline.begin() + best_index, placed);
+
+  for (size_t i = best_index + 1; i < m_skyline.size();) {
+    Segment &segment = m_skyline[i];
+    int covered = placed.x + placed.width - segment.x;
+    if (covered <= 0)
+      break;
+    if (covered < segment.width) {
+      segment.x += covered;
+      segment.width -= covered;
+      break;
+    }
+    m_skyline.erase(m_skyline.begin() + i);
+  }
+
+  // Merge neighbours of equal height
+  for (size_t i = 0; i + 1 < m_skyline.size();) {
+    if (m_skyline[i].y == m_skyline[i + 1].y) {
+      m_skyline[i].width += m_skyline[i + 1].width;
+      m_skyline.erase(m_skyline.begin() + i + 1);
+    } else {
+      ++i;
+    }
+  }
+
+  return position;
+}
+
+TextureAtlas::~TextureAtlas() { clear(); }
+
+void TextureAtlas::clear() {
+  for (Page &page : m_pages)
+    glDeleteTextures(1, &page.texture);
+  m_pages.clear();
+}
+
+TextureAtlas::Page &TextureAtlas::_newPage() {
+  GLuint texture;
+  glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+  glTextureStorage2D(texture, 1, GL_RGBA8, PAGE_SIZE, PAGE_SIZE);
+
+  // Padding has to read as transparent
+  const unsigned char clear[4] = {0, 0, 0, 0};
+  glClearTexImage(texture, 0, GL_RGBA, GL_UNSIGNED_BYTE, clear);
+
+  // No mipmaps, they would bleed between images. Linear both ways: the
+  // font's distance field must be interpolated to stay sharp when magnified.
+  glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+  return m_pages.emplace_back(Page{texture, RectPacker(PAGE_SIZE, PAGE_SIZE)});
+}
+
+AtlasRegion TextureAtlas::add(int width, int height,
+                              std::span<const unsigned char> rgba) {
+  int padded_width = width + 2 * PADDING;
+  int padded_height = height + 2 * PADDING;
+  if (padded_width > PAGE_SIZE || padded_height > PAGE_SIZE ||
+      rgba.size() < static_cast<size_t>(width) * height * 4) {
+    std::println("TextureAtlas: {}x{} image does not fit a page", width,
+                 height);
+    return {};
+  }
+
+  Page *page = nullptr;
+  std::optional<glm::ivec2> position;
+  for (Page &candidate : m_pages) {
+    position = candidate.packer.pack(padded_width, padded_height);
+    if (position) {
+      page = &candidate;
+      break;
+    }
+  }
+  if (!page) {
+    page = &_newPage();
+    position = page->packer.pack(padded_width, padded_height);
+  }
+
+  glm::ivec2 origin = *position + glm::ivec2(PADDING);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glTextureSubImage2D(page->texture, 0, origin.x, origin.y, width, height,
+                      GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+
+  float texel = 1.0f / PAGE_SIZE;
+  return {page->texture, glm::vec2(origin) * texel,
+          glm::vec2(origin + glm::ivec2(width, height)) * texel,
+          glm::ivec2(width, height)};
+}
+
+AtlasRegion TextureAtlas::addImage(std::string_view asset, bool flip) {
+  DecodedImage image = Texture::decode(AssetManager::load(asset), flip);
+  if (!image.pixels) {
+    std::println("TextureAtlas: failed to load {}", asset);
+    return {};
+  }
+
+  // Expand to RGBA; grey and grey+alpha images become white-tinted
+  size_t texels = static_cast<size_t>(image.width) * image.height;
+  std::vector<unsigned char> rgba(texels * 4);
+  const unsigned char *src = image.pixels.get();
+  for (size_t i = 0; i < texels; ++i, src += image.components) {
+    unsigned char *dst = &rgba[i * 4];
+    switch (image.components) {
+    case 1:
+      dst[0] = dst[1] = dst[2] = src[0];
+      dst[3] = 255;
+      break;
+    case 2:
+      dst[0] = dst[1] = dst[2] = src[0];
+      dst[3] = src[1];
+      break;
+    case 3:
+      dst[0] = src[0], dst[1] = src[1], dst[2] = src[2];
+      dst[3] = 255;
+      break;
+    default:
+      std::copy_n(src, 4, dst);
+      break;
+    }
+  }
+
+  return add(image.width, image.height, rgba);
+}
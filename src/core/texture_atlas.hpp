@@ -0,0 +1,86 @@
+#pragma once
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+// A sub-rectangle of some texture. A whole standalone texture is simply a
+// region with UVs 0..1, so UI code treats both the same way.
+struct AtlasRegion {
+  GLuint texture = 0;
+  glm::vec2 uvMin{0.0f};
+  glm::vec2 uvMax{1.0f};
+  glm::ivec2 size{0}; // texels
+
+  bool isValid() const { return texture != 0; }
+
+  // Maps a UV inside the region's own 0..1 space to the page
+  glm::vec2 map(glm::vec2 uv) const { return uvMin + uv * (uvMax - uvMin); }
+};
+
+// Skyline bottom-left packer: keeps the top edge of everything placed so far
+// as a list of horizontal segments and drops each rectangle where it ends up
+// lowest. Good enough for the few hundred small images of a UI.
+class RectPacker {
+private:
+  struct Segment {
+    int x, y, width;
+  };
+
+  int m_width;
+  int m_height;
+  std::vector<Segment> m_skyline;
+
+public:
+  RectPacker(int width, int height);
+
+  // Top-left corner of the placed rectangle, nullopt when it does not fit
+  std::optional<glm::ivec2> pack(int width, int height);
+  void reset();
+
+private:
+  // Lowest y at which width fits starting at segment index; -1 if it can't
+  int _fit(size_t index, int width, int height) const;
+};
+
+// RGBA8 pages of PAGE_SIZE^2 holding small UI images and the font, so a HUD
+// samples one texture and the SpriteBatch merges it into a single draw. A
+// new page is only opened when an image does not fit the existing ones.
+class TextureAtlas {
+public:
+  static constexpr int PAGE_SIZE = 1024;
+  // Clear border around every image so linear filtering never picks up
+  // its neighbours
+  static constexpr int PADDING = 1;
+
+private:
+  struct Page {
+    GLuint texture;
+    RectPacker packer;
+  };
+
+  std::vector<Page> m_pages;
+
+public:
+  TextureAtlas() = default;
+  ~TextureAtlas();
+  TextureAtlas(const TextureAtlas &) = delete;
+  TextureAtlas &operator=(const TextureAtlas &) = delete;
+
+  // Copies tightly packed RGBA8 pixels into a page; invalid region when
+  // the image is larger than a page
+  AtlasRegion add(int width, int height, std::span<const unsigned char> rgba);
+  // Decodes an AssetManager image (any channel count) and adds it
+  AtlasRegion addImage(std::string_view asset, bool flip = false);
+
+  size_t getPageCount() const { return m_pages.size(); }
+  void clear();
+
+private:
+  Page &_newPage();
+};
@@ -0,0 +1,216 @@
+#include "texture_loader.hpp"
+#include "core/asset_archive.hpp"
+#include "core/trace.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <print>
+
+namespace {
+// Indexed by component count
+constexpr std::array<GLenum, 5> FORMATS = {0, GL_RED, GL_RG, GL_RGB, GL_RGBA};
+constexpr std::array<GLenum, 5> INTERNAL_FORMATS = {0, GL_R8, GL_RG8, GL_RGB8,
+                                                    GL_RGBA8};
+} // namespace
+
+TextureLoader::TextureLoader(StreamBuffer &stream, size_t workers)
+    : m_stream(stream), m_workerCount(std::max<size_t>(workers, 1)) {
+  _createPlaceholder();
+}
+
+TextureLoader::~TextureLoader() {
+  {
+    std::lock_guard lock(m_mutex);
+    m_stopping = true;
+  }
+  m_wake.notify_all();
+  for (std::thread &worker : m_workers)
+    worker.join();
+
+  for (Slot &slot : m_slots) {
+    if (slot.texture != 0)
+      glDeleteTextures(1, &slot.texture);
+    if (!slot.ready)
+      slot.promise.set_value(m_placeholder);
+  }
+  glDeleteTextures(1, &m_placeholder);
+}
+
+TextureLoader::Handle TextureLoader::load(std::string_view asset, bool flip) {
+  uint32_t index = static_cast<uint32_t>(m_slots.size());
+  Slot &slot = m_slots.emplace_back();
+  slot.name = asset;
+  Handle handle{index, slot.promise.get_future().share()};
+
+  // Archive lookups only hand out a span; the pages are read by the worker
+  std::span<const std::byte> file = AssetManager::load(asset);
+  if (file.empty()) {
+    _finish(index, m_placeholder);
+    return handle;
+  }
+
+  if (m_workers.empty()) {
+    for (size_t i = 0; i < m_workerCount; ++i)
+      m_workers.emplace_back(&TextureLoader::_run, this);
+  }
+
+  {
+    std::lock_guard lock(m_mutex);
+    m_jobs.push_back({index, file, flip});
+  }
+  m_decoding++;
+  m_wake.notify_one();
+  return handle;
+}
+
+GLuint TextureLoader::getTexID(const Handle &handle) const {
+  if (!isReady(handle))
+    return m_placeholder;
+  GLuint texture = m_slots[handle.slot].texture;
+  return texture != 0 ? texture : m_placeholder;
+}
+
+bool TextureLoader::isReady(const Handle &handle) const {
+  return handle.isValid() && handle.slot < m_slots.size() &&
+         m_slots[handle.slot].ready;
+}
+
+void TextureLoader::update() {
+  {
+    std::lock_guard lock(m_mutex);
+    for (Decoded &decoded : m_decoded)
+      m_uploads.push_back({std::move(decoded)});
+    m_decoding -= m_decoded.size();
+    m_decoded.clear();
+  }
+
+  if (m_uploads.empty())
+    return;
+
+  TRACE_SCOPE("TextureLoader::update");
+
+  // Rows of RGB / single channel images are not 4-byte aligned
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+  GLsizeiptr budget = UPLOAD_BUDGET;
+  while (!m_uploads.empty() && budget > 0) {
+    Upload &upload = m_uploads.front();
+    if (m_slots[upload.decoded.slot].texture == 0) {
+      _beginUpload(upload.decoded);
+      if (!upload.decoded.image.pixels) {
+        m_uploads.pop_front();
+        continue;
+      }
+    }
+
+    GLsizeiptr spent = _uploadRows(upload, budget);
+    budget -= spent;
+
+    if (upload.nextRow == upload.decoded.image.height) {
+      GLuint texture = m_slots[upload.decoded.slot].texture;
+      glGenerateTextureMipmap(texture);
+      _finish(upload.decoded.slot, texture);
+      m_uploads.pop_front();
+    } else if (spent == 0) {
+      break; // stream region is full this frame
+    }
+  }
+
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void TextureLoader::_beginUpload(const Decoded &decoded) {
+  Slot &slot = m_slots[decoded.slot];
+  const DecodedImage &image = decoded.image;
+  if (!image.pixels) {
+    std::println("Texture failed to load: {}", slot.name);
+    _finish(decoded.slot, m_placeholder);
+    return;
+  }
+
+  // Storage now, contents over the next frames; it is only sampled once
+  // the slot is ready
+  GLsizei levels = 1 + static_cast<GLsizei>(std::floor(
+                           std::log2(std::max(image.width, image.height))));
+  glCreateTextures(GL_TEXTURE_2D, 1, &slot.texture);
+  glTextureStorage2D(slot.texture, levels, INTERNAL_FORMATS[image.components],
+                     image.width, image.height);
+  glTextureParameteri(slot.texture, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTextureParameteri(slot.texture, GL_TEXTURE_WRAP_T, GL_REPEAT);
+  glTextureParameteri(slot.texture, GL_TEXTURE_MIN_FILTER,
+                      GL_LINEAR_MIPMAP_LINEAR);
+  glTextureParameteri(slot.texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
+
+GLsizeiptr TextureLoader::_uploadRows(Upload &upload, GLsizeiptr budget) {
+  const DecodedImage &image = upload.decoded.image;
+  uint32_t slot = upload.decoded.slot;
+  GLsizeiptr row_bytes =
+      static_cast<GLsizeiptr>(image.width) * image.components;
+
+  // At least one row per frame, so huge images still make progress
+  int rows = static_cast<int>(std::max<GLsizeiptr>(budget / row_bytes, 1));
+  rows = std::min(rows, image.height - upload.nextRow);
+
+  StreamBuffer::Allocation staging = m_stream.allocate(rows * row_bytes, 4);
+  if (!staging)
+    return 0;
+
+  std::memcpy(staging.data, image.pixels.get() + upload.nextRow * row_bytes,
+              rows * row_bytes);
+
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging.buffer);
+  glTextureSubImage2D(m_slots[slot].texture, 0, 0, upload.nextRow,
+                      image.width, rows, FORMATS[image.components],
+                      GL_UNSIGNED_BYTE,
+                      reinterpret_cast<const void *>(staging.offset));
+
+  upload.nextRow += rows;
+  return rows * row_bytes;
+}
+
+void TextureLoader::_finish(uint32_t slot, GLuint texture) {
+  m_slots[slot].ready = true;
+  m_slots[slot].promise.set_value(texture);
+}
+
+void TextureLoader::_run() {
+  TRACE_THREAD_NAME("texture decode");
+
+  while (true) {
+    DecodeJob job;
+    {
+      std::unique_lock lock(m_mutex);
+      m_wake.wait(lock, [this] { return m_stopping || !m_jobs.empty(); });
+      if (m_stopping)
+        return;
+      job = m_jobs.front();
+      m_jobs.pop_front();
+    }
+
+    Decoded decoded{job.slot, {}};
+    {
+      TRACE_SCOPE("TextureLoader::decode");
+      decoded.image = Texture::decode(job.file, job.flip);
+    }
+
+    std::lock_guard lock(m_mutex);
+    m_decoded.push_back(std::move(decoded));
+  }
+}
+
+void TextureLoader::_createPlaceholder() {
+  // 2x2 grey checker, visibly "not loaded yet" without being loud
+  static constexpr std::array<unsigned char, 16> pixels = {
+      96, 96, 96, 255, 160, 160, 160, 255, 160, 160, 160, 255, 96, 96, 96, 255};
+
+  glCreateTextures(GL_TEXTURE_2D, 1, &m_placeholder);
+  glTextureStorage2D(m_placeholder, 1, GL_RGBA8, 2, 2);
+  glTextureSubImage2D(m_placeholder, 0, 0, 0, 2, 2, GL_RGBA, GL_UNSIGNED_BYTE,
+                      pixels.data());
+  glTextureParameteri(m_placeholder, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTextureParameteri(m_placeholder, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "core/stream_buffer.hpp"
+#include "core/texture_manager.hpp"
+#include "glad/gl.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Loads textures without stalling the render thread. Files are decoded by a
+// small worker pool; the pixels then go up through the StreamBuffer (bound
+// as the pixel unpack buffer) a few rows at a time, at most
+// UPLOAD_BUDGET bytes per frame. Until its last row lands a texture draws as
+// a placeholder, so new icon packs or skins never add a startup or frame
+// spike. The workers start with the first load(), so a game without
+// streamed textures runs no extra threads.
+class TextureLoader {
+public:
+  static constexpr size_t DEFAULT_WORKERS = 2;
+  static constexpr GLsizeiptr UPLOAD_BUDGET = 512 * 1024;
+
+  struct Handle {
+    uint32_t slot = UINT32_MAX;
+    // Becomes the final texture id (the placeholder on failure). Set on the
+    // render thread, so only poll it there, never wait().
+    std::shared_future<GLuint> ready;
+
+    bool isValid() const { return slot != UINT32_MAX; }
+  };
+
+private:
+  struct DecodeJob {
+    uint32_t slot;
+    std::span<const std::byte> file; // archive mapping or cached loose file
+    bool flip;
+  };
+
+  struct Decoded {
+    uint32_t slot;
+    DecodedImage image; // no pixels when decoding failed
+  };
+
+  struct Slot {
+    std::string name;
+    GLuint texture = 0; // 0 until storage is allocated
+    bool ready = false;
+    std::promise<GLuint> promise;
+  };
+
+  // A decoded image being uploaded, row slab by row slab
+  struct Upload {
+    Decoded decoded;
+    int nextRow = 0;
+  };
+
+  StreamBuffer &m_stream;
+  GLuint m_placeholder = 0;
+  size_t m_workerCount;
+
+  std::vector<Slot> m_slots; // render thread only
+  std::deque<Upload> m_uploads;
+  size_t m_decoding = 0; // queued or decoding, not yet in m_uploads
+
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::deque<DecodeJob> m_jobs;
+  std::vector<Decoded> m_decoded;
+  bool m_stopping = false;
+  std::vector<std::thread> m_workers;
+
+public:
+  explicit TextureLoader(StreamBuffer &stream,
+                         size_t workers = DEFAULT_WORKERS);
+  ~TextureLoader();
+  TextureLoader(const TextureLoader &) = delete;
+  TextureLoader &operator=(const TextureLoader &) = delete;
+
+  // asset is an AssetManager name; returns immediately
+  Handle load(std::string_view asset, bool flip = false);
+
+  // The placeholder until the texture is fully uploaded
+  GLuint getTexID(const Handle &handle) const;
+  bool isReady(const Handle &handle) const;
+
+  // Render thread, once per frame between StreamBuffer::beginFrame/endFrame
+  void update();
+
+  // Loads not finished yet, whether still decoding or uploading
+  size_t getPendingCount() const { return m_decoding + m_uploads.size(); }
+
+private:
+  void _run();
+  void _createPlaceholder();
+  void _beginUpload(const Decoded &decoded);
+  // Copies the next rows that fit in budget; returns the bytes spent
+  GLsizeiptr _uploadRows(Upload &upload, GLsizeiptr budget);
+  void _finish(uint32_t slot, GLuint texture);
+};
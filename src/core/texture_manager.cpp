@@ -1,4 +1,8 @@
 #include "texture_manager.hpp"
+#include "core/asset_archive.hpp"
+
+#include <algorithm>
+#include <cmath>
 #include <glad/gl.h>
 #include <memory>
 #include <print>
@@ -7,8 +11,8 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "external/stb_image.h"
 
-Texture::Texture(const char *path, bool flip) {
-  m_texID = _load_texture(path, flip);
+Texture::Texture(const char *asset, bool flip) {
+  m_texID = _load_texture(AssetManager::load(asset), asset, flip);
   m_ownTex = true;
 }
 
@@ -22,51 +26,75 @@ Texture::~Texture() {
     glDeleteTextures(1, &m_texID);
 }
 
-GLuint Texture::_load_texture(const char *path, bool flip) {
+void DecodedImage::Free::operator()(unsigned char *pixels) const {
+  stbi_image_free(pixels);
+}
+
+DecodedImage Texture::decode(std::span<const std::byte> file, bool flip) {
+  DecodedImage image;
+  // The global flip flag would race between loader workers
+  stbi_set_flip_vertically_on_load_thread(flip);
+  image.pixels.reset(stbi_load_from_memory(
+      reinterpret_cast<const stbi_uc *>(file.data()),
+      static_cast<int>(file.size()), &image.width, &image.height,
+      &image.components, 0));
+  return image;
+}
+
+// Decoded straight from the archive mapping, no intermediate file read.
+// Synchronous; TextureLoader spreads the same work over worker threads and
+// several frames.
+GLuint Texture::_load_texture(std::span<const std::byte> file, const char *name,
+                              bool flip) {
   GLuint textureID;
-  glGenTextures(1, &textureID);
-
-  int width, height, nrComponents;
-  stbi_set_flip_vertically_on_load(flip);
-  unsigned char *data = stbi_load(path, &width, &height, &nrComponents, 0);
-  if (data) {
-    GLenum format;
-    if (nrComponents == 1)
-      format = GL_RED;
-    else if (nrComponents == 3)
-      format = GL_RGB;
-    else if (nrComponents == 4)
-      format = GL_RGBA;
-
-    glBindTexture(GL_TEXTURE_2D, textureID);
-    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format,
-                 GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
-                    GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    stbi_image_free(data);
-  } else {
-    std::println("Texture failed to load at path: {}", path);
-    stbi_image_free(data);
+  glCreateTextures(GL_TEXTURE_2D, 1, &textureID);
+
+  DecodedImage image = decode(file, flip);
+  if (!image.pixels) {
+    std::println("Texture failed to load: {}", name);
+    return textureID;
   }
 
+  static constexpr GLenum formats[] = {0, GL_RED, GL_RG, GL_RGB, GL_RGBA};
+  static constexpr GLenum internalFormats[] = {0, GL_R8, GL_RG8, GL_RGB8,
+                                               GL_RGBA8};
+
+  // DSA, so loading leaves the tracked texture bindings alone
+  GLsizei levels = 1 + static_cast<GLsizei>(std::floor(
+                           std::log2(std::max(image.width, image.height))));
+  glTextureStorage2D(textureID, levels, internalFormats[image.components],
+                     image.width, image.height);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTextureSubImage2D(textureID, 0, 0, 0, image.width, image.height,
+                      formats[image.components], GL_UNSIGNED_BYTE,
+                      image.pixels.get());
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glGenerateTextureMipmap(textureID);
+
+  glTextureParameteri(textureID, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTextureParameteri(textureID, GL_TEXTURE_WRAP_T, GL_REPEAT);
+  glTextureParameteri(textureID, GL_TEXTURE_MIN_FILTER,
+                      GL_LINEAR_MIPMAP_LINEAR);
+  glTextureParameteri(textureID, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
   return textureID;
 }
 
 std::unordered_map<TextureType, std::unique_ptr<Texture>>
     TextureManager::textures;
+TextureAtlas TextureManager::s_uiAtlas;
 
-Texture &TextureManager::loadTexture(TextureType type, const char *texture_path,
-                                     bool flip) {
-  textures[type] = std::make_unique<Texture>(texture_path, flip);
+Texture &TextureManager::loadTexture(TextureType type,
+                                     const char *texture_asset, bool flip) {
+  textures[type] = std::make_unique<Texture>(texture_asset, flip);
   return *TextureManager::textures.at(type);
 }
 
 Texture &TextureManager::getTexture(TextureType type) {
   return *TextureManager::textures.at(type);
 }
+
+void TextureManager::clear() {
+  textures.clear();
+  s_uiAtlas.clear();
+}
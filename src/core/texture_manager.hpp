@@ -1,18 +1,39 @@
 #pragma once
 
+#include "core/texture_atlas.hpp"
+
 #include <glad/gl.h>
+#include <cstddef>
 #include <memory>
+#include <span>
 #include <unordered_map>
 
 enum class TextureType {};
 
+// Pixels decoded from an image file, tightly packed rows
+struct DecodedImage {
+  struct Free {
+    void operator()(unsigned char *pixels) const;
+  };
+
+  std::unique_ptr<unsigned char, Free> pixels;
+  int width = 0;
+  int height = 0;
+  int components = 0; // 1 to 4
+
+  size_t size() const {
+    return static_cast<size_t>(width) * height * components;
+  }
+};
+
 class Texture {
 private:
   GLuint m_texID;
   bool m_ownTex;
 
 public:
-  Texture(const char *path, bool flip = false);
+  // asset is an AssetManager name
+  Texture(const char *asset, bool flip = false);
   Texture(GLuint tex_id, bool own = false);
   ~Texture();
   Texture(const Texture &) = delete;
@@ -26,16 +47,29 @@ public:
 
   GLuint getTexID() const { return m_texID; };
 
+  // Safe to call from any thread; empty pixels on failure
+  static DecodedImage decode(std::span<const std::byte> file, bool flip);
+
 private:
-  GLuint _load_texture(const char *path, bool flip);
+  GLuint _load_texture(std::span<const std::byte> file, const char *name,
+                       bool flip);
 };
 
 class TextureManager {
 public:
   static std::unordered_map<TextureType, std::unique_ptr<Texture>> textures;
 
-  static Texture &loadTexture(TextureType type, const char *texture_path,
+  static Texture &loadTexture(TextureType type, const char *texture_asset,
                               bool flip = false);
 
   static Texture &getTexture(TextureType type);
+
+  // Shared by UI images and the font, so the HUD samples one texture
+  static TextureAtlas &getUIAtlas() { return s_uiAtlas; }
+
+  // Releases every texture; call while the GL context is still current
+  static void clear();
+
+private:
+  static TextureAtlas s_uiAtlas;
 };
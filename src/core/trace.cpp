@@ -0,0 +1,134 @@
+#include "trace.hpp"
+
+#include <algorithm>
+#include <array>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <print>
+#include <string>
+#include <vector>
+
+namespace trace {
+namespace {
+
+// One writer (the owning thread), any number of readers. Readers copy a
+// window and then discard whatever the writer may have lapped meanwhile.
+struct ThreadRing {
+  std::array<Event, RING_CAPACITY> events;
+  std::atomic<uint64_t> head{0};
+  uint32_t tid = 0;
+  std::string name;
+};
+
+struct Registry {
+  std::mutex mutex; // registration and dumps only, never per event
+  std::vector<std::unique_ptr<ThreadRing>> rings;
+};
+
+Registry &registry() {
+  static Registry instance;
+  return instance;
+}
+
+// Rings outlive their threads so late dumps still see them
+ThreadRing &localRing() {
+  thread_local ThreadRing *ring = [] {
+    Registry &reg = registry();
+    std::lock_guard lock(reg.mutex);
+    auto owned = std::make_unique<ThreadRing>();
+    owned->tid = static_cast<uint32_t>(reg.rings.size() + 1);
+    owned->name = std::format("thread {}", owned->tid);
+    reg.rings.push_back(std::move(owned));
+    return reg.rings.back().get();
+  }();
+  return *ring;
+}
+
+void appendEscaped(std::string &out, std::string_view text) {
+  for (char c : text) {
+    if (c == '"' || c == '\\')
+      out += '\\';
+    out += c;
+  }
+}
+
+} // namespace
+
+void setThreadName(const char *name) {
+  ThreadRing &ring = localRing();
+  std::lock_guard lock(registry().mutex);
+  ring.name = name;
+}
+
+void record(const char *name, uint64_t start_ns, uint64_t end_ns) {
+  ThreadRing &ring = localRing();
+  uint64_t head = ring.head.load(std::memory_order_relaxed);
+  ring.events[head % RING_CAPACITY] = {name, start_ns, end_ns - start_ns};
+  ring.head.store(head + 1, std::memory_order_release);
+}
+
+bool dumpChrome(const std::filesystem::path &path, double seconds) {
+  uint64_t cutoff = now() - static_cast<uint64_t>(seconds * 1.0e9);
+  std::string json = "{\"traceEvents\":[";
+  bool first = true;
+
+  auto separator = [&] {
+    if (!first)
+      json += ",\n";
+    first = false;
+  };
+
+  Registry &reg = registry();
+  std::lock_guard lock(reg.mutex);
+  std::vector<Event> window;
+
+  for (const auto &ring : reg.rings) {
+    separator();
+    json += std::format("{{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,"
+                        "\"tid\":{},\"args\":{{\"name\":\"",
+                        ring->tid);
+    appendEscaped(json, ring->name);
+    json += "\"}}";
+
+    uint64_t head = ring->head.load(std::memory_order_acquire);
+    uint64_t begin = head > RING_CAPACITY ? head - RING_CAPACITY : 0;
+    window.clear();
+    for (uint64_t i = begin; i < head; ++i)
+      window.push_back(ring->events[i % RING_CAPACITY]);
+
+    // Drop the slots the writer may have overwritten while we copied
+    uint64_t after = ring->head.load(std::memory_order_acquire);
+    uint64_t lapped = after > RING_CAPACITY + begin
+                          ? std::min(after - RING_CAPACITY - begin,
+                                     static_cast<uint64_t>(window.size()))
+                          : 0;
+
+    for (size_t i = lapped; i < window.size(); ++i) {
+      const Event &event = window[i];
+      if (event.startNs + event.durationNs < cutoff)
+        continue;
+
+      separator();
+      json += "{\"ph\":\"X\",\"name\":\"";
+      appendEscaped(json, event.name);
+      json += std::format("\",\"pid\":1,\"tid\":{},\"ts\":{:.3f},"
+                          "\"dur\":{:.3f}}}",
+                          ring->tid, event.startNs / 1000.0,
+                          event.durationNs / 1000.0);
+    }
+  }
+
+  json += "]}\n";
+
+  std::ofstream file(path);
+  if (!file) {
+    std::println("trace: cannot write {}", path.string());
+    return false;
+  }
+  file << json;
+  return static_cast<bool>(file);
+}
+
+} // namespace trace
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+
+// Scoped CPU tracing. TRACE_SCOPE("name") records one complete event (start
+// and duration) into a ring owned by the calling thread; the hot path is a
+// relaxed flag check, two clock reads and a single-writer ring store, no
+// locks. dumpChrome() exports recent events as Chrome / Perfetto trace JSON.
+//
+// Without TETRIS_TRACING the macros expand to nothing. The control
+// functions stay available so callers need no #ifdefs.
+namespace trace {
+
+// Events kept per thread; the oldest are overwritten first
+inline constexpr uint32_t RING_CAPACITY = 1 << 15;
+
+struct Event {
+  const char *name; // must be a string literal
+  uint64_t startNs;
+  uint64_t durationNs;
+};
+
+inline std::atomic<bool> g_enabled{false};
+
+inline uint64_t now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+inline bool isEnabled() { return g_enabled.load(std::memory_order_relaxed); }
+inline void setEnabled(bool enabled) {
+  g_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+// Names the calling thread in exported traces
+void setThreadName(const char *name);
+
+void record(const char *name, uint64_t start_ns, uint64_t end_ns);
+
+// Writes events that ended in the last `seconds` from every thread
+bool dumpChrome(const std::filesystem::path &path, double seconds);
+
+class Scope {
+public:
+  explicit Scope(const char *name)
+      : m_name(name), m_start(isEnabled() ? now() : 0) {}
+  ~Scope() {
+    if (m_start != 0)
+      record(m_name, m_start, now());
+  }
+  Scope(const Scope &) = delete;
+  Scope &operator=(const Scope &) = delete;
+
+private:
+  const char *m_name;
+  uint64_t m_start;
+};
+
+} // namespace trace
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#ifdef TETRIS_TRACING
+#define TRACE_SCOPE(name)                                                      \
+  ::trace::Scope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#define TRACE_THREAD_NAME(name) ::trace::setThreadName(name)
+#else
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_THREAD_NAME(name) ((void)0)
+#endif
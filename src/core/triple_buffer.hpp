@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Lock-free single writer / single reader handoff of whole values. The
+// writer fills back() and publishes it; the reader picks up the newest
+// published value with acquire(). Neither side ever waits for the other,
+// and the reader never sees a half written value.
+template <typename T> class TripleBuffer {
+private:
+  static constexpr uint8_t INDEX_MASK = 0x3;
+  static constexpr uint8_t FRESH_BIT = 0x4;
+
+  std::array<T, 3> m_buffers{};
+  // index of the buffer in the middle, plus FRESH_BIT when it holds a value
+  // the reader has not picked up yet
+  alignas(64) std::atomic<uint8_t> m_middle{1};
+  alignas(64) uint8_t m_back = 0; // writer only
+  alignas(64) uint8_t m_front = 2; // reader only
+
+public:
+  // --- Writer ---
+  T &back() { return m_buffers[m_back]; }
+
+  void publish() {
+    uint8_t previous =
+        m_middle.exchange(m_back | FRESH_BIT, std::memory_order_acq_rel);
+    m_back = previous & INDEX_MASK;
+  }
+
+  // --- Reader ---
+  // Returns true when a newer value was swapped into front()
+  bool acquire() {
+    if ((m_middle.load(std::memory_order_relaxed) & FRESH_BIT) == 0)
+      return false;
+
+    uint8_t previous = m_middle.exchange(m_front, std::memory_order_acq_rel);
+    m_front = previous & INDEX_MASK;
+    return true;
+  }
+
+  const T &front() const { return m_buffers[m_front]; }
+};
@@ -0,0 +1,56 @@
+#include "frame_input.hpp"
+#include "game/tetris_manager.hpp"
+
+void FrameInput::addMove(glm::ivec3 grid_move) {
+  if (grid_move.x > 0)
+    add(MOVE_POS_X);
+  else if (grid_move.x < 0)
+    add(MOVE_NEG_X);
+  else if (grid_move.z > 0)
+    add(MOVE_POS_Z);
+  else if (grid_move.z < 0)
+    add(MOVE_NEG_Z);
+}
+
+void FrameInput::addRotation(glm::ivec3 axis, bool clockwise) {
+  // Rotating around a negative axis is the opposite turn around the positive
+  // one, so only positive axes need to go over the wire.
+  if (axis.x != 0)
+    add((axis.x > 0) == clockwise ? ROTATE_X_CW : ROTATE_X_CCW);
+  else if (axis.y != 0)
+    add((axis.y > 0) == clockwise ? ROTATE_Y_CW : ROTATE_Y_CCW);
+  else if (axis.z != 0)
+    add((axis.z > 0) == clockwise ? ROTATE_Z_CW : ROTATE_Z_CCW);
+}
+
+void applyFrameInput(TetrisManager &game, FrameInput input) {
+  game.setSoftDrop(input.has(FrameInput::SOFT_DROP));
+
+  if (input.has(FrameInput::HOLD))
+    game.hold();
+
+  if (input.has(FrameInput::MOVE_POS_X))
+    game.moveGrid({1, 0, 0});
+  if (input.has(FrameInput::MOVE_NEG_X))
+    game.moveGrid({-1, 0, 0});
+  if (input.has(FrameInput::MOVE_POS_Z))
+    game.moveGrid({0, 0, 1});
+  if (input.has(FrameInput::MOVE_NEG_Z))
+    game.moveGrid({0, 0, -1});
+
+  if (input.has(FrameInput::ROTATE_X_CW))
+    game.rotateGrid({1, 0, 0}, true);
+  if (input.has(FrameInput::ROTATE_X_CCW))
+    game.rotateGrid({1, 0, 0}, false);
+  if (input.has(FrameInput::ROTATE_Y_CW))
+    game.rotateGrid({0, 1, 0}, true);
+  if (input.has(FrameInput::ROTATE_Y_CCW))
+    game.rotateGrid({0, 1, 0}, false);
+  if (input.has(FrameInput::ROTATE_Z_CW))
+    game.rotateGrid({0, 0, 1}, true);
+  if (input.has(FrameInput::ROTATE_Z_CCW))
+    game.rotateGrid({0, 0, 1}, false);
+
+  if (input.has(FrameInput::HARD_DROP))
+    game.hardDrop();
+}
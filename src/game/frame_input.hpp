@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+
+class TetrisManager;
+
+// One simulation tick worth of player input, already resolved to grid space
+// so that every peer replays it identically regardless of camera.
+struct FrameInput {
+  enum Bit : uint16_t {
+    MOVE_POS_X = 1 << 0,
+    MOVE_NEG_X = 1 << 1,
+    MOVE_POS_Z = 1 << 2,
+    MOVE_NEG_Z = 1 << 3,
+    ROTATE_X_CW = 1 << 4,
+    ROTATE_X_CCW = 1 << 5,
+    ROTATE_Y_CW = 1 << 6,
+    ROTATE_Y_CCW = 1 << 7,
+    ROTATE_Z_CW = 1 << 8,
+    ROTATE_Z_CCW = 1 << 9,
+    HARD_DROP = 1 << 10,
+    HOLD = 1 << 11,
+    SOFT_DROP = 1 << 12,
+  };
+
+  // Bits that describe a held key rather than a one-shot action
+  static constexpr uint16_t HELD_BITS = SOFT_DROP;
+
+  uint16_t bits = 0;
+
+  void add(Bit bit) { bits |= bit; }
+  bool has(Bit bit) const { return (bits & bit) != 0; }
+
+  void addMove(glm::ivec3 grid_move);
+  void addRotation(glm::ivec3 axis, bool clockwise);
+
+  bool operator==(const FrameInput &) const = default;
+};
+
+void applyFrameInput(TetrisManager &game, FrameInput input);
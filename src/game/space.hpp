@@ -1,11 +1,11 @@
 #pragma once
 
+#include <array>
 #include <cstddef>
 #include <cstdint>
 #include <cstdio>
 #include <glm/glm.hpp>
 #include <print>
-#include <vector>
 
 enum class BlockType : uint8_t {
   None = 0,
@@ -34,7 +34,7 @@ struct GridCell {
 
 template <size_t WIDTH, size_t HEIGHT, size_t DEPTH> class TetrisSpace {
 private:
-  std::vector<GridCell> m_cells;
+  std::array<GridCell, WIDTH * HEIGHT * DEPTH> m_cells{};
 
 public:
   TetrisSpace();
@@ -48,8 +48,7 @@ public:
 
 // TetrisSpace implementation
 template <size_t WIDTH, size_t HEIGHT, size_t DEPTH>
-TetrisSpace<WIDTH, HEIGHT, DEPTH>::TetrisSpace()
-    : m_cells(WIDTH * HEIGHT * DEPTH) {}
+TetrisSpace<WIDTH, HEIGHT, DEPTH>::TetrisSpace() {}
 
 template <size_t WIDTH, size_t HEIGHT, size_t DEPTH>
 GridCell &TetrisSpace<WIDTH, HEIGHT, DEPTH>::at(int x, int y, int z) {
@@ -0,0 +1,282 @@
+#include "stack_mesher.hpp"
+#include "core/trace.hpp"
+#include "game/space.hpp"
+#include "game/tetromino.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const glm::ivec3 SPACE_SIZE = {static_cast<int>(StackMesher::SPACE_WIDTH),
+                               static_cast<int>(StackMesher::SPACE_HEIGHT),
+                               static_cast<int>(StackMesher::SPACE_DEPTH)};
+
+// Largest slice over all three axes
+constexpr size_t MAX_SLICE_CELLS =
+    std::max({StackMesher::SPACE_WIDTH * StackMesher::SPACE_DEPTH,
+              StackMesher::CHUNK_HEIGHT * StackMesher::SPACE_DEPTH,
+              StackMesher::SPACE_WIDTH * StackMesher::CHUNK_HEIGHT});
+
+// 0 for no face, otherwise block type plus a bit for "layer is clearing",
+// so faces only merge when they look identical
+uint16_t faceKey(BlockType type, bool clearing) {
+  return static_cast<uint16_t>(type) | (clearing ? 0x100 : 0);
+}
+
+// Grid corner (integer lattice, 0..size) to world space
+glm::vec3 cornerToWorld(glm::ivec3 corner) {
+  return StackMesher::Space::gridToWorld(corner.x, corner.y, corner.z) -
+         glm::vec3(0.5f);
+}
+
+void emitQuad(std::vector<StackVertex> &out, glm::ivec3 base, int d,
+              int dir, glm::ivec3 du, glm::ivec3 dv, int w, int h,
+              uint16_t key) {
+  BlockType type = static_cast<BlockType>(key & 0xff);
+  float alpha = (key & 0x100) ? 0.7f : 1.0f;
+  glm::vec4 color(TetrominoFactory::getColor(type), alpha);
+
+  glm::vec3 normal(0.0f);
+  normal[d] = static_cast<float>(dir);
+
+  glm::ivec3 corners[4] = {base, base + du * w, base + du * w + dv * h,
+                           base + dv * h};
+  glm::vec2 uvs[4] = {{0, 0},
+                      {static_cast<float>(w), 0},
+                      {static_cast<float>(w), static_cast<float>(h)},
+                      {0, static_cast<float>(h)}};
+
+  // du x dv points along +d; flip the winding for faces looking down -d
+  static constexpr int FRONT[6] = {0, 1, 2, 0, 2, 3};
+  static constexpr int BACK[6] = {0, 2, 1, 0, 3, 2};
+  const int *order = dir > 0 ? FRONT : BACK;
+
+  for (int i = 0; i < 6; ++i) {
+    int c = order[i];
+    out.push_back({cornerToWorld(corners[c]), normal, uvs[c], color});
+  }
+}
+
+} // namespace
+
+StackMesher::StackMesher() { m_thread = std::thread(&StackMesher::_run, this); }
+
+StackMesher::~StackMesher() {
+  {
+    std::lock_guard lock(m_mutex);
+    m_stopping = true;
+  }
+  m_wake.notify_one();
+  m_thread.join();
+}
+
+void StackMesher::setGreedyMerge(bool enabled) {
+  std::lock_guard lock(m_mutex);
+  m_greedy = enabled;
+}
+
+void StackMesher::submit(const TetrisManager::RenderState &state) {
+  {
+    std::lock_guard lock(m_mutex);
+    if (!m_pending)
+      m_pending.emplace();
+
+    m_pending->revision = state.boardRevision;
+    m_pending->space = state.space;
+    m_pending->clearingLayers = state.clearingLayers;
+  }
+  m_wake.notify_one();
+}
+
+bool StackMesher::poll(Result &out) {
+  std::lock_guard lock(m_mutex);
+  if (!m_resultReady)
+    return false;
+
+  std::swap(out, m_result);
+  m_result.rebuilt.fill(false);
+  m_resultReady = false;
+  return true;
+}
+
+void StackMesher::waitFor(uint64_t revision) {
+  std::unique_lock lock(m_mutex);
+  m_meshDone.wait(lock, [&] {
+    return m_stopping || (m_resultReady && m_result.revision == revision);
+  });
+}
+
+void StackMesher::_run() {
+  TRACE_THREAD_NAME("mesher");
+
+  Job job;
+  Result work;
+  bool greedy = true;
+  bool was_greedy = true;
+
+  while (true) {
+    {
+      std::unique_lock lock(m_mutex);
+      m_wake.wait(lock, [this] { return m_stopping || m_pending; });
+      if (m_stopping)
+        return;
+
+      job = std::move(*m_pending);
+      m_pending.reset();
+      greedy = m_greedy;
+    }
+
+    if (greedy != was_greedy)
+      m_meshed.reset();
+    was_greedy = greedy;
+
+    TRACE_SCOPE("StackMesher::mesh");
+    work.rebuilt = _findDirtyChunks(job);
+    for (size_t chunk = 0; chunk < CHUNK_COUNT; ++chunk) {
+      if (work.rebuilt[chunk]) {
+        buildChunk(job.space, job.clearingLayers, static_cast<int>(chunk),
+                   greedy, work.chunks[chunk]);
+      }
+    }
+    m_meshed = job;
+
+    std::lock_guard lock(m_mutex);
+    // The renderer may not have taken the previous result yet; fold this
+    // one into it so no rebuilt chunk is lost.
+    for (size_t chunk = 0; chunk < CHUNK_COUNT; ++chunk) {
+      if (work.rebuilt[chunk]) {
+        std::swap(m_result.chunks[chunk], work.chunks[chunk]);
+        m_result.rebuilt[chunk] = true;
+      }
+    }
+    m_result.revision = job.revision;
+    m_resultReady = true;
+    m_meshDone.notify_all();
+  }
+}
+
+std::array<bool, StackMesher::CHUNK_COUNT>
+StackMesher::_findDirtyChunks(const Job &job) const {
+  std::array<bool, CHUNK_COUNT> dirty{};
+  if (!m_meshed) {
+    dirty.fill(true);
+    return dirty;
+  }
+
+  // Cells are stored x-major, so every (y, z) row is contiguous
+  std::array<bool, SPACE_HEIGHT> changed{};
+  for (int y = 0; y < static_cast<int>(SPACE_HEIGHT); ++y) {
+    changed[y] = job.clearingLayers[y] != m_meshed->clearingLayers[y];
+
+    for (int z = 0; z < static_cast<int>(SPACE_DEPTH) && !changed[y]; ++z) {
+      changed[y] = std::memcmp(&job.space.at(0, y, z),
+                               &m_meshed->space.at(0, y, z),
+                               SPACE_WIDTH * sizeof(GridCell)) != 0;
+    }
+  }
+
+  // A chunk's outer faces depend on the layer just below and above it
+  const int chunk_height = static_cast<int>(CHUNK_HEIGHT);
+  for (int chunk = 0; chunk < static_cast<int>(CHUNK_COUNT); ++chunk) {
+    int first = std::max(chunk * chunk_height - 1, 0);
+    int last = std::min((chunk + 1) * chunk_height, SPACE_SIZE.y - 1);
+
+    for (int y = first; y <= last; ++y) {
+      dirty[chunk] = dirty[chunk] || changed[y];
+    }
+  }
+
+  return dirty;
+}
+
+// Classic greedy meshing: for each axis and facing, sweep slices of the
+// chunk, mark faces whose neighbour is empty, then grow each unvisited face
+// into the widest and then tallest rectangle of identical faces.
+void StackMesher::buildChunk(const Space &space,
+                             const ClearingLayers &clearing_layers, int chunk,
+                             bool greedy, std::vector<StackVertex> &out) {
+  out.clear();
+
+  const int chunk_height = static_cast<int>(CHUNK_HEIGHT);
+  glm::ivec3 lo = {0, chunk * chunk_height, 0};
+  glm::ivec3 hi = {SPACE_SIZE.x,
+                   std::min((chunk + 1) * chunk_height, SPACE_SIZE.y),
+                   SPACE_SIZE.z};
+
+  std::array<uint16_t, MAX_SLICE_CELLS> mask;
+
+  for (int d = 0; d < 3; ++d) {
+    int u = (d + 1) % 3;
+    int v = (d + 2) % 3;
+    glm::ivec3 du(0), dv(0), dd(0);
+    du[u] = 1;
+    dv[v] = 1;
+    dd[d] = 1;
+
+    int size_u = hi[u] - lo[u];
+    int size_v = hi[v] - lo[v];
+
+    for (int dir : {-1, 1}) {
+      for (int s = lo[d]; s < hi[d]; ++s) {
+        // Build the face mask of this slice
+        for (int b = 0; b < size_v; ++b) {
+          for (int a = 0; a < size_u; ++a) {
+            glm::ivec3 p = lo + du * a + dv * b;
+            p[d] = s;
+
+            const GridCell &cell = space.at(p.x, p.y, p.z);
+            glm::ivec3 n = p + dd * dir;
+            bool hidden = cell.isEmpty() ||
+                          (space.checkInBound(n.x, n.y, n.z) &&
+                           space.at(n.x, n.y, n.z).isOccupied());
+
+            mask[a + b * size_u] =
+                hidden ? 0 : faceKey(cell.type, clearing_layers[p.y]);
+          }
+        }
+
+        // Merge into rectangles
+        for (int b = 0; b < size_v; ++b) {
+          for (int a = 0; a < size_u;) {
+            uint16_t key = mask[a + b * size_u];
+            if (key == 0) {
+              ++a;
+              continue;
+            }
+
+            int w = 1;
+            int h = 1;
+            if (greedy) {
+              while (a + w < size_u && mask[a + w + b * size_u] == key)
+                ++w;
+
+              bool row_matches = true;
+              while (b + h < size_v && row_matches) {
+                for (int k = 0; k < w; ++k) {
+                  if (mask[a + k + (b + h) * size_u] != key) {
+                    row_matches = false;
+                    break;
+                  }
+                }
+                if (row_matches)
+                  ++h;
+              }
+            }
+
+            glm::ivec3 base = lo + du * a + dv * b;
+            base[d] = s + (dir > 0 ? 1 : 0);
+            emitQuad(out, base, d, dir, du, dv, w, h, key);
+
+            for (int j = 0; j < h; ++j) {
+              for (int k = 0; k < w; ++k) {
+                mask[a + k + (b + j) * size_u] = 0;
+              }
+            }
+            a += w;
+          }
+        }
+      }
+    }
+  }
+}
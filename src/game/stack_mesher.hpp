@@ -0,0 +1,95 @@
+#pragma once
+
+#include "game/tetris_manager.hpp"
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+struct StackVertex {
+  glm::vec3 pos; // world space
+  glm::vec3 normal;
+  glm::vec2 uv; // in cells, so merged quads keep the per-cube bevel
+  glm::vec4 color;
+};
+
+// Turns the locked stack into a mesh of visible faces only. The space is
+// split into horizontal chunks of CHUNK_HEIGHT layers and only chunks whose
+// layers (or the layers bordering them) changed are rebuilt. Meshing runs
+// on a worker thread; the renderer keeps drawing the previous chunk meshes
+// until poll() hands over new ones.
+class StackMesher {
+public:
+  using Space = TetrisManager::Space;
+  using ClearingLayers = std::array<bool, TetrisManager::SPACE_HEIGHT>;
+
+  static const size_t SPACE_WIDTH = TetrisManager::SPACE_WIDTH;
+  static const size_t SPACE_HEIGHT = TetrisManager::SPACE_HEIGHT;
+  static const size_t SPACE_DEPTH = TetrisManager::SPACE_DEPTH;
+
+  static constexpr size_t CHUNK_HEIGHT = 4;
+  static constexpr size_t CHUNK_COUNT =
+      (SPACE_HEIGHT + CHUNK_HEIGHT - 1) / CHUNK_HEIGHT;
+  // Every cell of a chunk showing all six faces
+  static constexpr size_t MAX_CHUNK_VERTICES =
+      SPACE_WIDTH * CHUNK_HEIGHT * SPACE_DEPTH * 36;
+
+  struct Result {
+    uint64_t revision = 0;
+    std::array<bool, CHUNK_COUNT> rebuilt{};
+    std::array<std::vector<StackVertex>, CHUNK_COUNT> chunks;
+  };
+
+private:
+  struct Job {
+    uint64_t revision = 0;
+    Space space;
+    ClearingLayers clearingLayers{};
+  };
+
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::condition_variable m_meshDone;
+  std::optional<Job> m_pending; // only the newest board matters
+  Result m_result;              // merged until the renderer picks it up
+  bool m_resultReady = false;
+  bool m_greedy = true;
+  bool m_stopping = false;
+
+  // worker only: the board the current chunk meshes were built from
+  std::optional<Job> m_meshed;
+
+  std::thread m_thread;
+
+public:
+  StackMesher();
+  ~StackMesher();
+  StackMesher(const StackMesher &) = delete;
+  StackMesher &operator=(const StackMesher &) = delete;
+
+  // Merging coplanar faces of the same color cuts vertex count further;
+  // changing it remeshes everything on the next submit.
+  void setGreedyMerge(bool enabled);
+
+  void submit(const TetrisManager::RenderState &state);
+
+  // Moves finished chunk meshes into `out` (reusing its vectors). Returns
+  // false when nothing new is ready.
+  bool poll(Result &out);
+  // Blocks until the board submitted as `revision` is meshed and ready to
+  // poll. Headless runs use it so a frame never shows an older stack.
+  void waitFor(uint64_t revision);
+
+  static void buildChunk(const Space &space,
+                         const ClearingLayers &clearing_layers, int chunk,
+                         bool greedy, std::vector<StackVertex> &out);
+
+private:
+  void _run();
+  std::array<bool, CHUNK_COUNT> _findDirtyChunks(const Job &job) const;
+};
@@ -1,18 +1,13 @@
 #include "tetris_manager.hpp"
 #include "camera.h"
-#include "core/geometry.hpp"
-#include "core/shader_manager.hpp"
+#include "core/trace.hpp"
 #include "game/space.hpp"
 #include "game/tetromino.hpp"
-#include "shader.h"
-
-#include <glad/gl.h>
-
-#include <GLFW/glfw3.h>
-#include <glm/ext/matrix_transform.hpp>
-#include <glm/gtx/hash.hpp>
+#include "game/wall_kicks.hpp"
 
 #include <algorithm>
+#include <bit>
+#include <functional>
 #include <limits>
 #include <optional>
 #include <print>
@@ -20,18 +15,19 @@
 #include <utility>
 #include <vector>
 
-TetrisManager::TetrisManager()
-    : m_activePiece(
-          Tetromino(_getRandomPieceType(0),
+TetrisManager::TetrisManager(uint32_t seed)
+    : m_rng(seed),
+      m_activePiece(
+          Tetromino(BlockType::None,
                     {SPACE_WIDTH / 2, SPACE_HEIGHT - 1, SPACE_DEPTH / 2})) {
 
   _spawnPiece();
-  _setupBuffers();
 }
 
 TetrisManager::~TetrisManager() {}
 
 void TetrisManager::update(double delta_time) {
+  TRACE_SCOPE("TetrisManager::update");
   if (m_state == GameState::GAME_OVER)
     return;
 
@@ -60,8 +56,6 @@ void TetrisManager::update(double delta_time) {
 
   // Clearing
   if (m_state == GameState::CLEARING) {
-    std::println("clearing {}", m_collapseTimer);
-
     m_collapseTimer += delta_time;
 
     if (m_collapseTimer >= MAX_COLLASPE_DELAY) {
@@ -91,63 +85,74 @@ void TetrisManager::update(double delta_time) {
   }
 }
 
-void TetrisManager::render(double delta_time, const Camera &camera) {
-  glEnable(GL_DEPTH_TEST);
-  glEnable(GL_BLEND);
-
-  Shader &shader = ShaderManager::getShader(ShaderType::TETROMINO);
-  shader.use();
+bool TetrisManager::rotateRelative(RelativeRotation type, bool clockwise,
+                                   const Camera &camera) {
+  return rotateGrid(relativeRotationToGridAxis(type, camera), clockwise);
+}
 
-  shader.setVec3("u_viewPos", camera.Position);
-  shader.setMat4("u_view", camera.GetViewMatrix());
-  shader.setMat4("u_projection", camera.GetProjectionMatrix());
+bool TetrisManager::moveRelative(RelativeDir direction, const Camera &camera) {
+  return moveGrid(relativeMoveToGrid(direction, camera));
+}
 
-  _renderGrid(shader, camera.GetViewMatrix(), camera.GetProjectionMatrix());
-  glBindVertexArray(m_vao);
+bool TetrisManager::rotateGrid(glm::ivec3 axis, bool clockwise) {
+  if (axis == glm::ivec3(0)) {
+    return false;
+  }
 
-  // Draw On Grid Piece
-  _renderOnGridPiece(shader);
+  Tetromino rotated = m_activePiece;
+  _applyGlobalRotation(rotated, axis, clockwise);
 
-  // Draw Active Piece
-  _renderActivePiece(shader);
+  std::span<const glm::ivec3> kicks =
+      WallKickTable::getKicks(rotated.getType(), axis);
+  int kick = _findFirstFittingKick(rotated, kicks);
+  if (kick < 0) {
+    return false;
+  }
 
-  // Draw Ghost Piece
-  _renderGhostPiece(shader);
+  rotated.moveRelative(kicks[kick]);
+  m_activePiece = rotated;
+  return true;
 }
 
-bool TetrisManager::rotateRelative(RelativeRotation type, bool clockwise,
-                                   const Camera &camera) {
-  glm::ivec3 rotationAxis(0);
-
-  glm::vec3 cam_right = camera.GetRight();
-  glm::vec3 cam_front = camera.GetFront();
-  cam_right.y = 0;
-  cam_front.y = 0;
-
-  if (type == RelativeRotation::Y_AXIS) {
-    rotationAxis = glm::ivec3(0, 1, 0);
+bool TetrisManager::moveGrid(glm::ivec3 grid_move) {
+  if (!_checkValidPiecePosition(m_activePiece.tryMoveRelative(grid_move))) {
+    return false;
   }
 
-  else if (type == RelativeRotation::PITCH) {
-    rotationAxis = _snapToGridAxis(cam_right);
-  }
+  m_activePiece.moveRelative(grid_move);
 
-  else if (type == RelativeRotation::ROLL) {
-    rotationAxis = _snapToGridAxis(cam_front);
+  // Give the player more time
+  if (m_state == GameState::LOCKING) {
+    if (m_lockMoveResetCount < MAX_LOCK_RESETS) {
+      m_lockTimer = 0.0;
+      m_lockMoveResetCount++;
+    }
   }
 
-  ;
+  return true;
+}
 
-  if (!_checkValidPiecePosition(
-          _tryApplyGlobalRotation(rotationAxis, clockwise))) {
-    return false;
+glm::ivec3 TetrisManager::relativeRotationToGridAxis(RelativeRotation type,
+                                                     const Camera &camera) {
+  glm::vec3 cam_right = camera.GetRight();
+  glm::vec3 cam_front = camera.GetFront();
+  cam_right.y = 0;
+  cam_front.y = 0;
+
+  switch (type) {
+  case RelativeRotation::Y_AXIS:
+    return glm::ivec3(0, 1, 0);
+  case RelativeRotation::PITCH:
+    return _snapToGridAxis(cam_right);
+  case RelativeRotation::ROLL:
+    return _snapToGridAxis(cam_front);
   }
 
-  _applyGlobalRotation(rotationAxis, clockwise);
-  return true;
+  return glm::ivec3(0);
 }
 
-bool TetrisManager::moveRelative(RelativeDir direction, const Camera &camera) {
+glm::ivec3 TetrisManager::relativeMoveToGrid(RelativeDir direction,
+                                             const Camera &camera) {
   glm::vec3 cam_right = camera.GetRight();
   glm::vec3 cam_front = camera.GetFront();
 
@@ -156,41 +161,22 @@ bool TetrisManager::moveRelative(RelativeDir direction, const Camera &camera) {
   cam_right = glm::normalize(cam_right);
   cam_front = glm::normalize(cam_front);
 
-  glm::ivec3 gridMove(0);
-
   switch (direction) {
   case RelativeDir::RIGHT:
-    gridMove = _snapToGridAxis(cam_right);
-    break;
+    return _snapToGridAxis(cam_right);
   case RelativeDir::LEFT:
-    gridMove = _snapToGridAxis(-cam_right);
-    break;
+    return _snapToGridAxis(-cam_right);
   case RelativeDir::FORWARD:
-    gridMove = _snapToGridAxis(-cam_front);
-    break;
+    return _snapToGridAxis(-cam_front);
   case RelativeDir::BACK:
-    gridMove = _snapToGridAxis(cam_front);
-    break;
-  }
-
-  if (!_checkValidPiecePosition(m_activePiece.tryMoveRelative(gridMove))) {
-    return false;
+    return _snapToGridAxis(cam_front);
   }
 
-  m_activePiece.moveRelative(gridMove);
-
-  // Give the player more time
-  if (m_state == GameState::LOCKING) {
-    if (m_lockMoveResetCount < MAX_LOCK_RESETS) {
-      m_lockTimer = 0.0;
-      m_lockMoveResetCount++;
-    }
-  }
-
-  return true;
+  return glm::ivec3(0);
 }
 
 void TetrisManager::hold() {
+  TRACE_SCOPE("TetrisManager::hold");
   if (!m_canHold)
     return;
 
@@ -230,7 +216,130 @@ const std::optional<Tetromino> &TetrisManager::getHold() const {
   return m_heldPiece;
 }
 
+void TetrisManager::captureRenderState(RenderState &out) const {
+  out.boardRevision = m_boardRevision;
+  out.space = m_space;
+  out.activePiece = m_activePiece;
+  out.ghostOffset = _calculateDropOffset();
+
+  out.clearingLayers.fill(false);
+  for (int y : m_pendingClearLayers) {
+    out.clearingLayers[y] = true;
+  }
+
+  out.queueCount = 0;
+  for (const Tetromino &piece : m_piecesQueue) {
+    if (out.queueCount == out.queue.size())
+      break;
+    out.queue[out.queueCount++] = piece.getType();
+  }
+  out.heldType =
+      m_heldPiece.transform(&Tetromino::getType).value_or(BlockType::None);
+
+  out.state = m_state;
+  out.score = m_score;
+  out.linesCleared = m_linesCleared;
+  out.level = m_level;
+}
+
+void TetrisManager::setJournalEnabled(bool enabled) {
+  m_journalEnabled = enabled;
+  m_journal.ops.clear();
+  m_journal.epoch++;
+}
+
+void TetrisManager::reset(uint32_t seed) {
+  m_space = Space();
+  m_piecesQueue.clear();
+  m_heldPiece.reset();
+  m_rng.seed(seed);
+
+  m_state = GameState::FALLING;
+  m_isSoftDropping = false;
+  m_canHold = true;
+  m_level = 0;
+  m_score = 0;
+  m_linesCleared = 0;
+
+  m_pendingClearLayers.clear();
+  m_depth_map = {};
+  m_occupancy = {};
+  m_boardRevision++;
+
+  m_dropTimer = 0.0;
+  m_lockTimer = 0.0;
+  m_collapseTimer = 0.0;
+  m_lockMoveResetCount = 0;
+
+  m_journal.ops.clear();
+  m_journal.epoch++;
+
+  _spawnPiece();
+}
+
+void TetrisManager::saveSnapshot(Snapshot &out) const {
+  out.space = m_space;
+  out.activePiece = m_activePiece;
+  out.piecesQueue = m_piecesQueue;
+  out.heldPiece = m_heldPiece;
+  out.rng = m_rng;
+
+  out.state = m_state;
+  out.isSoftDropping = m_isSoftDropping;
+  out.canHold = m_canHold;
+  out.level = m_level;
+  out.score = m_score;
+  out.linesCleared = m_linesCleared;
+
+  out.pendingClearLayers = m_pendingClearLayers;
+  out.depthMap = m_depth_map;
+  out.occupancy = m_occupancy;
+
+  out.dropTimer = m_dropTimer;
+  out.lockTimer = m_lockTimer;
+  out.collapseTimer = m_collapseTimer;
+  out.lockMoveResetCount = m_lockMoveResetCount;
+}
+
+void TetrisManager::loadSnapshot(const Snapshot &snapshot) {
+  if (m_journalEnabled) {
+    for (int z = 0; z < static_cast<int>(SPACE_DEPTH); ++z) {
+      for (int y = 0; y < static_cast<int>(SPACE_HEIGHT); ++y) {
+        for (int x = 0; x < static_cast<int>(SPACE_WIDTH); ++x) {
+          BlockType type = snapshot.space.at(x, y, z).type;
+          if (m_space.at(x, y, z).type != type)
+            m_journal.ops.push_back({BoardOp::Kind::SET_CELL, {x, y, z}, type});
+        }
+      }
+    }
+  }
+
+  m_space = snapshot.space;
+  m_activePiece = snapshot.activePiece;
+  m_piecesQueue = snapshot.piecesQueue;
+  m_heldPiece = snapshot.heldPiece;
+  m_rng = snapshot.rng;
+
+  m_state = snapshot.state;
+  m_isSoftDropping = snapshot.isSoftDropping;
+  m_canHold = snapshot.canHold;
+  m_level = snapshot.level;
+  m_score = snapshot.score;
+  m_linesCleared = snapshot.linesCleared;
+
+  m_pendingClearLayers = snapshot.pendingClearLayers;
+  m_depth_map = snapshot.depthMap;
+  m_occupancy = snapshot.occupancy;
+  m_boardRevision++;
+
+  m_dropTimer = snapshot.dropTimer;
+  m_lockTimer = snapshot.lockTimer;
+  m_collapseTimer = snapshot.collapseTimer;
+  m_lockMoveResetCount = snapshot.lockMoveResetCount;
+}
+
 void TetrisManager::_commit() {
+  TRACE_SCOPE("TetrisManager::commit");
   for (glm::ivec3 cell_position : m_activePiece.getGlobalPositions()) {
     if (!m_space.checkInBound(cell_position.x, cell_position.y,
                               cell_position.z))
@@ -239,10 +348,19 @@ void TetrisManager::_commit() {
     m_space.at(cell_position.x, cell_position.y, cell_position.z).type =
         m_activePiece.getType();
 
+    if (m_journalEnabled) {
+      m_journal.ops.push_back({BoardOp::Kind::SET_CELL, cell_position,
+                               m_activePiece.getType()});
+    }
+
     // Update depth map
     m_depth_map[cell_position.x][cell_position.z] = std::max(
         m_depth_map[cell_position.x][cell_position.z], cell_position.y);
+    m_occupancy[cell_position.y * SPACE_DEPTH + cell_position.z] |=
+        1u << cell_position.x;
   }
+  m_boardRevision++;
+
   // Points for landing a piece
   m_score += 10 * (m_level + 1);
 }
@@ -290,6 +408,7 @@ void TetrisManager::_finalizeSpawn() {
 }
 
 void TetrisManager::_checkLayerClears(std::vector<int> &layers_cleared) {
+  TRACE_SCOPE("TetrisManager::clear");
   static std::vector<int> unique_y;
 
   unique_y.clear();
@@ -324,10 +443,24 @@ void TetrisManager::_checkLayerClears(std::vector<int> &layers_cleared) {
 }
 
 void TetrisManager::_collapseLayers(const std::vector<int> &layers_cleared) {
+  TRACE_SCOPE("TetrisManager::collapse");
   if (layers_cleared.empty()) {
     return;
   }
 
+  if (m_journalEnabled) {
+    // Highest first, so replaying the removals one by one shifts the same
+    // rows as the single compaction pass below
+    size_t first = m_journal.ops.size();
+    for (int y : layers_cleared) {
+      m_journal.ops.push_back(
+          {BoardOp::Kind::REMOVE_LAYER, {0, y, 0}, BlockType::None});
+    }
+    std::ranges::sort(m_journal.ops.begin() + first, m_journal.ops.end(),
+                      std::greater{},
+                      [](const BoardOp &op) { return op.position.y; });
+  }
+
   int write_y = 0;
 
   for (int read_y = 0; read_y < SPACE_HEIGHT; ++read_y) {
@@ -351,15 +484,18 @@ void TetrisManager::_collapseLayers(const std::vector<int> &layers_cleared) {
   for (int y = write_y; y < SPACE_HEIGHT; ++y) {
     for (int x = 0; x < SPACE_WIDTH; ++x) {
       for (int z = 0; z < SPACE_DEPTH; ++z) {
-        m_space.at(x, write_y, z).clear();
+        m_space.at(x, y, z).clear();
       }
     }
   }
 
   _updateDepthMap();
+  _updateOccupancy();
+  m_boardRevision++;
 }
 
 bool TetrisManager::_spawnPiece() {
+  TRACE_SCOPE("TetrisManager::spawn");
   glm::ivec3 startPos = {SPACE_WIDTH / 2, SPACE_HEIGHT - 1, SPACE_DEPTH / 2};
 
   while (m_piecesQueue.size() < PIECES_QUEUE_CAP) {
@@ -397,9 +533,57 @@ void TetrisManager::_updateDepthMap() {
   }
 }
 
+void TetrisManager::_updateOccupancy() {
+  for (int y = 0; y < SPACE_HEIGHT; ++y) {
+    for (int z = 0; z < SPACE_DEPTH; ++z) {
+      uint16_t row = 0;
+      for (int x = 0; x < SPACE_WIDTH; ++x) {
+        if (m_space.at(x, y, z).isOccupied())
+          row |= 1u << x;
+      }
+      m_occupancy[y * SPACE_DEPTH + z] = row;
+    }
+  }
+}
+
+bool TetrisManager::_isCellFree(glm::ivec3 p) const {
+  // unsigned compares fold the < 0 checks into the upper bound checks
+  if (static_cast<unsigned>(p.x) >= SPACE_WIDTH ||
+      static_cast<unsigned>(p.y) >= SPACE_HEIGHT ||
+      static_cast<unsigned>(p.z) >= SPACE_DEPTH)
+    return false;
+
+  return ((m_occupancy[p.y * SPACE_DEPTH + p.z] >> p.x) & 1u) == 0;
+}
+
+// Tests every kick candidate in one pass over the piece cells, keeping a bit
+// per candidate that is still collision free. Returns the index of the
+// first fitting kick in table order, or -1.
+int TetrisManager::_findFirstFittingKick(
+    const Tetromino &piece, std::span<const glm::ivec3> kicks) const {
+  static_assert(WallKickTable::MAX_KICKS <= 32);
+
+  // A 32-bit shift by 32 is undefined, so a full table is spelled out
+  uint32_t fitting = kicks.size() == 32 ? ~0u : (1u << kicks.size()) - 1;
+  glm::ivec3 position = piece.getPosition();
+
+  for (glm::ivec3 offset : piece.getOffsets()) {
+    glm::ivec3 cell = position + offset;
+
+    for (size_t i = 0; i < kicks.size(); ++i) {
+      fitting &= ~(uint32_t(!_isCellFree(cell + kicks[i])) << i);
+    }
+
+    if (fitting == 0)
+      return -1;
+  }
+
+  return std::countr_zero(fitting);
+}
+
 // Returns relative distance to the dropped position
 // can used with Tetromino::moveRelative, or tryMoveRelative
-glm::ivec3 TetrisManager::_calculateDropOffset() {
+glm::ivec3 TetrisManager::_calculateDropOffset() const {
   int max_floor_y = std::numeric_limits<int>::lowest();
   int min_relative_y = std::numeric_limits<int>::max();
 
@@ -471,222 +655,35 @@ glm::ivec3 TetrisManager::_snapToGridAxis(glm::vec3 dir) {
   return glm::ivec3(0, 0, dir.z > 0 ? 1 : -1);
 }
 
-std::generator<glm::ivec3>
-TetrisManager::_tryApplyGlobalRotation(glm::ivec3 axis, bool clockwise) const {
-  if (std::abs(axis.x) > 0)
-    return m_activePiece.tryRotateX(axis.x > 0 ? clockwise : !clockwise);
-  if (std::abs(axis.y) > 0)
-    return m_activePiece.tryRotateY(axis.y > 0 ? clockwise : !clockwise);
-
-  return m_activePiece.tryRotateZ(axis.z > 0 ? clockwise : !clockwise);
-}
-
-void TetrisManager::_applyGlobalRotation(glm::ivec3 axis, bool clockwise) {
+void TetrisManager::_applyGlobalRotation(Tetromino &piece, glm::ivec3 axis,
+                                         bool clockwise) {
   if (std::abs(axis.x) > 0)
-    m_activePiece.rotateX(axis.x > 0 ? clockwise : !clockwise);
+    piece.rotateX(axis.x > 0 ? clockwise : !clockwise);
   else if (std::abs(axis.y) > 0)
-    m_activePiece.rotateY(axis.y > 0 ? clockwise : !clockwise);
+    piece.rotateY(axis.y > 0 ? clockwise : !clockwise);
   else if (std::abs(axis.z) > 0)
-    m_activePiece.rotateZ(axis.z > 0 ? clockwise : !clockwise);
+    piece.rotateZ(axis.z > 0 ? clockwise : !clockwise);
 }
 
 BlockType TetrisManager::_getRandomPieceType(uint8_t level) {
-  static std::mt19937 gen(std::random_device{}());
-
-  std::vector<BlockType> pool;
-  // Levels 0-2: Classic pieces
-  pool.insert(pool.end(),
-              {BlockType::Straight, BlockType::LeftSnake, BlockType::RightSnake,
-               BlockType::Square, BlockType::LeftStep, BlockType::Pyramid,
-               BlockType::RightStep});
-
-  if (level >= 3) {
-    // Levels 3-5: More advanced pieces
-    pool.insert(pool.end(),
-                {BlockType::Corner3D, BlockType::Pillar3D, BlockType::Stair3D});
-  }
-
-  if (level >= 6) {
-    // Levels 6+: Very hard cross piece
-    pool.push_back(BlockType::Cross3D);
-  }
-
-  std::uniform_int_distribution<size_t> dist(0, pool.size() - 1);
-  return pool[dist(gen)];
-}
-
-void TetrisManager::_renderGrid(const Shader &shader, const glm::mat4 &view,
-                                const glm::mat4 &proj) {
-  shader.setMat4("u_model", glm::mat4(1.0f));
-  shader.setVec4("u_color", glm::vec4(0.5f, 0.5f, 0.5f, 0.7f)); // Grey outline
-  m_gridBox.render(view, proj);
-}
-
-void TetrisManager::_renderOnGridPiece(const Shader &shader) {
-  for (int y = 0; y < SPACE_HEIGHT; ++y) {
-    bool is_clearing = std::ranges::find(m_pendingClearLayers, y) !=
-                       m_pendingClearLayers.end();
-
-    for (int x = 0; x < SPACE_WIDTH; ++x) {
-      for (int z = 0; z < SPACE_DEPTH; ++z) {
-        const GridCell &cell = m_space.at(x, y, z);
-
-        if (cell.isOccupied()) {
-          glm::vec3 world_pos = m_space.gridToWorld(x, y, z);
-
-          glm::vec4 color;
-
-          if (is_clearing) {
-            color = glm::vec4(TetrominoFactory::getColor(cell.type), 0.7);
-          } else {
-            color = glm::vec4(TetrominoFactory::getColor(cell.type), 1.0f);
-          }
-
-          _drawCell(world_pos, color, shader);
-        }
-      }
-    }
-  }
-}
-
-void TetrisManager::_renderActivePiece(const Shader &shader) {
-  glm::vec4 active_piece_color(m_activePiece.getColor(), 1.0f);
-
-  for (glm::ivec3 grid_pos : m_activePiece.getGlobalPositions()) {
-    glm::vec3 world_pos =
-        m_space.gridToWorld(grid_pos.x, grid_pos.y, grid_pos.z);
-    _drawCell(world_pos, active_piece_color, shader);
-  }
-}
-
-void TetrisManager::_renderGhostPiece(const Shader &shader) {
-  glm::vec4 ghost_piece_color(m_activePiece.getColor(), 1.0f);
-  glm::ivec3 ghost_relative_pos = _calculateDropOffset();
-
-  for (glm::ivec3 grid_pos :
-       m_activePiece.tryMoveRelative(ghost_relative_pos)) {
-    glm::vec3 world_pos =
-        m_space.gridToWorld(grid_pos.x, grid_pos.y, grid_pos.z);
-    _drawCell(world_pos, ghost_piece_color, shader, true);
-  }
-}
-
-void TetrisManager::_setupBuffers() {
-  TetrominoVertex cubeVertices[] = {
-      // Back face (Normal: 0, 0, -1)
-      {{-0.5f, -0.5f, -0.5f}, {0.0f, 0.0f, -1.0f}, {0.0f, 0.0f}},
-      {{0.5f, 0.5f, -0.5f}, {0.0f, 0.0f, -1.0f}, {1.0f, 1.0f}},
-      {{0.5f, -0.5f, -0.5f}, {0.0f, 0.0f, -1.0f}, {1.0f, 0.0f}},
-      {{0.5f, 0.5f, -0.5f}, {0.0f, 0.0f, -1.0f}, {1.0f, 1.0f}},
-      {{-0.5f, -0.5f, -0.5f}, {0.0f, 0.0f, -1.0f}, {0.0f, 0.0f}},
-      {{-0.5f, 0.5f, -0.5f}, {0.0f, 0.0f, -1.0f}, {0.0f, 1.0f}},
-
-      // Front face (Normal: 0, 0, 1)
-      {{-0.5f, -0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f}},
-      {{0.5f, -0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}, {1.0f, 0.0f}},
-      {{0.5f, 0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}, {1.0f, 1.0f}},
-      {{0.5f, 0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}, {1.0f, 1.0f}},
-      {{-0.5f, 0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f}},
-      {{-0.5f, -0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f}},
-
-      // Left face (Normal: -1, 0, 0)
-      {{-0.5f, 0.5f, 0.5f}, {-1.0f, 0.0f, 0.0f}, {1.0f, 0.0f}},
-      {{-0.5f, 0.5f, -0.5f}, {-1.0f, 0.0f, 0.0f}, {1.0f, 1.0f}},
-      {{-0.5f, -0.5f, -0.5f}, {-1.0f, 0.0f, 0.0f}, {0.0f, 1.0f}},
-      {{-0.5f, -0.5f, -0.5f}, {-1.0f, 0.0f, 0.0f}, {0.0f, 1.0f}},
-      {{-0.5f, -0.5f, 0.5f}, {-1.0f, 0.0f, 0.0f}, {0.0f, 0.0f}},
-      {{-0.5f, 0.5f, 0.5f}, {-1.0f, 0.0f, 0.0f}, {1.0f, 0.0f}},
-
-      // Right face (Normal: 1, 0, 0)
-      {{0.5f, 0.5f, 0.5f}, {1.0f, 0.0f, 0.0f}, {1.0f, 0.0f}},
-      {{0.5f, -0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}, {0.0f, 1.0f}},
-      {{0.5f, 0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}, {1.0f, 1.0f}},
-      {{0.5f, -0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}, {0.0f, 1.0f}},
-      {{0.5f, 0.5f, 0.5f}, {1.0f, 0.0f, 0.0f}, {1.0f, 0.0f}},
-      {{0.5f, -0.5f, 0.5f}, {1.0f, 0.0f, 0.0f}, {0.0f, 0.0f}},
-
-      // Bottom face (Normal: 0, -1, 0)
-      {{-0.5f, -0.5f, -0.5f}, {0.0f, -1.0f, 0.0f}, {0.0f, 1.0f}},
-      {{0.5f, -0.5f, -0.5f}, {0.0f, -1.0f, 0.0f}, {1.0f, 1.0f}},
-      {{0.5f, -0.5f, 0.5f}, {0.0f, -1.0f, 0.0f}, {1.0f, 0.0f}},
-      {{0.5f, -0.5f, 0.5f}, {0.0f, -1.0f, 0.0f}, {1.0f, 0.0f}},
-      {{-0.5f, -0.5f, 0.5f}, {0.0f, -1.0f, 0.0f}, {0.0f, 0.0f}},
-      {{-0.5f, -0.5f, -0.5f}, {0.0f, -1.0f, 0.0f}, {0.0f, 1.0f}},
-
-      // Top face (Normal: 0, 1, 0)
-      {{-0.5f, 0.5f, -0.5f}, {0.0f, 1.0f, 0.0f}, {0.0f, 1.0f}},
-      {{0.5f, 0.5f, 0.5f}, {0.0f, 1.0f, 0.0f}, {1.0f, 0.0f}},
-      {{0.5f, 0.5f, -0.5f}, {0.0f, 1.0f, 0.0f}, {1.0f, 1.0f}},
-      {{0.5f, 0.5f, 0.5f}, {0.0f, 1.0f, 0.0f}, {1.0f, 0.0f}},
-      {{-0.5f, 0.5f, -0.5f}, {0.0f, 1.0f, 0.0f}, {0.0f, 1.0f}},
-      {{-0.5f, 0.5f, 0.5f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f}}};
-
-  // Create Tertromino VBO
-  glCreateBuffers(1, &m_vbo);
-  glNamedBufferStorage(m_vbo, sizeof(cubeVertices), cubeVertices, 0);
-
-  // Setup Tertromino VAO
-  glCreateVertexArrays(1, &m_vao);
-
-  // index 0: vec3; position attribute
-  glEnableVertexArrayAttrib(m_vao, 0);
-  glVertexArrayAttribFormat(m_vao, 0, 3, GL_FLOAT, GL_FALSE,
-                            offsetof(TetrominoVertex, pos));
-  glVertexArrayAttribBinding(m_vao, 0, 0);
-
-  // index 1: vec3; normal attribute
-  glEnableVertexArrayAttrib(m_vao, 1);
-  glVertexArrayAttribFormat(m_vao, 1, 3, GL_FLOAT, GL_FALSE,
-                            offsetof(TetrominoVertex, normal));
-  glVertexArrayAttribBinding(m_vao, 1, 0);
-
-  // index 2: vec2; uv attribute
-  glEnableVertexArrayAttrib(m_vao, 2);
-  glVertexArrayAttribFormat(m_vao, 2, 2, GL_FLOAT, GL_FALSE,
-                            offsetof(TetrominoVertex, uv));
-  glVertexArrayAttribBinding(m_vao, 2, 0);
-
-  // Link VAO <-> VBO
-  glVertexArrayVertexBuffer(m_vao, 0, m_vbo, 0, sizeof(TetrominoVertex));
-}
-
-// void TetrisManager::_renderStaticPiece(BlockType type, glm::vec3 world_pos,
-//                                        const Shader &shader) {
-//   switch (type) {
-//   case BlockType::Ghost:
-//   case BlockType::None:
-//     return;
-//   }
-//
-//   TetrominoData data = TetrominoFactory::getConfig(type);
-//   glm::vec4 color = glm::vec4(data.color, 1.0f);
-//
-//   float time = (float)glfwGetTime();
-//   glm::mat4 rotation =
-//       glm::rotate(glm::mat4(1.0f), time, glm::vec3(0.2f, 1.0f, 0.0f));
-//
-//   for (const auto &offset : data.offsets) {
-//     glm::mat4 model = glm::mat4(1.0f);
-//     model = glm::translate(model, world_pos);
-//     model = model * rotation;
-//     model = glm::translate(model, glm::vec3(offset));
-//
-//     shader.setMat4("u_model", model);
-//     shader.setBool("u_isGhost", false);
-//     shader.setVec4("u_color", color);
-//     shader.setFloat("u_time", time);
-//     glDrawArrays(GL_TRIANGLES, 0, 36);
-//   }
-// }
-
-void TetrisManager::_drawCell(glm::vec3 world_pos, glm::vec4 color,
-                              const Shader &shader, bool is_ghost_piece) {
-
-  glm::mat4 model = glm::translate(glm::mat4(1.0f), world_pos);
-  shader.setMat4("u_model", model);
-  shader.setVec4("u_color", color);
-  shader.setFloat("u_time", glfwGetTime());
-  shader.setFloat("u_isGhost", is_ghost_piece);
-
-  glDrawArrays(GL_TRIANGLES, 0, 36);
+  static constexpr BlockType pool[] = {
+      // Levels 0-2: Classic pieces
+      BlockType::Straight, BlockType::LeftSnake, BlockType::RightSnake,
+      BlockType::Square, BlockType::LeftStep, BlockType::Pyramid,
+      BlockType::RightStep,
+      // Levels 3-5: More advanced pieces
+      BlockType::Corner3D, BlockType::Pillar3D, BlockType::Stair3D,
+      // Levels 6+: Very hard cross piece
+      BlockType::Cross3D};
+
+  size_t pool_size = 7;
+  if (level >= 3)
+    pool_size = 10;
+  if (level >= 6)
+    pool_size = 11;
+
+  // Plain modulo instead of a distribution: distributions are not
+  // guaranteed to produce the same sequence across standard libraries,
+  // and netplay peers must agree on every spawn.
+  return pool[m_rng() % pool_size];
 }
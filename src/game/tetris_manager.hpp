@@ -2,18 +2,16 @@
 
 #include "camera.h"
 #include "game/space.hpp"
-#include "game/tetris_ui_renderer.hpp"
 #include "game/tetromino.hpp"
-#include "glad/gl.h"
 #include "glm/fwd.hpp"
-#include "shader.h"
-#include "ui/grid_box.hpp"
 #include <array>
 #include <cstddef>
 #include <cstdint>
 #include <deque>
 #include <generator>
 #include <optional>
+#include <random>
+#include <span>
 #include <vector>
 
 template <typename R>
@@ -37,17 +35,86 @@ public:
   static constexpr double MAX_COLLASPE_DELAY = 0.2;
   static const int MAX_LOCK_RESETS = 15;
 
+  using Space = TetrisSpace<SPACE_WIDTH, SPACE_HEIGHT, SPACE_DEPTH>;
+  using DepthMap = std::array<std::array<int, SPACE_WIDTH>, SPACE_DEPTH>;
+  // One bit per cell along x, one row per (y, z), indexed y * DEPTH + z.
+  // Lets collision tests skip GridCell lookups entirely.
+  using OccupancyMask = std::array<uint16_t, SPACE_HEIGHT * SPACE_DEPTH>;
+  static_assert(SPACE_WIDTH <= 16, "OccupancyMask rows are 16 bits wide");
+
+  // Everything the simulation needs to resume from a given tick. Used by
+  // rollback netplay to restore and re-simulate past frames, so it holds
+  // no GL resources and copies without touching the heap in steady state.
+  struct Snapshot {
+    Space space;
+    Tetromino activePiece{BlockType::None, {0, 0, 0}};
+    std::deque<Tetromino> piecesQueue;
+    std::optional<Tetromino> heldPiece;
+    std::minstd_rand rng;
+
+    GameState state = GameState::FALLING;
+    bool isSoftDropping = false;
+    bool canHold = true;
+    uint8_t level = 0;
+    uint64_t score = 0;
+    uint64_t linesCleared = 0;
+
+    std::vector<int> pendingClearLayers;
+    DepthMap depthMap{};
+    OccupancyMask occupancy{};
+
+    double dropTimer = 0.0;
+    double lockTimer = 0.0;
+    double collapseTimer = 0.0;
+    int lockMoveResetCount = 0;
+  };
+
+  // Immutable copy of everything needed to draw one frame, published by the
+  // simulation thread and read by the renderer without touching live state.
+  struct RenderState {
+    // Bumped whenever locked cells or clearing layers change, so renderers
+    // can cache anything derived from the stack
+    uint64_t boardRevision = 0;
+    Space space;
+    Tetromino activePiece{BlockType::None, {0, 0, 0}};
+    glm::ivec3 ghostOffset{0};
+    std::array<bool, SPACE_HEIGHT> clearingLayers{};
+
+    std::array<BlockType, PIECES_QUEUE_CAP + 1> queue{};
+    uint8_t queueCount = 0;
+    BlockType heldType = BlockType::None;
+
+    GameState state = GameState::FALLING;
+    uint64_t score = 0;
+    uint64_t linesCleared = 0;
+    uint8_t level = 0;
+  };
+
+  // Ordered record of board mutations since the last clearJournal(), for
+  // consumers that mirror the board incrementally (spectator stream).
+  // `epoch` changes whenever the board jumps (reset, journal toggled), at
+  // which point the ops alone no longer describe the board. A snapshot
+  // restore is journaled as the cells it changes, so rollbacks stay deltas.
+  struct BoardOp {
+    enum class Kind : uint8_t { SET_CELL, REMOVE_LAYER };
+    Kind kind;
+    glm::ivec3 position; // SET_CELL: cell, REMOVE_LAYER: y only
+    BlockType type;
+  };
+
+  struct Journal {
+    std::vector<BoardOp> ops;
+    uint32_t epoch = 0;
+  };
+
 private:
   // --- State & Core Systems ---
-  TetrisSpace<SPACE_WIDTH, SPACE_HEIGHT, SPACE_DEPTH> m_space;
-  GridBox m_gridBox{SPACE_WIDTH, SPACE_HEIGHT, SPACE_DEPTH};
+  Space m_space;
+  std::minstd_rand m_rng;
   Tetromino m_activePiece;
   std::deque<Tetromino> m_piecesQueue;
   std::optional<Tetromino> m_heldPiece;
 
-  GLuint m_vao = 0;
-  GLuint m_vbo = 0;
-
   GameState m_state = GameState::FALLING;
   bool m_isSoftDropping = false;
   bool m_canHold = true;
@@ -56,7 +123,9 @@ private:
   uint64_t m_linesCleared = 0;
 
   std::vector<int> m_pendingClearLayers;
-  std::array<std::array<int, SPACE_WIDTH>, SPACE_DEPTH> m_depth_map;
+  DepthMap m_depth_map{};
+  OccupancyMask m_occupancy{};
+  uint64_t m_boardRevision = 0;
 
   double m_dropTimer = 0.0;
   double m_lockTimer = 0.0;
@@ -65,18 +134,43 @@ private:
   double m_baseDropDelay = 2.0;
   double m_delayDecreaseRate = 0.13;
 
+  bool m_journalEnabled = false;
+  Journal m_journal;
+
 public:
   // --- Lifecycle & Main Loop ---
-  TetrisManager();
+  explicit TetrisManager(uint32_t seed = std::random_device{}());
   ~TetrisManager();
 
   void update(double delta_time);
-  void render(double delta_time, const Camera &camera);
+  void captureRenderState(RenderState &out) const;
+
+  // Starts a fresh game with a known piece sequence
+  void reset(uint32_t seed);
+
+  // --- Snapshots ---
+  void saveSnapshot(Snapshot &out) const;
+  void loadSnapshot(const Snapshot &snapshot);
+
+  // --- Journal ---
+  void setJournalEnabled(bool enabled);
+  const Journal &getJournal() const { return m_journal; }
+  void clearJournal() { m_journal.ops.clear(); }
 
   // --- Input Actions ---
   bool moveRelative(RelativeDir direction, const Camera &camera);
   bool rotateRelative(RelativeRotation type, bool clockwise,
                       const Camera &camera);
+
+  // Camera independent variants, used by deterministic replays of input
+  bool moveGrid(glm::ivec3 grid_move);
+  bool rotateGrid(glm::ivec3 axis, bool clockwise);
+
+  static glm::ivec3 relativeMoveToGrid(RelativeDir direction,
+                                       const Camera &camera);
+  static glm::ivec3 relativeRotationToGridAxis(RelativeRotation type,
+                                               const Camera &camera);
+
   void hardDrop();
   void hold();
   void setSoftDrop(bool is_soft_dropping);
@@ -88,7 +182,8 @@ public:
   GameState getState() const { return m_state; }
   uint64_t getScore() const { return m_score; }
   uint8_t getLevel() const { return m_level; }
-  uint64_t getVAO() const { return m_vao; }
+  uint64_t getLinesCleared() const { return m_linesCleared; }
+  const Space &getSpace() const { return m_space; }
 
 private:
   // --- Logic & Progression ---
@@ -98,28 +193,21 @@ private:
   void _performCommitSequence();
   void _checkLayerClears(std::vector<int> &layers_cleared);
   void _collapseLayers(const std::vector<int> &layers_cleared);
-  static BlockType _getRandomPieceType(uint8_t level);
+  BlockType _getRandomPieceType(uint8_t level);
 
   // --- Movement & Collision ---
   bool _moveDown();
-  glm::ivec3 _calculateDropOffset();
+  glm::ivec3 _calculateDropOffset() const;
   void _updateDepthMap();
+  void _updateOccupancy();
+  bool _isCellFree(glm::ivec3 position) const;
+  int _findFirstFittingKick(const Tetromino &piece,
+                            std::span<const glm::ivec3> kicks) const;
   bool _checkValidPiece(const Tetromino &moved_piece) const;
   bool _checkValidPiecePosition(IVec3Range auto &&positions) const;
 
   // --- Math & Rotation Helpers ---
-  glm::ivec3 _snapToGridAxis(glm::vec3 direction);
-  void _applyGlobalRotation(glm::ivec3 axis, bool clockwise);
-  std::generator<glm::ivec3> _tryApplyGlobalRotation(glm::ivec3 axis,
-                                                     bool clockwise) const;
-
-  // --- Internal Rendering ---
-  void _setupBuffers();
-  void _renderGrid(const Shader &shader, const glm::mat4 &view,
-                   const glm::mat4 &proj);
-  void _renderOnGridPiece(const Shader &shader);
-  void _renderActivePiece(const Shader &shader);
-  void _renderGhostPiece(const Shader &shader);
-  void _drawCell(glm::vec3 world_pos, glm::vec4 color, const Shader &shader,
-                 bool is_ghost = false);
+  static glm::ivec3 _snapToGridAxis(glm::vec3 direction);
+  static void _applyGlobalRotation(Tetromino &piece, glm::ivec3 axis,
+                                   bool clockwise);
 };
@@ -0,0 +1,264 @@
+#include "tetris_renderer.hpp"
+#include "camera.h"
+#include "core/geometry.hpp"
+#include "core/trace.hpp"
+#include "game/space.hpp"
+#include "game/tetromino.hpp"
+#include "shader.h"
+
+#include <glad/gl.h>
+
+#include <cassert>
+#include <glm/ext/matrix_transform.hpp>
+
+TetrisRenderer::TetrisRenderer(StreamBuffer &stream, RenderQueue &queue)
+    : m_stream(stream), m_queue(queue) {
+  _setupBuffers();
+  _setupStackBuffers();
+}
+
+TetrisRenderer::~TetrisRenderer() {
+  glDeleteBuffers(m_chunkVbos.size(), m_chunkVbos.data());
+  glDeleteVertexArrays(1, &m_stackVao);
+  glDeleteBuffers(1, &m_vbo);
+  glDeleteVertexArrays(1, &m_vao);
+}
+
+void TetrisRenderer::render(const RenderState &state, const Camera &camera) {
+  TRACE_SCOPE("TetrisRenderer::render");
+  _submitGrid(camera);
+  _submitStack(state, camera);
+  _submitPieces(state, camera);
+}
+
+void TetrisRenderer::_submitGrid(const Camera &camera) {
+  DrawPacket packet;
+  packet.pass = RenderPass::TRANSPARENT;
+  packet.material.color = glm::vec4(0.5f, 0.5f, 0.5f, 0.7f); // Grey outline
+  packet.depth = glm::length(camera.GetPosition());
+  packet.vao = m_gridBox.getVAO();
+  packet.primitive = GL_LINES;
+  packet.count = m_gridBox.getVertexCount();
+  m_queue.submit(packet);
+}
+
+// Only faces that can be seen are in the mesh, so vertex count follows the
+// stack's surface rather than its volume.
+void TetrisRenderer::_submitStack(const RenderState &state,
+                                  const Camera &camera) {
+  if (state.boardRevision != m_submittedRevision) {
+    m_stackMesher.submit(state);
+    m_submittedRevision = state.boardRevision;
+  }
+
+  // Until a new mesh arrives the previous one stays on screen
+  if (m_waitForMesh && isMeshing())
+    m_stackMesher.waitFor(m_submittedRevision);
+  if (m_stackMesher.poll(m_meshResult)) {
+    for (size_t chunk = 0; chunk < StackMesher::CHUNK_COUNT; ++chunk) {
+      if (!m_meshResult.rebuilt[chunk])
+        continue;
+
+      const std::vector<StackVertex> &vertices = m_meshResult.chunks[chunk];
+      glNamedBufferSubData(m_chunkVbos[chunk], 0,
+                           vertices.size() * sizeof(StackVertex),
+                           vertices.data());
+      m_chunkVertexCounts[chunk] = static_cast<GLsizei>(vertices.size());
+    }
+  }
+
+  DrawPacket packet;
+  packet.pass = RenderPass::OPAQUE;
+  packet.material.flags = Material::STACK_MESH;
+  packet.vao = m_stackVao;
+  packet.vertexStride = sizeof(StackVertex);
+
+  for (size_t chunk = 0; chunk < StackMesher::CHUNK_COUNT; ++chunk) {
+    if (m_chunkVertexCounts[chunk] == 0)
+      continue;
+
+    float centerY = (chunk + 0.5f) * StackMesher::CHUNK_HEIGHT;
+    packet.depth = glm::distance(camera.GetPosition(),
+                                 glm::vec3(0.0f, centerY, 0.0f));
+    packet.vertexBuffer = m_chunkVbos[chunk];
+    packet.count = m_chunkVertexCounts[chunk];
+    m_queue.submit(packet);
+  }
+}
+
+// The active piece goes with the opaque stack, the translucent ghost is
+// sorted with the other transparent geometry.
+void TetrisRenderer::_submitPieces(const RenderState &state,
+                                   const Camera &camera) {
+  if (state.activePiece.getType() == BlockType::None)
+    return;
+
+  // Every offset, up to Debug5x5's 25; a Pillar3D is 8 instances
+  std::span<const glm::ivec3> offsets = state.activePiece.getOffsets();
+  std::array<glm::ivec3, Tetromino::MAX_CELLS> cells;
+  std::array<glm::ivec3, Tetromino::MAX_CELLS> ghostCells;
+  const size_t count = offsets.size();
+  glm::ivec3 position = state.activePiece.getPosition();
+
+  for (size_t i = 0; i < count; ++i) {
+    cells[i] = position + offsets[i];
+    ghostCells[i] = cells[i] + state.ghostOffset;
+  }
+
+  glm::vec4 color(state.activePiece.getColor(), 1.0f);
+  [[maybe_unused]] GLsizei submitted =
+      _submitCells({cells.data(), count}, color, false, RenderPass::OPAQUE,
+                   camera);
+  assert(submitted == 0 || static_cast<size_t>(submitted) == count);
+  submitted = _submitCells({ghostCells.data(), count}, color, true,
+                           RenderPass::TRANSPARENT, camera);
+  assert(submitted == 0 || static_cast<size_t>(submitted) == count);
+}
+
+GLsizei TetrisRenderer::_submitCells(std::span<const glm::ivec3> cells,
+                                     glm::vec4 color, bool ghost,
+                                     RenderPass pass, const Camera &camera) {
+  StreamBuffer::Allocation allocation = m_stream.allocate(
+      cells.size() * sizeof(CellInstance), m_stream.getStorageAlignment());
+  if (!allocation || cells.empty())
+    return 0;
+
+  std::span<CellInstance> instances = allocation.as<CellInstance>();
+  glm::vec3 center(0.0f);
+  for (size_t i = 0; i < cells.size(); ++i) {
+    glm::vec3 world = Space::gridToWorld(cells[i].x, cells[i].y, cells[i].z);
+    instances[i] = {glm::vec4(world, ghost ? 1.0f : 0.0f), color};
+    center += world;
+  }
+  center /= static_cast<float>(cells.size());
+
+  DrawPacket packet;
+  packet.pass = pass;
+  packet.material.flags = Material::INSTANCED;
+  packet.depth = glm::distance(camera.GetPosition(), center);
+  packet.vao = m_vao;
+  packet.count = 36;
+  packet.instanceCount = static_cast<GLsizei>(cells.size());
+  packet.storageBuffer = allocation.buffer;
+  packet.storageBinding = INSTANCE_BINDING;
+  packet.storageOffset = allocation.offset;
+  packet.storageSize = allocation.size;
+  m_queue.submit(packet);
+  return packet.instanceCount;
+}
+
+void TetrisRenderer::_setupBuffers() {
+  TetrominoVertex cubeVertices[] = {
+      // Back face (Normal: 0, 0, -1)
+      {{-0.5f, -0.5f, -0.5f}, {0.0f, 0.0f, -1.0f}, {0.0f, 0.0f}},
+      {{0.5f, 0.5f, -0.5f}, {0.0f, 0.0f, -1.0f}, {1.0f, 1.0f}},
+      {{0.5f, -0.5f, -0.5f}, {0.0f, 0.0f, -1.0f}, {1.0f, 0.0f}},
+      {{0.5f, 0.5f, -0.5f}, {0.0f, 0.0f, -1.0f}, {1.0f, 1.0f}},
+      {{-0.5f, -0.5f, -0.5f}, {0.0f, 0.0f, -1.0f}, {0.0f, 0.0f}},
+      {{-0.5f, 0.5f, -0.5f}, {0.0f, 0.0f, -1.0f}, {0.0f, 1.0f}},
+
+      // Front face (Normal: 0, 0, 1)
+      {{-0.5f, -0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f}},
+      {{0.5f, -0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}, {1.0f, 0.0f}},
+      {{0.5f, 0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}, {1.0f, 1.0f}},
+      {{0.5f, 0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}, {1.0f, 1.0f}},
+      {{-0.5f, 0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f}},
+      {{-0.5f, -0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f}},
+
+      // Left face (Normal: -1, 0, 0)
+      {{-0.5f, 0.5f, 0.5f}, {-1.0f, 0.0f, 0.0f}, {1.0f, 0.0f}},
+      {{-0.5f, 0.5f, -0.5f}, {-1.0f, 0.0f, 0.0f}, {1.0f, 1.0f}},
+      {{-0.5f, -0.5f, -0.5f}, {-1.0f, 0.0f, 0.0f}, {0.0f, 1.0f}},
+      {{-0.5f, -0.5f, -0.5f}, {-1.0f, 0.0f, 0.0f}, {0.0f, 1.0f}},
+      {{-0.5f, -0.5f, 0.5f}, {-1.0f, 0.0f, 0.0f}, {0.0f, 0.0f}},
+      {{-0.5f, 0.5f, 0.5f}, {-1.0f, 0.0f, 0.0f}, {1.0f, 0.0f}},
+
+      // Right face (Normal: 1, 0, 0)
+      {{0.5f, 0.5f, 0.5f}, {1.0f, 0.0f, 0.0f}, {1.0f, 0.0f}},
+      {{0.5f, -0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}, {0.0f, 1.0f}},
+      {{0.5f, 0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}, {1.0f, 1.0f}},
+      {{0.5f, -0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}, {0.0f, 1.0f}},
+      {{0.5f, 0.5f, 0.5f}, {1.0f, 0.0f, 0.0f}, {1.0f, 0.0f}},
+      {{0.5f, -0.5f, 0.5f}, {1.0f, 0.0f, 0.0f}, {0.0f, 0.0f}},
+
+      // Bottom face (Normal: 0, -1, 0)
+      {{-0.5f, -0.5f, -0.5f}, {0.0f, -1.0f, 0.0f}, {0.0f, 1.0f}},
+      {{0.5f, -0.5f, -0.5f}, {0.0f, -1.0f, 0.0f}, {1.0f, 1.0f}},
+      {{0.5f, -0.5f, 0.5f}, {0.0f, -1.0f, 0.0f}, {1.0f, 0.0f}},
+      {{0.5f, -0.5f, 0.5f}, {0.0f, -1.0f, 0.0f}, {1.0f, 0.0f}},
+      {{-0.5f, -0.5f, 0.5f}, {0.0f, -1.0f, 0.0f}, {0.0f, 0.0f}},
+      {{-0.5f, -0.5f, -0.5f}, {0.0f, -1.0f, 0.0f}, {0.0f, 1.0f}},
+
+      // Top face (Normal: 0, 1, 0)
+      {{-0.5f, 0.5f, -0.5f}, {0.0f, 1.0f, 0.0f}, {0.0f, 1.0f}},
+      {{0.5f, 0.5f, 0.5f}, {0.0f, 1.0f, 0.0f}, {1.0f, 0.0f}},
+      {{0.5f, 0.5f, -0.5f}, {0.0f, 1.0f, 0.0f}, {1.0f, 1.0f}},
+      {{0.5f, 0.5f, 0.5f}, {0.0f, 1.0f, 0.0f}, {1.0f, 0.0f}},
+      {{-0.5f, 0.5f, -0.5f}, {0.0f, 1.0f, 0.0f}, {0.0f, 1.0f}},
+      {{-0.5f, 0.5f, 0.5f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f}}};
+
+  // Create Tertromino VBO
+  glCreateBuffers(1, &m_vbo);
+  glNamedBufferStorage(m_vbo, sizeof(cubeVertices), cubeVertices, 0);
+
+  // Setup Tertromino VAO
+  glCreateVertexArrays(1, &m_vao);
+
+  // index 0: vec3; position attribute
+  glEnableVertexArrayAttrib(m_vao, 0);
+  glVertexArrayAttribFormat(m_vao, 0, 3, GL_FLOAT, GL_FALSE,
+                            offsetof(TetrominoVertex, pos));
+  glVertexArrayAttribBinding(m_vao, 0, 0);
+
+  // index 1: vec3; normal attribute
+  glEnableVertexArrayAttrib(m_vao, 1);
+  glVertexArrayAttribFormat(m_vao, 1, 3, GL_FLOAT, GL_FALSE,
+                            offsetof(TetrominoVertex, normal));
+  glVertexArrayAttribBinding(m_vao, 1, 0);
+
+  // index 2: vec2; uv attribute
+  glEnableVertexArrayAttrib(m_vao, 2);
+  glVertexArrayAttribFormat(m_vao, 2, 2, GL_FLOAT, GL_FALSE,
+                            offsetof(TetrominoVertex, uv));
+  glVertexArrayAttribBinding(m_vao, 2, 0);
+
+  // Link VAO <-> VBO
+  glVertexArrayVertexBuffer(m_vao, 0, m_vbo, 0, sizeof(TetrominoVertex));
+}
+
+void TetrisRenderer::_setupStackBuffers() {
+  // Sized for the worst case up front, so a rebuilt chunk is always a plain
+  // sub-data upload
+  glCreateBuffers(m_chunkVbos.size(), m_chunkVbos.data());
+  for (GLuint vbo : m_chunkVbos) {
+    glNamedBufferStorage(vbo,
+                         StackMesher::MAX_CHUNK_VERTICES * sizeof(StackVertex),
+                         nullptr, GL_DYNAMIC_STORAGE_BIT);
+  }
+
+  glCreateVertexArrays(1, &m_stackVao);
+
+  // index 0: vec3; position attribute
+  glEnableVertexArrayAttrib(m_stackVao, 0);
+  glVertexArrayAttribFormat(m_stackVao, 0, 3, GL_FLOAT, GL_FALSE,
+                            offsetof(StackVertex, pos));
+  glVertexArrayAttribBinding(m_stackVao, 0, 0);
+
+  // index 1: vec3; normal attribute
+  glEnableVertexArrayAttrib(m_stackVao, 1);
+  glVertexArrayAttribFormat(m_stackVao, 1, 3, GL_FLOAT, GL_FALSE,
+                            offsetof(StackVertex, normal));
+  glVertexArrayAttribBinding(m_stackVao, 1, 0);
+
+  // index 2: vec2; uv attribute
+  glEnableVertexArrayAttrib(m_stackVao, 2);
+  glVertexArrayAttribFormat(m_stackVao, 2, 2, GL_FLOAT, GL_FALSE,
+                            offsetof(StackVertex, uv));
+  glVertexArrayAttribBinding(m_stackVao, 2, 0);
+
+  // index 3: vec4; color attribute
+  glEnableVertexArrayAttrib(m_stackVao, 3);
+  glVertexArrayAttribFormat(m_stackVao, 3, 4, GL_FLOAT, GL_FALSE,
+                            offsetof(StackVertex, color));
+  glVertexArrayAttribBinding(m_stackVao, 3, 0);
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "camera.h"
+#include "core/render_queue.hpp"
+#include "core/stream_buffer.hpp"
+#include "game/stack_mesher.hpp"
+#include "game/tetris_manager.hpp"
+#include "glad/gl.h"
+#include "shader.h"
+#include "ui/grid_box.hpp"
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Turns a TetrisManager::RenderState into draw packets for the RenderQueue.
+// Owns every GL resource of the play field, so the simulation itself never
+// touches GL.
+class TetrisRenderer {
+public:
+  using RenderState = TetrisManager::RenderState;
+  using Space = TetrisManager::Space;
+
+  static const size_t SPACE_WIDTH = TetrisManager::SPACE_WIDTH;
+  static const size_t SPACE_HEIGHT = TetrisManager::SPACE_HEIGHT;
+  static const size_t SPACE_DEPTH = TetrisManager::SPACE_DEPTH;
+
+  // Per-instance data read by tetromino.vert.glsl (std430 layout)
+  struct CellInstance {
+    glm::vec4 position; // xyz: world position, w: 1 for ghost cells
+    glm::vec4 color;
+  };
+
+  static constexpr GLuint INSTANCE_BINDING = 0;
+
+private:
+  GridBox m_gridBox{SPACE_WIDTH, SPACE_HEIGHT, SPACE_DEPTH};
+
+  GLuint m_vao = 0;
+  GLuint m_vbo = 0;
+
+  // Active piece and ghost instances are written into the stream every frame
+  StreamBuffer &m_stream;
+  RenderQueue &m_queue;
+
+  // Locked stack: one vertex buffer per mesher chunk, replaced only when
+  // the worker hands over a rebuilt chunk
+  StackMesher m_stackMesher;
+  StackMesher::Result m_meshResult;
+  uint64_t m_submittedRevision = UINT64_MAX;
+  bool m_waitForMesh = false;
+  GLuint m_stackVao = 0;
+  std::array<GLuint, StackMesher::CHUNK_COUNT> m_chunkVbos{};
+  std::array<GLsizei, StackMesher::CHUNK_COUNT> m_chunkVertexCounts{};
+
+public:
+  TetrisRenderer(StreamBuffer &stream, RenderQueue &queue);
+  ~TetrisRenderer();
+  TetrisRenderer(const TetrisRenderer &) = delete;
+  TetrisRenderer &operator=(const TetrisRenderer &) = delete;
+
+  // Submits the frame's packets; RenderQueue::execute() draws them
+  void render(const RenderState &state, const Camera &camera);
+  void setGreedyMerge(bool enabled) { m_stackMesher.setGreedyMerge(enabled); }
+  // Each frame waits for its board's mesh instead of showing the previous
+  // one, so output does not depend on mesher timing (headless captures)
+  void setWaitForMesh(bool enabled) { m_waitForMesh = enabled; }
+  // The last submitted board has not been meshed and uploaded yet
+  bool isMeshing() const {
+    return m_meshResult.revision != m_submittedRevision;
+  }
+
+  GLuint getVAO() const { return m_vao; }
+
+private:
+  void _setupBuffers();
+  void _setupStackBuffers();
+  void _submitGrid(const Camera &camera);
+  void _submitStack(const RenderState &state, const Camera &camera);
+  void _submitPieces(const RenderState &state, const Camera &camera);
+  // Instances submitted; 0 when the stream buffer is out of space
+  GLsizei _submitCells(std::span<const glm::ivec3> cells, glm::vec4 color,
+                       bool ghost, RenderPass pass, const Camera &camera);
+};
@@ -1,19 +1,23 @@
 #include "tetromino.hpp"
 #include "game/space.hpp"
 #include "glm/fwd.hpp"
+#include <algorithm>
 #include <generator>
+#include <span>
 #include <vector>
 
 Tetromino::Tetromino(BlockType type, glm::ivec3 startPos)
     : m_type(type), m_position(startPos) {
   TetrominoData config = TetrominoFactory::getConfig(type);
-  m_offsets = config.offsets;
+  m_cellCount =
+      static_cast<uint8_t>(std::min(config.offsets.size(), MAX_CELLS));
+  std::copy_n(config.offsets.begin(), m_cellCount, m_offsets.begin());
   m_color = config.color;
 }
 
 // Control methods
 void Tetromino::rotateX(bool clockwise) {
-  for (auto &offset : m_offsets) {
+  for (auto &offset : std::span(m_offsets.data(), m_cellCount)) {
     int y = offset.y;
     int z = offset.z;
     if (clockwise) {
@@ -28,7 +32,7 @@ void Tetromino::rotateX(bool clockwise) {
 
 // Control methods
 std::generator<glm::ivec3> Tetromino::tryRotateX(bool clockwise) const {
-  for (glm::ivec3 offset : m_offsets) {
+  for (glm::ivec3 offset : getOffsets()) {
     int y = offset.y;
     int z = offset.z;
 
@@ -45,7 +49,7 @@ std::generator<glm::ivec3> Tetromino::tryRotateX(bool clockwise) const {
 }
 
 void Tetromino::rotateY(bool clockwise) {
-  for (auto &offset : m_offsets) {
+  for (auto &offset : std::span(m_offsets.data(), m_cellCount)) {
     int x = offset.x;
     int z = offset.z;
     if (clockwise) {
@@ -59,7 +63,7 @@ void Tetromino::rotateY(bool clockwise) {
 }
 
 std::generator<glm::ivec3> Tetromino::tryRotateY(bool clockwise) const {
-  for (glm::ivec3 offset : m_offsets) {
+  for (glm::ivec3 offset : getOffsets()) {
     int x = offset.x;
     int z = offset.z;
 
@@ -76,7 +80,7 @@ std::generator<glm::ivec3> Tetromino::tryRotateY(bool clockwise) const {
 }
 
 void Tetromino::rotateZ(bool clockwise) {
-  for (auto &offset : m_offsets) {
+  for (auto &offset : std::span(m_offsets.data(), m_cellCount)) {
     int x = offset.x;
     int y = offset.y;
     if (clockwise) {
@@ -90,7 +94,7 @@ void Tetromino::rotateZ(bool clockwise) {
 }
 
 std::generator<glm::ivec3> Tetromino::tryRotateZ(bool clockwise) const {
-  for (glm::ivec3 offset : m_offsets) {
+  for (glm::ivec3 offset : getOffsets()) {
     int x = offset.x;
     int y = offset.y;
 
@@ -110,13 +114,13 @@ void Tetromino::moveRelative(glm::ivec3 direction) { m_position += direction; }
 
 std::generator<glm::ivec3>
 Tetromino::tryMoveRelative(glm::ivec3 direction) const {
-  for (const auto &off : m_offsets) {
+  for (const auto &off : getOffsets()) {
     co_yield off + m_position + direction;
   }
 }
 
 std::generator<glm::ivec3> Tetromino::getGlobalPositions() const {
-  for (const auto &off : m_offsets) {
+  for (const auto &off : getOffsets()) {
     co_yield off + m_position;
   }
 }
@@ -127,8 +131,8 @@ glm::vec3 Tetromino::getColor() const { return m_color; }
 glm::ivec3 Tetromino::getPosition() const { return m_position; }
 BlockType Tetromino::getType() const { return m_type; }
 
-const std::vector<glm::ivec3> &Tetromino::getOffsets() const {
-  return m_offsets;
+std::span<const glm::ivec3> Tetromino::getOffsets() const {
+  return {m_offsets.data(), m_cellCount};
 }
 
 glm::vec3 TetrominoFactory::getColor(BlockType type) {
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <generator>
 #include <glm/glm.hpp>
+#include <span>
 #include <vector>
 
 #include "game/space.hpp"
@@ -13,11 +17,16 @@ public:
     int x, z, minY;
   };
 
+  // Largest piece is Debug5x5; offsets are stored inline so copying a
+  // Tetromino (queue, hold, rollback snapshots) never allocates.
+  static constexpr size_t MAX_CELLS = 25;
+
 private:
   BlockType m_type;
   glm::ivec3 m_position;
   glm::vec3 m_color;
-  std::vector<glm::ivec3> m_offsets;
+  std::array<glm::ivec3, MAX_CELLS> m_offsets{};
+  uint8_t m_cellCount = 0;
 
 public:
   Tetromino(BlockType type, glm::ivec3 startPos);
@@ -38,7 +47,7 @@ public:
   void setPosition(glm::ivec3 pos);
 
   std::generator<glm::ivec3> getGlobalPositions() const;
-  const std::vector<glm::ivec3> &getOffsets() const;
+  std::span<const glm::ivec3> getOffsets() const;
   glm::vec3 getColor() const;
   glm::ivec3 getPosition() const;
   BlockType getType() const;
@@ -0,0 +1,93 @@
+#include "wall_kicks.hpp"
+
+#include <array>
+#include <cstdlib>
+#include <iterator>
+
+namespace {
+
+enum Axis { AXIS_X, AXIS_Y, AXIS_Z, AXIS_COUNT };
+
+using KickList = std::span<const glm::ivec3>;
+using KickSet = std::array<KickList, AXIS_COUNT>;
+
+// X and Z turns only kick within the plane of the rotation: sideways
+// shifts first, then a one row floor kick. After that the 3 wide tables
+// try dropping the piece a row before a two row floor kick, and the
+// straight tables try them the other way round. Y turns try every
+// sideways shift in the XZ plane and only then lift the piece a row, the
+// one kick that leaves the plane.
+
+// 3 wide pieces centred on their pivot
+constexpr glm::ivec3 STANDARD_X[] = {{0, 0, 0},  {0, 0, 1},  {0, 0, -1},
+                                     {0, 1, 0},  {0, 1, 1},  {0, 1, -1},
+                                     {0, -1, 0}, {0, 2, 0}};
+constexpr glm::ivec3 STANDARD_Y[] = {{0, 0, 0},  {1, 0, 0},  {-1, 0, 0},
+                                     {0, 0, 1},  {0, 0, -1}, {1, 0, 1},
+                                     {-1, 0, -1}, {1, 0, -1}, {-1, 0, 1},
+                                     {0, 1, 0}};
+constexpr glm::ivec3 STANDARD_Z[] = {{0, 0, 0},  {1, 0, 0},  {-1, 0, 0},
+                                     {0, 1, 0},  {1, 1, 0},  {-1, 1, 0},
+                                     {0, -1, 0}, {0, 2, 0}};
+
+// Straight reaches two cells past its pivot on one side
+constexpr glm::ivec3 LONG_X[] = {{0, 0, 0}, {0, 0, 1},  {0, 0, -1},
+                                 {0, 0, 2}, {0, 0, -2}, {0, 1, 0},
+                                 {0, 2, 0}, {0, -1, 0}};
+constexpr glm::ivec3 LONG_Y[] = {{0, 0, 0}, {1, 0, 0},  {-1, 0, 0},
+                                 {2, 0, 0}, {-2, 0, 0}, {0, 0, 1},
+                                 {0, 0, -1}, {0, 0, 2}, {0, 0, -2},
+                                 {0, 1, 0}};
+constexpr glm::ivec3 LONG_Z[] = {{0, 0, 0}, {1, 0, 0},  {-1, 0, 0},
+                                 {2, 0, 0}, {-2, 0, 0}, {0, 1, 0},
+                                 {0, 2, 0}, {0, -1, 0}};
+
+// 2 wide pieces pivot on a corner, so a turn swings them one cell over;
+// shifting back towards the original footprint comes first.
+constexpr glm::ivec3 BOX_X[] = {{0, 0, 0}, {0, 0, 1},  {0, 1, 0},
+                                {0, 1, 1}, {0, 0, -1}, {0, 1, -1},
+                                {0, -1, 0}, {0, -1, 1}};
+constexpr glm::ivec3 BOX_Y[] = {{0, 0, 0},  {1, 0, 0},  {0, 0, 1},
+                                {1, 0, 1},  {-1, 0, 0}, {0, 0, -1},
+                                {1, 0, -1}, {-1, 0, 1}, {-1, 0, -1},
+                                {0, 1, 0}};
+constexpr glm::ivec3 BOX_Z[] = {{0, 0, 0}, {1, 0, 0},  {0, 1, 0},
+                                {1, 1, 0}, {-1, 0, 0}, {-1, 1, 0},
+                                {0, -1, 0}, {1, -1, 0}};
+
+constexpr glm::ivec3 NO_KICK[] = {{0, 0, 0}};
+
+constexpr KickSet STANDARD_KICKS = {STANDARD_X, STANDARD_Y, STANDARD_Z};
+constexpr KickSet LONG_KICKS = {LONG_X, LONG_Y, LONG_Z};
+constexpr KickSet BOX_KICKS = {BOX_X, BOX_Y, BOX_Z};
+constexpr KickSet NO_KICKS = {NO_KICK, NO_KICK, NO_KICK};
+
+static_assert(std::size(STANDARD_Y) <= WallKickTable::MAX_KICKS);
+static_assert(std::size(LONG_Y) <= WallKickTable::MAX_KICKS);
+static_assert(std::size(BOX_Y) <= WallKickTable::MAX_KICKS);
+
+const KickSet &kicksFor(BlockType type) {
+  switch (type) {
+  case BlockType::Straight:
+  case BlockType::Debug5x5:
+    return LONG_KICKS;
+  case BlockType::Square:
+  case BlockType::Pillar3D:
+    return BOX_KICKS;
+  case BlockType::None:
+  case BlockType::Ghost:
+    return NO_KICKS;
+  default:
+    return STANDARD_KICKS;
+  }
+}
+
+} // namespace
+
+std::span<const glm::ivec3> WallKickTable::getKicks(BlockType type,
+                                                    glm::ivec3 axis) {
+  Axis index = std::abs(axis.x) > 0   ? AXIS_X
+               : std::abs(axis.y) > 0 ? AXIS_Y
+                                      : AXIS_Z;
+  return kicksFor(type)[index];
+}
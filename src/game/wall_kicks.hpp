@@ -0,0 +1,19 @@
+#pragma once
+
+#include "game/space.hpp"
+
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <span>
+
+// Ordered offset tests tried after a rotation, in the spirit of the
+// super rotation system: the first offset at which the rotated piece fits
+// wins. Tables are per piece family and per rotation axis; the first entry
+// is always the unkicked position.
+class WallKickTable {
+public:
+  static constexpr size_t MAX_KICKS = 10;
+
+  static std::span<const glm::ivec3> getKicks(BlockType type,
+                                              glm::ivec3 axis);
+};
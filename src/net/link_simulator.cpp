@@ -0,0 +1,53 @@
+#include "link_simulator.hpp"
+
+#include <algorithm>
+
+LinkSimulator::LinkSimulator(LinkConditions conditions)
+    : m_conditions(conditions), m_rng(conditions.seed) {}
+
+void LinkSimulator::setConditions(LinkConditions conditions) {
+  m_conditions = conditions;
+  m_rng.seed(conditions.seed);
+}
+
+void LinkSimulator::send(UdpSocket &socket, const UdpAddress &to,
+                         std::span<const uint8_t> data, double now) {
+  if (m_conditions.isIdeal()) {
+    socket.sendTo(to, data);
+    return;
+  }
+
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+  if (unit(m_rng) < m_conditions.lossRate)
+    return;
+
+  double jitter = (unit(m_rng) * 2.0 - 1.0) * m_conditions.jitterMs;
+  double delay = std::max(0.0, m_conditions.latencyMs + jitter) / 1000.0;
+
+  std::vector<uint8_t> buffer;
+  if (!m_freeBuffers.empty()) {
+    buffer = std::move(m_freeBuffers.back());
+    m_freeBuffers.pop_back();
+  }
+  buffer.assign(data.begin(), data.end());
+
+  m_pending.push_back({now + delay, to, std::move(buffer)});
+}
+
+void LinkSimulator::flush(UdpSocket &socket, double now) {
+  // Jitter may deliver datagrams out of order, just like a real network
+  auto it = m_pending.begin();
+  while (it != m_pending.end()) {
+    if (it->deliverAt > now) {
+      ++it;
+      continue;
+    }
+
+    socket.sendTo(it->to, it->data);
+    m_freeBuffers.push_back(std::move(it->data));
+
+    *it = std::move(m_pending.back());
+    m_pending.pop_back();
+  }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "net/udp_socket.hpp"
+
+#include <cstdint>
+#include <random>
+#include <span>
+#include <vector>
+
+struct LinkConditions {
+  double latencyMs = 0.0; // one-way delay added to every datagram
+  double jitterMs = 0.0;  // uniform +/- spread around the latency
+  double lossRate = 0.0;  // probability in [0, 1] of dropping a datagram
+  uint32_t seed = 1;
+
+  bool isIdeal() const {
+    return latencyMs <= 0.0 && jitterMs <= 0.0 && lossRate <= 0.0;
+  }
+};
+
+// Sits in front of a UdpSocket and degrades outgoing traffic, so netplay can
+// be exercised over loopback under realistic latency, jitter and loss.
+class LinkSimulator {
+private:
+  struct Pending {
+    double deliverAt;
+    UdpAddress to;
+    std::vector<uint8_t> data;
+  };
+
+  LinkConditions m_conditions;
+  std::minstd_rand m_rng;
+  std::vector<Pending> m_pending;
+  std::vector<std::vector<uint8_t>> m_freeBuffers;
+
+public:
+  explicit LinkSimulator(LinkConditions conditions = {});
+
+  void setConditions(LinkConditions conditions);
+  const LinkConditions &getConditions() const { return m_conditions; }
+
+  void send(UdpSocket &socket, const UdpAddress &to,
+            std::span<const uint8_t> data, double now);
+
+  // Hands every datagram whose delay has elapsed to the socket
+  void flush(UdpSocket &socket, double now);
+
+  size_t getPendingCount() const { return m_pending.size(); }
+};
@@ -0,0 +1,66 @@
+#include "netplay_protocol.hpp"
+
+#include "net/wire.hpp"
+
+#include <algorithm>
+
+namespace netplay {
+
+size_t encode(const Packet &packet, std::span<uint8_t, MAX_PACKET_SIZE> out) {
+  uint8_t *cursor = out.data();
+  uint8_t count =
+      static_cast<uint8_t>(std::min<size_t>(packet.count, MAX_PACKET_INPUTS));
+
+  wire::writeLE<uint32_t>(cursor, MAGIC);
+  wire::writeLE<uint8_t>(cursor, static_cast<uint8_t>(packet.type));
+  wire::writeLE<int32_t>(cursor, packet.ackFrame);
+  wire::writeLE<int32_t>(cursor, packet.startFrame);
+  wire::writeLE<uint8_t>(cursor, count);
+
+  for (size_t i = 0; i < count; ++i) {
+    wire::writeLE<uint16_t>(cursor, packet.inputs[i].bits);
+  }
+
+  if (packet.type == PacketType::HELLO)
+    wire::writeLE<uint32_t>(cursor, packet.seed);
+
+  return static_cast<size_t>(cursor - out.data());
+}
+
+std::optional<Packet> decode(std::span<const uint8_t> data) {
+  if (data.size() < HEADER_SIZE)
+    return std::nullopt;
+
+  const uint8_t *cursor = data.data();
+  if (wire::readLE<uint32_t>(cursor) != MAGIC)
+    return std::nullopt;
+
+  Packet packet;
+  uint8_t type = wire::readLE<uint8_t>(cursor);
+  if (type != static_cast<uint8_t>(PacketType::HELLO) &&
+      type != static_cast<uint8_t>(PacketType::INPUT))
+    return std::nullopt;
+
+  packet.type = static_cast<PacketType>(type);
+  packet.ackFrame = wire::readLE<int32_t>(cursor);
+  packet.startFrame = wire::readLE<int32_t>(cursor);
+  packet.count = wire::readLE<uint8_t>(cursor);
+
+  if (packet.count > MAX_PACKET_INPUTS ||
+      data.size() < HEADER_SIZE + packet.count * 2)
+    return std::nullopt;
+
+  for (size_t i = 0; i < packet.count; ++i) {
+    packet.inputs[i].bits = wire::readLE<uint16_t>(cursor);
+  }
+
+  if (packet.type == PacketType::HELLO) {
+    if (data.size() < HELLO_SIZE + packet.count * 2)
+      return std::nullopt;
+    packet.seed = wire::readLE<uint32_t>(cursor);
+  }
+
+  return packet;
+}
+
+} // namespace netplay
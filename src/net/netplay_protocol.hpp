@@ -0,0 +1,42 @@
+#pragma once
+
+#include "game/frame_input.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+// Wire format, all fields little endian:
+//   u32 magic | u8 type | i32 ack frame | i32 start frame | u8 count
+//   | u16 input bits x count
+// HELLO packets append u32 seed, so peers started with different seeds
+// refuse each other instead of desyncing.
+// Every INPUT packet repeats all inputs the peer has not acknowledged yet,
+// so a lost datagram is covered by the next one instead of a resend.
+namespace netplay {
+
+constexpr uint32_t MAGIC = 0x52443354; // "T3DR"
+constexpr size_t MAX_PACKET_INPUTS = 64;
+constexpr size_t HEADER_SIZE = 4 + 1 + 4 + 4 + 1;
+constexpr size_t HELLO_SIZE = HEADER_SIZE + 4;
+constexpr size_t MAX_PACKET_SIZE = HEADER_SIZE + MAX_PACKET_INPUTS * 2;
+
+enum class PacketType : uint8_t { HELLO = 1, INPUT = 2 };
+
+struct Packet {
+  PacketType type = PacketType::INPUT;
+  int32_t ackFrame = -1; // newest frame of the receiver's inputs we hold
+  int32_t startFrame = 0;
+  uint8_t count = 0;
+  uint32_t seed = 0; // HELLO only
+  std::array<FrameInput, MAX_PACKET_INPUTS> inputs{};
+};
+
+// Returns the number of bytes written into `out`
+size_t encode(const Packet &packet,
+              std::span<uint8_t, MAX_PACKET_SIZE> out);
+std::optional<Packet> decode(std::span<const uint8_t> data);
+
+} // namespace netplay
@@ -0,0 +1,265 @@
+#include "rollback_session.hpp"
+#include "net/netplay_protocol.hpp"
+
+#include <algorithm>
+#include <print>
+
+RollbackSession::RollbackSession(TetrisManager &player_one,
+                                 TetrisManager &player_two,
+                                 const NetplayConfig &config)
+    : m_players{&player_one, &player_two},
+      m_localPlayer(config.localPlayer == 0 ? 0 : 1),
+      m_remotePlayer(config.localPlayer == 0 ? 1 : 0), m_peer(config.peer),
+      m_link(config.link), m_seed(config.seed),
+      m_epoch(std::chrono::steady_clock::now()) {
+
+  for (int i = 0; i < PLAYER_COUNT; ++i) {
+    m_players[i]->reset(config.seed + static_cast<uint32_t>(i));
+  }
+
+  if (!m_socket.open(config.localPort)) {
+    std::println("netplay disabled: could not open port {}",
+                 config.localPort);
+  }
+}
+
+RollbackSession::~RollbackSession() {
+  if (m_stats.rollbacks > 0)
+    std::println("netplay: {} rollbacks, slowest {:.3f} ms", m_stats.rollbacks,
+                 m_stats.maxRollbackMs);
+}
+
+void RollbackSession::queueLocalInput(FrameInput input) {
+  m_pendingLocalInput.bits |= input.bits & ~FrameInput::HELD_BITS;
+}
+
+void RollbackSession::setLocalHeldBits(uint16_t bits) {
+  m_localHeldBits = bits & FrameInput::HELD_BITS;
+}
+
+void RollbackSession::advance(double delta_time) {
+  double now = _now();
+  _receivePackets();
+
+  // The peer only starts once it has seen our seed, so keep greeting it
+  // until its inputs arrive
+  if (!m_peerRunning)
+    _sendHello(now);
+
+  if (m_state != State::RUNNING) {
+    m_link.flush(m_socket, now);
+    return;
+  }
+
+  if (m_firstMispredictedFrame >= 0) {
+    _rollback();
+  }
+
+  // Never try to catch up more than the rollback window in one go
+  m_accumulator = std::min(m_accumulator + delta_time,
+                           MAX_ROLLBACK_FRAMES * TICK_DELAY);
+
+  while (m_accumulator >= TICK_DELAY) {
+    // Lockstep: stop predicting once the peer falls too far behind,
+    // otherwise its late inputs could land outside the snapshot ring
+    if (m_currentFrame - m_remoteConfirmedFrame > MAX_ROLLBACK_FRAMES) {
+      m_stats.stalledTicks++;
+      break;
+    }
+
+    m_localInputs[_slot(m_currentFrame)].bits =
+        m_pendingLocalInput.bits | m_localHeldBits;
+    m_pendingLocalInput = {};
+
+    _simulateFrame(m_currentFrame);
+    m_currentFrame++;
+    m_accumulator -= TICK_DELAY;
+  }
+
+  _sendInputs(now);
+  m_link.flush(m_socket, now);
+}
+
+double RollbackSession::_now() const {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       m_epoch)
+      .count();
+}
+
+void RollbackSession::_receivePackets() {
+  std::array<uint8_t, netplay::MAX_PACKET_SIZE> buffer;
+  UdpAddress from;
+
+  while (auto size = m_socket.receiveFrom(buffer, from)) {
+    auto packet = netplay::decode(std::span(buffer.data(), *size));
+    if (!packet.has_value())
+      continue;
+
+    // Hosts learn their peer from the first HELLO carrying our seed. Any
+    // other datagram from an address we do not know changes nothing.
+    if (!m_peer.has_value()) {
+      if (packet->type != netplay::PacketType::HELLO)
+        continue;
+      if (packet->seed != m_seed) {
+        if (!m_foreignSeedReported) {
+          std::println("netplay: ignoring a peer with seed {}, ours is {}",
+                       packet->seed, m_seed);
+          m_foreignSeedReported = true;
+        }
+        continue;
+      }
+      m_peer = from;
+    }
+
+    if (from != *m_peer)
+      continue;
+
+    m_stats.packetsReceived++;
+
+    if (packet->type == netplay::PacketType::HELLO) {
+      if (packet->seed != m_seed && m_state != State::REFUSED) {
+        std::println("netplay: peer uses seed {}, ours is {}; refusing",
+                     packet->seed, m_seed);
+        m_state = State::REFUSED;
+      } else if (m_state == State::CONNECTING) {
+        m_state = State::RUNNING;
+      }
+      continue;
+    }
+
+    m_peerRunning = true;
+    // Inputs from before our own start are repeated until acknowledged
+    if (m_state != State::RUNNING)
+      continue;
+
+    m_peerAckFrame = std::max(m_peerAckFrame, packet->ackFrame);
+
+    for (int i = 0; i < packet->count; ++i) {
+      _acceptRemoteInput(packet->startFrame + i, packet->inputs[i]);
+    }
+  }
+}
+
+void RollbackSession::_acceptRemoteInput(int frame, FrameInput input) {
+  // Only contiguous frames are accepted; redundancy fills any gap later
+  if (frame != m_remoteConfirmedFrame + 1)
+    return;
+
+  if (frame - m_currentFrame >= INPUT_HISTORY - MAX_ROLLBACK_FRAMES)
+    return;
+
+  m_remoteInputs[_slot(frame)] = input;
+  m_remoteConfirmedFrame = frame;
+  m_lastConfirmedRemote = input;
+
+  bool already_simulated = frame < m_currentFrame;
+  if (already_simulated && m_usedRemoteInputs[_slot(frame)] != input) {
+    if (m_firstMispredictedFrame < 0 || frame < m_firstMispredictedFrame)
+      m_firstMispredictedFrame = frame;
+  }
+}
+
+void RollbackSession::_sendHello(double now) {
+  if (!m_peer.has_value() || m_state == State::REFUSED ||
+      now - m_lastHelloTime < HELLO_INTERVAL)
+    return;
+
+  m_lastHelloTime = now;
+
+  netplay::Packet packet;
+  packet.type = netplay::PacketType::HELLO;
+  packet.seed = m_seed;
+
+  std::array<uint8_t, netplay::MAX_PACKET_SIZE> buffer;
+  size_t size = netplay::encode(packet, buffer);
+  m_link.send(m_socket, *m_peer, std::span(buffer.data(), size), now);
+  m_stats.packetsSent++;
+}
+
+void RollbackSession::_sendInputs(double now) {
+  if (!m_peer.has_value())
+    return;
+
+  int start = std::max(m_peerAckFrame + 1,
+                       m_currentFrame -
+                           static_cast<int>(netplay::MAX_PACKET_INPUTS));
+
+  netplay::Packet packet;
+  packet.type = netplay::PacketType::INPUT;
+  packet.ackFrame = m_remoteConfirmedFrame;
+  packet.startFrame = start;
+  packet.count = static_cast<uint8_t>(std::max(0, m_currentFrame - start));
+
+  for (int i = 0; i < packet.count; ++i) {
+    packet.inputs[i] = m_localInputs[_slot(start + i)];
+  }
+
+  std::array<uint8_t, netplay::MAX_PACKET_SIZE> buffer;
+  size_t size = netplay::encode(packet, buffer);
+  m_link.send(m_socket, *m_peer, std::span(buffer.data(), size), now);
+  m_stats.packetsSent++;
+}
+
+void RollbackSession::_rollback() {
+  int from = m_firstMispredictedFrame;
+  m_firstMispredictedFrame = -1;
+
+  const FrameSnapshot &snapshot = m_snapshots[from % m_snapshots.size()];
+  if (snapshot.frame != from) {
+    std::println("netplay: frame {} is outside the rollback window", from);
+    return;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+
+  for (int i = 0; i < PLAYER_COUNT; ++i) {
+    m_players[i]->loadSnapshot(snapshot.players[i]);
+  }
+
+  for (int frame = from; frame < m_currentFrame; ++frame) {
+    _simulateFrame(frame);
+  }
+
+  double elapsed_ms = std::chrono::duration<double, std::milli>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+
+  m_stats.rollbacks++;
+  m_stats.lastRollbackFrames = m_currentFrame - from;
+  m_stats.lastRollbackMs = elapsed_ms;
+  m_stats.maxRollbackMs = std::max(m_stats.maxRollbackMs, elapsed_ms);
+
+  if (elapsed_ms > ROLLBACK_BUDGET_MS)
+    std::println("netplay: rolling back {} frames took {:.3f} ms "
+                 "(budget {} ms)",
+                 m_stats.lastRollbackFrames, elapsed_ms, ROLLBACK_BUDGET_MS);
+}
+
+void RollbackSession::_simulateFrame(int frame) {
+  FrameSnapshot &snapshot = m_snapshots[frame % m_snapshots.size()];
+  snapshot.frame = frame;
+
+  for (int i = 0; i < PLAYER_COUNT; ++i) {
+    m_players[i]->saveSnapshot(snapshot.players[i]);
+  }
+
+  FrameInput remote_input = _remoteInputFor(frame);
+  m_usedRemoteInputs[_slot(frame)] = remote_input;
+
+  applyFrameInput(*m_players[m_localPlayer], m_localInputs[_slot(frame)]);
+  applyFrameInput(*m_players[m_remotePlayer], remote_input);
+
+  for (TetrisManager *player : m_players) {
+    player->update(TICK_DELAY);
+  }
+}
+
+FrameInput RollbackSession::_remoteInputFor(int frame) const {
+  if (frame <= m_remoteConfirmedFrame)
+    return m_remoteInputs[_slot(frame)];
+
+  // Predict that held keys stay held and that no new action was pressed
+  FrameInput predicted;
+  predicted.bits = m_lastConfirmedRemote.bits & FrameInput::HELD_BITS;
+  return predicted;
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "game/tetris_manager.hpp"
+#include "game/frame_input.hpp"
+#include "net/link_simulator.hpp"
+#include "net/udp_socket.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+struct NetplayConfig {
+  uint16_t localPort = 0;
+  std::optional<UdpAddress> peer; // empty when hosting, learned on contact
+  uint8_t localPlayer = 0;
+  uint32_t seed = 0;
+  LinkConditions link;
+};
+
+// Two player lockstep with rollback. Local input is applied immediately,
+// remote input is predicted; when the real remote input for a past frame
+// arrives and differs, both boards are restored to that frame and
+// re-simulated up to the present before the next tick runs.
+class RollbackSession {
+public:
+  static constexpr double TICK_RATE = 60.0;
+  static constexpr double TICK_DELAY = 1.0 / TICK_RATE;
+  static constexpr int MAX_ROLLBACK_FRAMES = 20;
+  static constexpr int INPUT_HISTORY = 128;
+  static constexpr double HELLO_INTERVAL = 0.1;
+  // A rollback slower than this is logged
+  static constexpr double ROLLBACK_BUDGET_MS = 1.0;
+
+  enum class State : uint8_t {
+    CONNECTING,
+    RUNNING,
+    REFUSED, // the peer was started with another seed
+  };
+
+  struct Stats {
+    int lastRollbackFrames = 0;
+    double lastRollbackMs = 0.0;
+    double maxRollbackMs = 0.0;
+    uint64_t rollbacks = 0;
+    uint64_t stalledTicks = 0;
+    uint64_t packetsSent = 0;
+    uint64_t packetsReceived = 0;
+  };
+
+private:
+  static constexpr int PLAYER_COUNT = 2;
+
+  struct FrameSnapshot {
+    int frame = -1;
+    std::array<TetrisManager::Snapshot, PLAYER_COUNT> players;
+  };
+
+  std::array<TetrisManager *, PLAYER_COUNT> m_players;
+  uint8_t m_localPlayer;
+  uint8_t m_remotePlayer;
+
+  UdpSocket m_socket;
+  std::optional<UdpAddress> m_peer;
+  LinkSimulator m_link;
+  State m_state = State::CONNECTING;
+  uint32_t m_seed;
+  bool m_peerRunning = false; // an INPUT arrived, so it has seen our HELLO
+  bool m_foreignSeedReported = false;
+
+  int m_currentFrame = 0;          // next frame to simulate
+  int m_remoteConfirmedFrame = -1; // newest contiguous remote input
+  int m_peerAckFrame = -1;         // newest local input the peer holds
+  int m_firstMispredictedFrame = -1;
+
+  FrameInput m_pendingLocalInput;
+  uint16_t m_localHeldBits = 0;
+  FrameInput m_lastConfirmedRemote;
+  std::array<FrameInput, INPUT_HISTORY> m_localInputs{};
+  std::array<FrameInput, INPUT_HISTORY> m_remoteInputs{};
+  std::array<FrameInput, INPUT_HISTORY> m_usedRemoteInputs{};
+  std::array<FrameSnapshot, MAX_ROLLBACK_FRAMES + 1> m_snapshots;
+
+  std::chrono::steady_clock::time_point m_epoch;
+  double m_accumulator = 0.0;
+  double m_lastHelloTime = -HELLO_INTERVAL;
+  Stats m_stats;
+
+public:
+  // Both boards are reset so that every peer starts from the same seeds
+  RollbackSession(TetrisManager &player_one, TetrisManager &player_two,
+                  const NetplayConfig &config);
+  ~RollbackSession();
+
+  // One-shot actions, consumed by the next tick
+  void queueLocalInput(FrameInput input);
+  // Held keys (FrameInput::HELD_BITS), sampled every tick until changed
+  void setLocalHeldBits(uint16_t bits);
+
+  void advance(double delta_time);
+
+  bool isOpen() const { return m_socket.isOpen(); }
+  bool isRunning() const { return m_state == State::RUNNING; }
+  State getState() const { return m_state; }
+  int getCurrentFrame() const { return m_currentFrame; }
+  uint16_t getLocalPort() const { return m_socket.getLocalPort(); }
+  const Stats &getStats() const { return m_stats; }
+
+  TetrisManager &getLocalPlayer() { return *m_players[m_localPlayer]; }
+  TetrisManager &getRemotePlayer() { return *m_players[m_remotePlayer]; }
+
+private:
+  double _now() const;
+  void _receivePackets();
+  void _acceptRemoteInput(int frame, FrameInput input);
+  void _sendHello(double now);
+  void _sendInputs(double now);
+  void _rollback();
+  void _simulateFrame(int frame);
+  FrameInput _remoteInputFor(int frame) const;
+
+  static size_t _slot(int frame) {
+    return static_cast<size_t>(frame) % INPUT_HISTORY;
+  }
+};
@@ -0,0 +1,248 @@
+#include "spectator_server.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <print>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+SpectatorServer::SpectatorServer() : m_ring(RING_SIZE) {}
+
+SpectatorServer::~SpectatorServer() { close(); }
+
+#ifdef _WIN32
+
+bool SpectatorServer::open(const SpectatorConfig &config) {
+  std::println("spectator stream is not supported on this platform");
+  return false;
+}
+
+void SpectatorServer::close() {}
+void SpectatorServer::poll() {}
+void SpectatorServer::_acceptClients() {}
+bool SpectatorServer::_flushClient(Client &client) { return false; }
+
+#else
+
+namespace {
+
+void set_non_blocking(int fd) {
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+void disable_sigpipe([[maybe_unused]] int fd) {
+#ifdef SO_NOSIGPIPE
+  int one = 1;
+  setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+}
+
+} // namespace
+
+bool SpectatorServer::open(const SpectatorConfig &config) {
+  close();
+  m_maxClients = config.maxClients;
+
+  if (!config.unixPath.empty()) {
+    sockaddr_un addr{};
+    if (config.unixPath.size() >= sizeof(addr.sun_path)) {
+      std::println("spectator socket path is too long: {}", config.unixPath);
+      return false;
+    }
+
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, config.unixPath.c_str(),
+                config.unixPath.size() + 1);
+    unlink(config.unixPath.c_str());
+
+    m_listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_listenFd < 0 ||
+        bind(m_listenFd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) !=
+            0) {
+      std::println("failed to bind spectator socket {}", config.unixPath);
+      close();
+      return false;
+    }
+    m_unixPath = config.unixPath;
+  } else {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(config.tcpPort);
+
+    m_listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    if (m_listenFd >= 0)
+      setsockopt(m_listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    if (m_listenFd < 0 ||
+        bind(m_listenFd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) !=
+            0) {
+      std::println("failed to bind spectator port {}", config.tcpPort);
+      close();
+      return false;
+    }
+  }
+
+  if (listen(m_listenFd, SOMAXCONN) != 0) {
+    std::println("failed to listen for spectators");
+    close();
+    return false;
+  }
+
+  set_non_blocking(m_listenFd);
+  return true;
+}
+
+void SpectatorServer::close() {
+  for (const Client &client : m_clients) {
+    ::close(client.fd);
+  }
+  m_clients.clear();
+  m_stats.clients = 0;
+
+  if (m_listenFd >= 0) {
+    ::close(m_listenFd);
+    m_listenFd = -1;
+  }
+
+  if (!m_unixPath.empty()) {
+    unlink(m_unixPath.c_str());
+    m_unixPath.clear();
+  }
+}
+
+void SpectatorServer::poll() {
+  if (m_listenFd < 0)
+    return;
+
+  _acceptClients();
+
+  for (size_t i = 0; i < m_clients.size();) {
+    if (_flushClient(m_clients[i])) {
+      ++i;
+      continue;
+    }
+
+    ::close(m_clients[i].fd);
+    m_clients[i] = m_clients.back();
+    m_clients.pop_back();
+    m_stats.dropped++;
+  }
+
+  m_stats.clients = m_clients.size();
+}
+
+void SpectatorServer::_acceptClients() {
+  while (true) {
+    int fd = accept(m_listenFd, nullptr, nullptr);
+    if (fd < 0)
+      return;
+
+    if (m_clients.size() >= m_maxClients) {
+      ::close(fd);
+      continue;
+    }
+
+    set_non_blocking(fd);
+    disable_sigpipe(fd);
+
+    // Late joiners start at the newest keyframe and catch up from there
+    uint64_t start = m_hasKeyframe ? m_keyframeSeq : m_nextSeq;
+    m_clients.push_back({fd, start, 0});
+    m_stats.accepted++;
+  }
+}
+
+bool SpectatorServer::_flushClient(Client &client) {
+  if (!_isBuffered(client.nextSeq) && client.nextSeq != m_nextSeq) {
+    // Too slow: the ring moved past it. Mid-message we cannot recover the
+    // framing, otherwise jump to the newest keyframe.
+    if (client.offset != 0 || !m_hasKeyframe)
+      return false;
+
+    client.nextSeq = m_keyframeSeq;
+    m_stats.resyncs++;
+  }
+
+  while (client.nextSeq < m_nextSeq) {
+    iovec iov[MAX_IOV];
+    size_t iov_count = 0;
+    size_t offset = client.offset;
+
+    for (uint64_t seq = client.nextSeq; seq < m_nextSeq && iov_count < MAX_IOV;
+         ++seq) {
+      std::vector<uint8_t> &message = m_ring[seq % RING_SIZE];
+      iov[iov_count].iov_base = message.data() + offset;
+      iov[iov_count].iov_len = message.size() - offset;
+      iov_count++;
+      offset = 0;
+    }
+
+    msghdr msg{};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iov_count;
+
+    ssize_t sent = sendmsg(client.fd, &msg, MSG_NOSIGNAL);
+    m_stats.sendCalls++;
+
+    if (sent < 0) {
+      return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+
+    m_stats.bytesSent += static_cast<uint64_t>(sent);
+
+    // Advance through the messages the kernel accepted
+    size_t remaining = static_cast<size_t>(sent);
+    for (size_t i = 0; i < iov_count && remaining > 0; ++i) {
+      if (remaining >= iov[i].iov_len) {
+        remaining -= iov[i].iov_len;
+        client.nextSeq++;
+        client.offset = 0;
+      } else {
+        client.offset += remaining;
+        remaining = 0;
+      }
+    }
+
+    // Socket buffer full, try again next poll
+    if (client.nextSeq < m_nextSeq && client.offset != 0)
+      return true;
+  }
+
+  return true;
+}
+
+#endif
+
+void SpectatorServer::publish(std::span<const uint8_t> message,
+                              bool is_keyframe) {
+  if (message.empty())
+    return;
+
+  std::vector<uint8_t> &slot = m_ring[m_nextSeq % RING_SIZE];
+  slot.assign(message.begin(), message.end());
+
+  if (is_keyframe) {
+    m_keyframeSeq = m_nextSeq;
+    m_hasKeyframe = true;
+  }
+
+  m_nextSeq++;
+}
+
+bool SpectatorServer::_isBuffered(uint64_t seq) const {
+  return seq < m_nextSeq && m_nextSeq - seq <= RING_SIZE;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+struct SpectatorConfig {
+  uint16_t tcpPort = 0;  // used when unixPath is empty
+  std::string unixPath;  // stream socket path, takes precedence over TCP
+  size_t maxClients = 10000;
+};
+
+// Fans the spectator stream out to any number of stream sockets.
+// Published messages live once in a shared ring; every client only keeps a
+// sequence number and a byte offset into it, and is flushed with one
+// scatter/gather sendmsg() pointing straight at the ring buffers, so adding
+// spectators never copies or re-encodes a message.
+class SpectatorServer {
+public:
+  static constexpr size_t RING_SIZE = 1024;
+  static constexpr size_t MAX_IOV = 64;
+
+  struct Stats {
+    size_t clients = 0;
+    uint64_t accepted = 0;
+    uint64_t dropped = 0;
+    uint64_t resyncs = 0;
+    uint64_t sendCalls = 0;
+    uint64_t bytesSent = 0;
+  };
+
+private:
+  struct Client {
+    int fd;
+    uint64_t nextSeq; // next message to send
+    size_t offset;    // bytes of nextSeq already sent
+  };
+
+  int m_listenFd = -1;
+  std::string m_unixPath;
+  size_t m_maxClients = 0;
+
+  std::vector<Client> m_clients;
+  std::vector<std::vector<uint8_t>> m_ring;
+  uint64_t m_nextSeq = 0;     // sequence of the next published message
+  uint64_t m_keyframeSeq = 0; // newest keyframe, valid once one exists
+  bool m_hasKeyframe = false;
+
+  Stats m_stats;
+
+public:
+  SpectatorServer();
+  ~SpectatorServer();
+  SpectatorServer(const SpectatorServer &) = delete;
+  SpectatorServer &operator=(const SpectatorServer &) = delete;
+
+  bool open(const SpectatorConfig &config);
+  void close();
+  bool isOpen() const { return m_listenFd >= 0; }
+
+  // Copies the encoded message once into the shared ring
+  void publish(std::span<const uint8_t> message, bool is_keyframe);
+
+  // Accepts pending connections and flushes every client's backlog
+  void poll();
+
+  const Stats &getStats() const { return m_stats; }
+
+private:
+  void _acceptClients();
+  bool _flushClient(Client &client);
+  bool _isBuffered(uint64_t seq) const;
+};
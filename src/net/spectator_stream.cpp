@@ -0,0 +1,186 @@
+#include "spectator_stream.hpp"
+#include "net/wire.hpp"
+
+#include <algorithm>
+
+namespace {
+
+using Manager = TetrisManager;
+
+uint16_t cell_index(glm::ivec3 pos) {
+  return static_cast<uint16_t>(pos.x + pos.y * Manager::SPACE_WIDTH +
+                               pos.z * Manager::SPACE_WIDTH *
+                                   Manager::SPACE_HEIGHT);
+}
+
+} // namespace
+
+SpectatorEncoder::SpectatorEncoder(uint32_t keyframe_interval)
+    : m_keyframeInterval(std::max<uint32_t>(1, keyframe_interval)) {}
+
+SpectatorEncoder::Result SpectatorEncoder::encode(TetrisManager &game,
+                                                  std::vector<uint8_t> &out) {
+  const TetrisManager::Journal &journal = game.getJournal();
+
+  bool keyframe = m_forceKeyframe || journal.epoch != m_journalEpoch ||
+                  m_tick - m_lastKeyframeTick >= m_keyframeInterval;
+
+  PiecePose piece = _capturePiece(game);
+  QueueState queue = _captureQueue(game);
+  HudState hud = _captureHud(game);
+
+  uint8_t sections = 0;
+  if (!journal.ops.empty())
+    sections |= spectator::BOARD;
+  if (piece != m_lastPiece)
+    sections |= spectator::PIECE;
+  if (queue != m_lastQueue)
+    sections |= spectator::QUEUE;
+  if (hud != m_lastHud)
+    sections |= spectator::HUD;
+
+  Result result = keyframe ? Result::KEYFRAME : Result::DELTA;
+  if (!keyframe && sections == 0) {
+    result = Result::NONE;
+  }
+
+  out.clear();
+
+  if (result != Result::NONE) {
+    wire::appendLE<uint32_t>(out, 0); // length, patched below
+    wire::appendLE<uint32_t>(out, spectator::MAGIC);
+    wire::appendLE<uint8_t>(
+        out, static_cast<uint8_t>(keyframe ? spectator::MessageType::KEYFRAME
+                                           : spectator::MessageType::DELTA));
+    wire::appendLE<uint32_t>(out, m_tick);
+
+    if (keyframe) {
+      wire::appendLE<uint8_t>(out, Manager::SPACE_WIDTH);
+      wire::appendLE<uint8_t>(out, Manager::SPACE_HEIGHT);
+      wire::appendLE<uint8_t>(out, Manager::SPACE_DEPTH);
+
+      const TetrisManager::Space &space = game.getSpace();
+      for (size_t z = 0; z < Manager::SPACE_DEPTH; ++z) {
+        for (size_t y = 0; y < Manager::SPACE_HEIGHT; ++y) {
+          for (size_t x = 0; x < Manager::SPACE_WIDTH; ++x) {
+            out.push_back(static_cast<uint8_t>(space.at(x, y, z).type));
+          }
+        }
+      }
+
+      _writePiece(piece, out);
+      _writeQueue(queue, out);
+      _writeHud(hud, out);
+
+      m_lastKeyframeTick = m_tick;
+      m_forceKeyframe = false;
+    } else {
+      wire::appendLE<uint8_t>(out, sections);
+
+      if (sections & spectator::BOARD)
+        _writeBoard(journal, out);
+      if (sections & spectator::PIECE)
+        _writePiece(piece, out);
+      if (sections & spectator::QUEUE)
+        _writeQueue(queue, out);
+      if (sections & spectator::HUD)
+        _writeHud(hud, out);
+    }
+
+    uint8_t *length = out.data();
+    wire::writeLE<uint32_t>(length, static_cast<uint32_t>(out.size() - 4));
+  }
+
+  m_lastPiece = piece;
+  m_lastQueue = queue;
+  m_lastHud = hud;
+  m_journalEpoch = journal.epoch;
+  m_tick++;
+  game.clearJournal();
+
+  return result;
+}
+
+SpectatorEncoder::PiecePose
+SpectatorEncoder::_capturePiece(const TetrisManager &game) {
+  const Tetromino &active = game.getActivePiece();
+  std::span<const glm::ivec3> offsets = active.getOffsets();
+
+  PiecePose pose;
+  pose.type = active.getType();
+  pose.position = active.getPosition();
+  pose.count = static_cast<uint8_t>(offsets.size());
+  std::ranges::copy(offsets, pose.offsets.begin());
+  return pose;
+}
+
+SpectatorEncoder::QueueState
+SpectatorEncoder::_captureQueue(const TetrisManager &game) {
+  QueueState queue;
+  queue.held = game.getHold().transform(&Tetromino::getType).value_or(
+      BlockType::None);
+
+  for (const Tetromino &piece : game.getPiecesQueue()) {
+    if (queue.count == MAX_QUEUE)
+      break;
+    queue.pieces[queue.count++] = piece.getType();
+  }
+  return queue;
+}
+
+SpectatorEncoder::HudState
+SpectatorEncoder::_captureHud(const TetrisManager &game) {
+  return {game.getScore(), game.getLinesCleared(), game.getLevel(),
+          game.getState()};
+}
+
+void SpectatorEncoder::_writeBoard(const TetrisManager::Journal &journal,
+                                   std::vector<uint8_t> &out) {
+  size_t count = std::min<size_t>(journal.ops.size(), UINT16_MAX);
+  wire::appendLE<uint16_t>(out, static_cast<uint16_t>(count));
+
+  for (size_t i = 0; i < count; ++i) {
+    const TetrisManager::BoardOp &op = journal.ops[i];
+    wire::appendLE<uint8_t>(out, static_cast<uint8_t>(op.kind));
+
+    if (op.kind == TetrisManager::BoardOp::Kind::SET_CELL) {
+      wire::appendLE<uint16_t>(out, cell_index(op.position));
+      wire::appendLE<uint8_t>(out, static_cast<uint8_t>(op.type));
+    } else {
+      wire::appendLE<uint8_t>(out, static_cast<uint8_t>(op.position.y));
+    }
+  }
+}
+
+void SpectatorEncoder::_writePiece(const PiecePose &piece,
+                                   std::vector<uint8_t> &out) {
+  wire::appendLE<uint8_t>(out, static_cast<uint8_t>(piece.type));
+  wire::appendLE<int8_t>(out, static_cast<int8_t>(piece.position.x));
+  wire::appendLE<int8_t>(out, static_cast<int8_t>(piece.position.y));
+  wire::appendLE<int8_t>(out, static_cast<int8_t>(piece.position.z));
+  wire::appendLE<uint8_t>(out, piece.count);
+
+  for (size_t i = 0; i < piece.count; ++i) {
+    wire::appendLE<int8_t>(out, static_cast<int8_t>(piece.offsets[i].x));
+    wire::appendLE<int8_t>(out, static_cast<int8_t>(piece.offsets[i].y));
+    wire::appendLE<int8_t>(out, static_cast<int8_t>(piece.offsets[i].z));
+  }
+}
+
+void SpectatorEncoder::_writeQueue(const QueueState &queue,
+                                   std::vector<uint8_t> &out) {
+  wire::appendLE<uint8_t>(out, static_cast<uint8_t>(queue.held));
+  wire::appendLE<uint8_t>(out, queue.count);
+
+  for (size_t i = 0; i < queue.count; ++i) {
+    wire::appendLE<uint8_t>(out, static_cast<uint8_t>(queue.pieces[i]));
+  }
+}
+
+void SpectatorEncoder::_writeHud(const HudState &hud,
+                                 std::vector<uint8_t> &out) {
+  wire::appendLE<uint64_t>(out, hud.score);
+  wire::appendLE<uint64_t>(out, hud.lines);
+  wire::appendLE<uint8_t>(out, hud.level);
+  wire::appendLE<uint8_t>(out, static_cast<uint8_t>(hud.state));
+}
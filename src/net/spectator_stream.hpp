@@ -0,0 +1,107 @@
+#pragma once
+
+#include "game/tetris_manager.hpp"
+#include "game/tetromino.hpp"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Stream format, a sequence of length prefixed messages (little endian):
+//   u32 length of the rest | u32 magic | u8 type | u32 tick | payload
+//
+// KEYFRAME payload: u8 width | u8 height | u8 depth | u8 cell[w*h*d]
+//                   | PIECE | QUEUE | HUD
+// DELTA payload:    u8 section flags | BOARD? | PIECE? | QUEUE? | HUD?
+//
+// BOARD: u16 op count, then per op u8 kind followed by
+//          SET_CELL:     u16 cell index (x + y*w + z*w*h) | u8 block type
+//          REMOVE_LAYER: u8 y (rows above shift down, an empty row enters)
+// PIECE: u8 type | i8 x, y, z | u8 count | i8 offset x, y, z per cell
+// QUEUE: u8 held type | u8 count | u8 type per queued piece
+// HUD:   u64 score | u64 lines | u8 level | u8 game state
+//
+// A late joiner starts at the newest keyframe and applies every delta after
+// it; a new keyframe is emitted every few seconds or whenever the board
+// jumps (reset, rollback).
+namespace spectator {
+
+constexpr uint32_t MAGIC = 0x53443354; // "T3DS"
+
+enum class MessageType : uint8_t { KEYFRAME = 1, DELTA = 2 };
+
+enum Section : uint8_t {
+  BOARD = 1 << 0,
+  PIECE = 1 << 1,
+  QUEUE = 1 << 2,
+  HUD = 1 << 3,
+};
+
+} // namespace spectator
+
+class SpectatorEncoder {
+public:
+  static constexpr uint32_t DEFAULT_KEYFRAME_INTERVAL = 120;
+  static constexpr size_t MAX_QUEUE = 8;
+
+  enum class Result : uint8_t { NONE, DELTA, KEYFRAME };
+
+private:
+  struct PiecePose {
+    BlockType type = BlockType::None;
+    glm::ivec3 position{0};
+    std::array<glm::ivec3, Tetromino::MAX_CELLS> offsets{};
+    uint8_t count = 0;
+
+    bool operator==(const PiecePose &) const = default;
+  };
+
+  struct QueueState {
+    BlockType held = BlockType::None;
+    std::array<BlockType, MAX_QUEUE> pieces{};
+    uint8_t count = 0;
+
+    bool operator==(const QueueState &) const = default;
+  };
+
+  struct HudState {
+    uint64_t score = 0;
+    uint64_t lines = 0;
+    uint8_t level = 0;
+    TetrisManager::GameState state = TetrisManager::GameState::FALLING;
+
+    bool operator==(const HudState &) const = default;
+  };
+
+  uint32_t m_keyframeInterval;
+  uint32_t m_tick = 0;
+  uint32_t m_lastKeyframeTick = 0;
+  bool m_forceKeyframe = true;
+  uint32_t m_journalEpoch = 0;
+
+  PiecePose m_lastPiece;
+  QueueState m_lastQueue;
+  HudState m_lastHud;
+
+public:
+  explicit SpectatorEncoder(
+      uint32_t keyframe_interval = DEFAULT_KEYFRAME_INTERVAL);
+
+  // Encodes one tick into `out` and consumes the game's journal.
+  // Ticks where nothing changed produce no message.
+  Result encode(TetrisManager &game, std::vector<uint8_t> &out);
+
+  void requestKeyframe() { m_forceKeyframe = true; }
+  uint32_t getTick() const { return m_tick; }
+
+private:
+  static PiecePose _capturePiece(const TetrisManager &game);
+  static QueueState _captureQueue(const TetrisManager &game);
+  static HudState _captureHud(const TetrisManager &game);
+
+  static void _writeBoard(const TetrisManager::Journal &journal,
+                          std::vector<uint8_t> &out);
+  static void _writePiece(const PiecePose &piece, std::vector<uint8_t> &out);
+  static void _writeQueue(const QueueState &queue, std::vector<uint8_t> &out);
+  static void _writeHud(const HudState &hud, std::vector<uint8_t> &out);
+};
@@ -0,0 +1,160 @@
+#include "udp_socket.hpp"
+
+#include <charconv>
+#include <print>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#ifdef _WIN32
+struct WinsockInit {
+  WinsockInit() {
+    WSADATA data;
+    WSAStartup(MAKEWORD(2, 2), &data);
+  }
+  ~WinsockInit() { WSACleanup(); }
+};
+#endif
+
+sockaddr_in to_sockaddr(const UdpAddress &address) {
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(address.host);
+  addr.sin_port = htons(address.port);
+  return addr;
+}
+
+} // namespace
+
+std::optional<UdpAddress> UdpAddress::parse(std::string_view text) {
+  UdpAddress address;
+  const char *cursor = text.data();
+  const char *end = text.data() + text.size();
+
+  for (int i = 0; i < 4; ++i) {
+    unsigned int octet = 0;
+    auto [next, ec] = std::from_chars(cursor, end, octet);
+    if (ec != std::errc() || octet > 255)
+      return std::nullopt;
+
+    address.host = (address.host << 8) | octet;
+    cursor = next;
+
+    char expected = (i < 3) ? '.' : ':';
+    if (cursor == end || *cursor != expected)
+      return std::nullopt;
+    ++cursor;
+  }
+
+  auto [next, ec] = std::from_chars(cursor, end, address.port);
+  if (ec != std::errc() || next != end)
+    return std::nullopt;
+
+  return address;
+}
+
+UdpSocket::~UdpSocket() { close(); }
+
+bool UdpSocket::open(uint16_t port) {
+#ifdef _WIN32
+  static WinsockInit winsock;
+#endif
+  close();
+
+  m_handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+#ifdef _WIN32
+  if (m_handle == INVALID_SOCKET) {
+#else
+  if (m_handle < 0) {
+#endif
+    std::println("failed to create udp socket");
+    return false;
+  }
+  m_open = true;
+
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(port);
+
+  if (bind(m_handle, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+    std::println("failed to bind udp socket to port {}", port);
+    close();
+    return false;
+  }
+
+#ifdef _WIN32
+  u_long non_blocking = 1;
+  ioctlsocket(m_handle, FIONBIO, &non_blocking);
+#else
+  fcntl(m_handle, F_SETFL, fcntl(m_handle, F_GETFL, 0) | O_NONBLOCK);
+#endif
+
+  return true;
+}
+
+void UdpSocket::close() {
+  if (!m_open)
+    return;
+
+#ifdef _WIN32
+  closesocket(m_handle);
+#else
+  ::close(m_handle);
+#endif
+  m_open = false;
+}
+
+uint16_t UdpSocket::getLocalPort() const {
+  if (!m_open)
+    return 0;
+
+  sockaddr_in addr{};
+  socklen_t length = sizeof(addr);
+  if (getsockname(m_handle, reinterpret_cast<sockaddr *>(&addr), &length) !=
+      0)
+    return 0;
+
+  return ntohs(addr.sin_port);
+}
+
+bool UdpSocket::sendTo(const UdpAddress &to, std::span<const uint8_t> data) {
+  if (!m_open)
+    return false;
+
+  sockaddr_in addr = to_sockaddr(to);
+  auto sent = sendto(m_handle, reinterpret_cast<const char *>(data.data()),
+                     static_cast<int>(data.size()), 0,
+                     reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+
+  return sent == static_cast<decltype(sent)>(data.size());
+}
+
+std::optional<size_t> UdpSocket::receiveFrom(std::span<uint8_t> buffer,
+                                             UdpAddress &from) {
+  if (!m_open)
+    return std::nullopt;
+
+  sockaddr_in addr{};
+  socklen_t length = sizeof(addr);
+  auto received = recvfrom(m_handle, reinterpret_cast<char *>(buffer.data()),
+                           static_cast<int>(buffer.size()), 0,
+                           reinterpret_cast<sockaddr *>(&addr), &length);
+
+  if (received < 0)
+    return std::nullopt;
+
+  from.host = ntohl(addr.sin_addr.s_addr);
+  from.port = ntohs(addr.sin_port);
+  return static_cast<size_t>(received);
+}
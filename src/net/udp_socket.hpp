@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+
+// IPv4 endpoint, host byte order
+struct UdpAddress {
+  uint32_t host = 0;
+  uint16_t port = 0;
+
+  // Parses "a.b.c.d:port"
+  static std::optional<UdpAddress> parse(std::string_view text);
+  static UdpAddress loopback(uint16_t port) { return {0x7F000001u, port}; }
+
+  bool operator==(const UdpAddress &) const = default;
+};
+
+// Non-blocking UDP socket bound to all interfaces
+class UdpSocket {
+private:
+#ifdef _WIN32
+  using Handle = uintptr_t;
+#else
+  using Handle = int;
+#endif
+
+  Handle m_handle;
+  bool m_open = false;
+
+public:
+  UdpSocket() = default;
+  ~UdpSocket();
+  UdpSocket(const UdpSocket &) = delete;
+  UdpSocket &operator=(const UdpSocket &) = delete;
+
+  UdpSocket(UdpSocket &&other) noexcept
+      : m_handle(other.m_handle), m_open(other.m_open) {
+    other.m_open = false;
+  }
+
+  // Port 0 lets the OS pick an ephemeral port
+  bool open(uint16_t port = 0);
+  void close();
+  bool isOpen() const { return m_open; }
+  uint16_t getLocalPort() const;
+
+  bool sendTo(const UdpAddress &to, std::span<const uint8_t> data);
+
+  // Returns the datagram size, or nothing when no datagram is pending
+  std::optional<size_t> receiveFrom(std::span<uint8_t> buffer,
+                                    UdpAddress &from);
+};
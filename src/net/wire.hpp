@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+// Little endian helpers shared by the netplay and spectator wire formats
+namespace wire {
+
+template <typename T> void writeLE(uint8_t *&cursor, T value) {
+  auto raw = static_cast<std::make_unsigned_t<T>>(value);
+  for (size_t i = 0; i < sizeof(T); ++i) {
+    *cursor++ = static_cast<uint8_t>(raw >> (8 * i));
+  }
+}
+
+template <typename T> T readLE(const uint8_t *&cursor) {
+  std::make_unsigned_t<T> raw = 0;
+  for (size_t i = 0; i < sizeof(T); ++i) {
+    raw |= static_cast<std::make_unsigned_t<T>>(*cursor++) << (8 * i);
+  }
+  return static_cast<T>(raw);
+}
+
+template <typename T> void appendLE(std::vector<uint8_t> &out, T value) {
+  size_t at = out.size();
+  out.resize(at + sizeof(T));
+  uint8_t *cursor = out.data() + at;
+  writeLE(cursor, value);
+}
+
+} // namespace wire
@@ -1,4 +1,15 @@
 #include "font.hpp"
+#include "core/asset_archive_format.hpp"
+#include "core/texture_manager.hpp"
+#include "ui/utf8.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <print>
 #include <vector>
 
 // Simple 8x8 font bitmask for ASCII 32-126
@@ -102,72 +113,244 @@ static const unsigned char font8x8_basic[95][8] = {
 
 BitmapFont::BitmapFont() {}
 
-BitmapFont::~BitmapFont() {
-  if (texID)
-    glDeleteTextures(1, &texID);
+bool BitmapFont::loadFont(std::span<const std::byte> glyphs,
+                          const std::filesystem::path &cache_dir) {
+  if (glyphs.size() != sizeof(font8x8_basic))
+    return false;
+
+  _generate_font_texture(
+      reinterpret_cast<const unsigned char(*)[8]>(glyphs.data()), cache_dir);
+  return true;
 }
 
-bool BitmapFont::loadDefaultFont() {
-  _generate_font_texture();
+bool BitmapFont::loadDefaultFont(const std::filesystem::path &cache_dir) {
+  _generate_font_texture(font8x8_basic, cache_dir);
   return true;
 }
 
-const Character &BitmapFont::getCharacter(char c) const {
-  if (c < 32 || c > 126)
-    return m_characters[32]; // Return space for unknown
-  return m_characters[(int)c];
+std::vector<unsigned char>
+BitmapFont::_readTrueType(const std::filesystem::path &path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file)
+    return {};
+  return {std::istreambuf_iterator<char>(file),
+          std::istreambuf_iterator<char>()};
 }
 
-float BitmapFont::getTextWidth(const std::string &text, float scale) const {
-  float width = 0;
-  for (char c : text) {
-    const Character &ch = getCharacter(c);
-    width += ch.advance * scale;
+bool BitmapFont::loadTrueType(const std::filesystem::path &path) {
+  std::vector<unsigned char> ttf = _readTrueType(path);
+  if (ttf.empty())
+    return false;
+
+  if (!m_glyphs.loadFont(std::move(ttf))) {
+    std::println("BitmapFont: {} is not a TrueType font", path.string());
+    return false;
   }
+  m_fallbackOnly = false;
+  std::println("BitmapFont: text uses {}", path.string());
+  return true;
+}
+
+bool BitmapFont::loadTrueType(std::span<const std::byte> ttf) {
+  if (ttf.empty())
+    return false;
+
+  auto bytes = reinterpret_cast<const unsigned char *>(ttf.data());
+  if (!m_glyphs.loadFont({bytes, bytes + ttf.size()}))
+    return false;
+  m_fallbackOnly = false;
+  return true;
+}
+
+bool BitmapFont::loadFallbackFont(const std::filesystem::path &path) {
+  std::vector<unsigned char> ttf = _readTrueType(path);
+  if (ttf.empty() || !m_glyphs.loadFont(std::move(ttf)))
+    return false;
+
+  m_fallbackOnly = true;
+  std::println("BitmapFont: text beyond ASCII uses {}", path.string());
+  return true;
+}
+
+const Character &BitmapFont::getCharacter(char32_t code_point) {
+  if (m_glyphs.isLoaded() && (!m_fallbackOnly || code_point > 126))
+    return m_glyphs.get(code_point);
+
+  if (code_point > 126)
+    return m_characters['?'];
+  if (code_point < 32)
+    return m_characters[' '];
+  return m_characters[code_point];
+}
+
+float BitmapFont::getTextWidth(std::string_view text, float scale) {
+  float width = 0;
+  for (size_t pos = 0; pos < text.size();)
+    width += getCharacter(utf8::decode(text, pos)).advance * scale;
   return width;
 }
 
-void BitmapFont::_generate_font_texture() {
-  int texWidth = 128;
-  int texHeight = 128;
-  std::vector<unsigned char> data(texWidth * texHeight, 0);
-
-  for (int i = 0; i < 95; ++i) {
-    char c = (char)(i + 32);
-    int gridX = i % 16;
-    int gridY = i / 16;
-    int startX = gridX * 8;
-    int startY = gridY * 8;
-
-    for (int y = 0; y < 8; ++y) {
-      unsigned char row = font8x8_basic[i][y];
-      for (int x = 0; x < 8; ++x) {
-        if (row & (1 << (7 - x))) {
-          data[(startY + y) * texWidth + (startX + x)] = 255;
+void BitmapFont::update() {
+  if (m_glyphs.isLoaded())
+    m_glyphs.update();
+}
+
+void BitmapFont::flush() {
+  if (m_glyphs.isLoaded())
+    m_glyphs.flush();
+}
+
+// Every texel stores the distance from its center to the nearest edge of
+// the glyph, in texels: positive inside, negative outside, mapped from
+// [-SDF_SPREAD, SDF_SPREAD] to [0, 255]. Source pixels outside the 8x8 grid
+// count as empty. Brute force over the 10x10 neighbourhood is plenty for 95
+// small glyphs.
+std::vector<unsigned char>
+BitmapFont::_build_sdf_sheet(const unsigned char (*glyphs)[8]) {
+  int rows = (GLYPH_COUNT + SHEET_COLUMNS - 1) / SHEET_COLUMNS;
+  int width = SHEET_COLUMNS * CELL_SIZE;
+  std::vector<unsigned char> sheet(width * rows * CELL_SIZE, 0);
+
+  auto filled = [](const unsigned char *glyph, int x, int y) {
+    return x >= 0 && y >= 0 && x < GLYPH_PIXELS && y < GLYPH_PIXELS &&
+           (glyph[y] & (1 << (7 - x)));
+  };
+
+  for (int i = 0; i < GLYPH_COUNT; ++i) {
+    const unsigned char *glyph = glyphs[i];
+    int cellX = (i % SHEET_COLUMNS) * CELL_SIZE;
+    int cellY = (i / SHEET_COLUMNS) * CELL_SIZE;
+
+    for (int ty = 0; ty < CELL_SIZE; ++ty) {
+      for (int tx = 0; tx < CELL_SIZE; ++tx) {
+        // Texel center in font units
+        float px = (tx + 0.5f - SDF_SPREAD) / SDF_SCALE;
+        float py = (ty + 0.5f - SDF_SPREAD) / SDF_SCALE;
+        bool inside = filled(glyph, (int)std::floor(px), (int)std::floor(py));
+
+        float nearest = 1e9f;
+        for (int sy = -1; sy <= GLYPH_PIXELS; ++sy) {
+          for (int sx = -1; sx <= GLYPH_PIXELS; ++sx) {
+            if (filled(glyph, sx, sy) == inside)
+              continue;
+            float dx = std::max({sx - px, 0.0f, px - (sx + 1)});
+            float dy = std::max({sy - py, 0.0f, py - (sy + 1)});
+            nearest = std::min(nearest, dx * dx + dy * dy);
+          }
         }
+
+        float distance = std::sqrt(nearest) * SDF_SCALE;
+        float signed_distance = inside ? distance : -distance;
+        float value = 0.5f + 0.5f * signed_distance / SDF_SPREAD;
+        sheet[(cellY + ty) * width + cellX + tx] = static_cast<unsigned char>(
+            std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
       }
     }
+  }
+
+  return sheet;
+}
+
+namespace {
+
+constexpr uint32_t SDF_CACHE_MAGIC = 0x44533354; // "T3SD"
+
+struct SdfCacheHeader {
+  uint32_t magic;
+  uint32_t width;
+  uint32_t height;
+  uint32_t reserved;
+  uint64_t key;
+};
 
-    m_characters[(int)c] = {
-        glm::vec2((float)startX / texWidth, (float)startY / texHeight),
-        glm::vec2((float)(startX + 8) / texWidth,
-                  (float)(startY + 8) / texHeight),
-        glm::ivec2(8, 8), glm::ivec2(0, 0), 8};
+std::optional<std::vector<unsigned char>>
+loadCachedSheet(const std::filesystem::path &path, uint64_t key, int width,
+                int height) {
+  std::ifstream file(path, std::ios::binary);
+  SdfCacheHeader header{};
+  if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+      header.magic != SDF_CACHE_MAGIC || header.key != key ||
+      header.width != (uint32_t)width || header.height != (uint32_t)height)
+    return std::nullopt;
+
+  std::vector<unsigned char> sheet(width * height);
+  if (!file.read(reinterpret_cast<char *>(sheet.data()), sheet.size()))
+    return std::nullopt;
+  return sheet;
+}
+
+void storeCachedSheet(const std::filesystem::path &path, uint64_t key,
+                      int width, int height,
+                      const std::vector<unsigned char> &sheet) {
+  std::error_code error;
+  std::filesystem::create_directories(path.parent_path(), error);
+
+  // Written under a temporary name so a crash never leaves half a sheet
+  std::filesystem::path temp = path;
+  temp += ".tmp";
+  {
+    std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+    SdfCacheHeader header{SDF_CACHE_MAGIC, (uint32_t)width, (uint32_t)height,
+                          0, key};
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(sheet.data()), sheet.size());
+    if (!file) {
+      std::println("BitmapFont: cannot write {}", temp.string());
+      return;
+    }
   }
 
-  glGenTextures(1, &texID);
-  glBindTexture(GL_TEXTURE_2D, texID);
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, texWidth, texHeight, 0, GL_RED,
-               GL_UNSIGNED_BYTE, data.data());
+  std::filesystem::rename(temp, path, error);
+  if (error)
+    std::println("BitmapFont: cannot write {}: {}", path.string(),
+                 error.message());
+}
+
+} // namespace
+
+void BitmapFont::_generate_font_texture(
+    const unsigned char (*glyphs)[8], const std::filesystem::path &cache_dir) {
+  int sheetWidth = SHEET_COLUMNS * CELL_SIZE;
+  int sheetHeight =
+      (GLYPH_COUNT + SHEET_COLUMNS - 1) / SHEET_COLUMNS * CELL_SIZE;
+
+  // Keyed by the glyph bits and every parameter that shapes the field
+  std::string keySource(reinterpret_cast<const char *>(glyphs),
+                        GLYPH_COUNT * GLYPH_PIXELS);
+  keySource += std::format("|{}|{}", SDF_SCALE, SDF_SPREAD);
+  uint64_t key = asset_archive::hashName(keySource);
+  std::filesystem::path cachePath =
+      cache_dir.empty()
+          ? std::filesystem::path()
+          : cache_dir / std::format("font_sdf-{:016x}.bin", key);
 
-  // Simple swizzling to make it white/transparent or just use GL_RED in shader
-  GLint swizzleMask[] = {GL_ONE, GL_ONE, GL_ONE, GL_RED};
-  glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzleMask);
+  std::optional<std::vector<unsigned char>> sheet;
+  if (!cachePath.empty())
+    sheet = loadCachedSheet(cachePath, key, sheetWidth, sheetHeight);
+  if (!sheet) {
+    sheet = _build_sdf_sheet(glyphs);
+    if (!cachePath.empty())
+      storeCachedSheet(cachePath, key, sheetWidth, sheetHeight, *sheet);
+  }
 
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  // White texels, the distance goes into alpha
+  std::vector<unsigned char> rgba(sheet->size() * 4);
+  for (size_t i = 0; i < sheet->size(); ++i) {
+    rgba[i * 4 + 0] = rgba[i * 4 + 1] = rgba[i * 4 + 2] = 255;
+    rgba[i * 4 + 3] = (*sheet)[i];
+  }
+  m_region = TextureManager::getUIAtlas().add(sheetWidth, sheetHeight, rgba);
 
-  glBindTexture(GL_TEXTURE_2D, 0);
+  // Quads cover the whole cell, so the border of the field is drawn too
+  glm::vec2 sheetSize(sheetWidth, sheetHeight);
+  int border = SDF_SPREAD / SDF_SCALE;
+  for (int i = 0; i < GLYPH_COUNT; ++i) {
+    glm::vec2 cell((i % SHEET_COLUMNS) * CELL_SIZE,
+                   (i / SHEET_COLUMNS) * CELL_SIZE);
+    m_characters[i + 32] = {
+        m_region.map(cell / sheetSize),
+        m_region.map((cell + glm::vec2(CELL_SIZE)) / sheetSize),
+        glm::vec2(GLYPH_PIXELS + 2 * border), glm::vec2(-border),
+        GLYPH_PIXELS, m_region.texture};
+  }
 }
@@ -1,30 +1,76 @@
 #pragma once
 
+#include "core/texture_atlas.hpp"
+#include "ui/glyph_cache.hpp"
+
 #include <glad/gl.h>
 #include <glm/glm.hpp>
+#include <cstddef>
+#include <filesystem>
 #include <map>
+#include <span>
 #include <string>
+#include <string_view>
+#include <vector>
 
-struct Character {
-  glm::vec2 uvMin;
-  glm::vec2 uvMax;
-  glm::ivec2 size;
-  glm::ivec2 bearing;
-  unsigned int advance;
-};
-
+// The 8x8 bitmap glyphs turned into a signed distance field, so one atlas
+// entry renders crisply at any scale (ui.frag.glsl thresholds the alpha at
+// 0.5). Building the field takes a moment, so the finished sheet is cached
+// on disk, keyed by the glyph data.
 class BitmapFont {
 public:
+  // Distance field texels per font unit, and the border around each glyph
+  // in texels; the field encodes +-SDF_SPREAD texels
+  static constexpr int SDF_SCALE = 4;
+  static constexpr int SDF_SPREAD = 4;
+  static constexpr int GLYPH_PIXELS = 8;
+  static constexpr int CELL_SIZE = GLYPH_PIXELS * SDF_SCALE + 2 * SDF_SPREAD;
+  static constexpr int SHEET_COLUMNS = 16;
+  static constexpr int GLYPH_COUNT = 95;
+
   BitmapFont();
-  ~BitmapFont();
 
-  bool loadDefaultFont();
-  GLuint getTexID() const { return texID; }
-  const Character &getCharacter(char c) const;
-  float getTextWidth(const std::string &text, float scale) const;
+  // 95 glyphs (ASCII 32-126) of 8 one-byte rows, MSB leftmost, as in
+  // assets/fonts/font8x8.bin; false if the data has the wrong size.
+  // An empty cache_dir always rebuilds the distance field.
+  bool loadFont(std::span<const std::byte> glyphs,
+                const std::filesystem::path &cache_dir = {});
+  // Same glyphs, compiled in
+  bool loadDefaultFont(const std::filesystem::path &cache_dir = {});
+  // Draws everything through a TrueType font from here on, any Unicode
+  // text included; false if the file is missing or unreadable
+  bool loadTrueType(const std::filesystem::path &path);
+  bool loadTrueType(std::span<const std::byte> ttf);
+  // A TrueType font for code points beyond ASCII only; the bitmap glyphs
+  // keep drawing ASCII
+  bool loadFallbackFont(const std::filesystem::path &path);
+  bool hasTrueType() const { return m_glyphs.isLoaded(); }
+
+  // The bitmap glyphs live in TextureManager's UI atlas
+  GLuint getTexID() const { return m_region.texture; }
+  // Without a TrueType font (or fallback), code points outside ASCII draw
+  // as '?'
+  const Character &getCharacter(char32_t code_point);
+  // UTF-8
+  float getTextWidth(std::string_view text, float scale);
+
+  // Rasterizes glyphs requested since the last frame, within a budget
+  void update();
+  // All of them, whatever it costs; see GlyphCache::flush
+  void flush();
+  bool isLoading() const { return m_glyphs.getPendingCount() > 0; }
+  // See GlyphCache::getGeneration; constant for the bitmap font
+  uint64_t getGeneration() const { return m_glyphs.getGeneration(); }
 
 private:
-  GLuint texID = 0;
+  AtlasRegion m_region;
   Character m_characters[256];
-  void _generate_font_texture();
+  GlyphCache m_glyphs;
+  bool m_fallbackOnly = false; // m_glyphs only draws beyond ASCII
+  static std::vector<unsigned char>
+  _readTrueType(const std::filesystem::path &path);
+  void _generate_font_texture(const unsigned char (*glyphs)[8],
+                              const std::filesystem::path &cache_dir);
+  static std::vector<unsigned char>
+  _build_sdf_sheet(const unsigned char (*glyphs)[8]);
 };
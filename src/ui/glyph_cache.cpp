@@ -0,0 +1,216 @@
+#include "glyph_cache.hpp"
+#include "core/trace.hpp"
+#include "ui/truetype.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <print>
+
+namespace {
+
+// Distance field encoding: 128 on the outline, SDF_PADDING texels away
+// reaches 0 or 255, matching the bitmap font's sheet
+constexpr unsigned char ON_EDGE = 128;
+constexpr float DISTANCE_SCALE = 128.0f / GlyphCache::SDF_PADDING;
+
+} // namespace
+
+GlyphCache::GlyphCache() = default;
+
+GlyphCache::~GlyphCache() {
+  if (!m_pages.empty())
+    glDeleteTextures(static_cast<GLsizei>(m_pages.size()), m_pages.data());
+}
+
+bool GlyphCache::loadFont(std::vector<unsigned char> ttf) {
+  auto font = std::make_unique<TrueTypeFont>();
+  if (!font->load(ttf))
+    return false;
+
+  // TrueTypeFont views the file data, which moves along intact
+  m_fontData = std::move(ttf);
+  m_font = std::move(font);
+  m_scale = m_font->scaleForPixelHeight(PIXEL_HEIGHT);
+  m_baseline = m_font->getAscent() * m_scale;
+
+  // Glyphs of a previous font are all stale
+  m_entries.clear();
+  m_pending.clear();
+  m_freeCells.clear();
+  for (int cell = (int)m_pages.size() * CELLS_PER_PAGE - 1; cell >= 0; --cell)
+    m_freeCells.push_back(cell);
+  ++m_generation;
+  return true;
+}
+
+const Character &GlyphCache::get(char32_t code_point) {
+  auto [it, inserted] = m_entries.try_emplace(code_point);
+  Entry &entry = it->second;
+  entry.lastUsed = m_frame;
+
+  if (inserted) {
+    // The advance is known before the glyph is rasterized, so layout is
+    // final right away and only the quad appears later
+    int advance = m_font->getAdvance(m_font->findGlyph(code_point));
+    entry.character.advance = advance * m_scale / TEXELS_PER_UNIT;
+    m_pending.push_back(code_point);
+  }
+  return entry.character;
+}
+
+void GlyphCache::update() {
+  ++m_frame;
+  if (m_pending.empty())
+    return;
+
+  TRACE_SCOPE("GlyphCache::update");
+  _rasterizePending(
+      std::chrono::duration<double, std::milli>(UPLOAD_BUDGET_MS));
+}
+
+void GlyphCache::flush() {
+  if (m_pending.empty())
+    return;
+
+  TRACE_SCOPE("GlyphCache::flush");
+  _rasterizePending(std::chrono::duration<double, std::milli>::max());
+}
+
+void GlyphCache::_rasterizePending(
+    std::chrono::duration<double, std::milli> budget) {
+  auto start = std::chrono::steady_clock::now();
+
+  size_t done = 0;
+  while (done < m_pending.size()) {
+    // Always make progress by at least one glyph
+    if (done > 0 && std::chrono::steady_clock::now() - start > budget)
+      break;
+
+    auto it = m_entries.find(m_pending[done]);
+    if (it != m_entries.end() && it->second.cell == PENDING &&
+        !_rasterize(it->first, it->second))
+      break;
+    ++done;
+  }
+
+  m_pending.erase(m_pending.begin(), m_pending.begin() + done);
+  if (done > 0)
+    ++m_generation;
+}
+
+bool GlyphCache::_rasterize(char32_t code_point, Entry &entry) {
+  // Empty for whitespace and for glyphs too big for a cell (huge symbols),
+  // which draw nothing rather than clipped
+  TrueTypeFont::Field field =
+      m_font->buildField(m_font->findGlyph(code_point), m_scale, SDF_PADDING,
+                         ON_EDGE, DISTANCE_SCALE, CELL_SIZE);
+  if (field.texels.empty()) {
+    entry.cell = EMPTY;
+    return true;
+  }
+
+  std::optional<int> cell = _acquireCell();
+  if (!cell)
+    return false;
+
+  // The whole cell is written so nothing of an evicted glyph survives at
+  // the edges that filtering reaches
+  const int width = field.width;
+  const int height = field.height;
+  std::vector<unsigned char> texels(CELL_SIZE * CELL_SIZE, 0);
+  for (int y = 0; y < height; ++y)
+    std::copy_n(field.texels.data() + y * width, width,
+                texels.data() + y * CELL_SIZE);
+
+  GLuint page = m_pages[*cell / CELLS_PER_PAGE];
+  int index = *cell % CELLS_PER_PAGE;
+  glm::ivec2 origin(index % CELLS_PER_ROW * CELL_SIZE,
+                    index / CELLS_PER_ROW * CELL_SIZE);
+  glTextureSubImage2D(page, 0, origin.x, origin.y, CELL_SIZE, CELL_SIZE,
+                      GL_RED, GL_UNSIGNED_BYTE, texels.data());
+
+  glm::vec2 size(width, height);
+  Character &character = entry.character;
+  character.uvMin = glm::vec2(origin) / float(PAGE_SIZE);
+  character.uvMax = (glm::vec2(origin) + size) / float(PAGE_SIZE);
+  character.size = size / TEXELS_PER_UNIT;
+  character.bearing =
+      glm::vec2(field.offset.x, m_baseline + field.offset.y) /
+      TEXELS_PER_UNIT;
+  character.texture = page;
+  entry.cell = *cell;
+  return true;
+}
+
+std::optional<int> GlyphCache::_acquireCell() {
+  if (m_freeCells.empty() && m_pages.size() < MAX_PAGES)
+    _newPage();
+
+  if (m_freeCells.empty()) {
+    // Everything is taken. Bump the generation so all visible text lays
+    // out again (touching its glyphs) and evict next frame what it left.
+    if (m_markFrame == 0) {
+      m_markFrame = m_frame;
+      ++m_generation;
+      return std::nullopt;
+    }
+    if (m_frame == m_markFrame)
+      return std::nullopt;
+
+    _evictUnused();
+    m_markFrame = 0;
+    if (m_freeCells.empty()) {
+      std::println("GlyphCache: more glyphs on screen than {} pages hold",
+                   MAX_PAGES);
+      return std::nullopt;
+    }
+  }
+
+  int cell = m_freeCells.back();
+  m_freeCells.pop_back();
+  return cell;
+}
+
+void GlyphCache::_evictUnused() {
+  std::vector<std::pair<uint64_t, char32_t>> unused;
+  for (const auto &[code_point, entry] : m_entries) {
+    if (entry.cell >= 0 && entry.lastUsed < m_markFrame)
+      unused.emplace_back(entry.lastUsed, code_point);
+  }
+
+  // Oldest first, enough for everything queued
+  size_t count = std::min(unused.size(), m_pending.size());
+  std::partial_sort(unused.begin(), unused.begin() + count, unused.end());
+  for (size_t i = 0; i < count; ++i) {
+    auto it = m_entries.find(unused[i].second);
+    m_freeCells.push_back(it->second.cell);
+    m_entries.erase(it);
+  }
+  if (count > 0)
+    ++m_generation;
+}
+
+void GlyphCache::_newPage() {
+  GLuint texture;
+  glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+  glTextureStorage2D(texture, 1, GL_R8, PAGE_SIZE, PAGE_SIZE);
+
+  const unsigned char clear = 0;
+  glClearTexImage(texture, 0, GL_RED, GL_UNSIGNED_BYTE, &clear);
+
+  glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  // Read as white with the distance in alpha, like the bitmap font sheet
+  glTextureParameteri(texture, GL_TEXTURE_SWIZZLE_R, GL_ONE);
+  glTextureParameteri(texture, GL_TEXTURE_SWIZZLE_G, GL_ONE);
+  glTextureParameteri(texture, GL_TEXTURE_SWIZZLE_B, GL_ONE);
+  glTextureParameteri(texture, GL_TEXTURE_SWIZZLE_A, GL_RED);
+
+  int first = static_cast<int>(m_pages.size()) * CELLS_PER_PAGE;
+  m_pages.push_back(texture);
+  // Hand out cells from the top-left
+  for (int cell = first + CELLS_PER_PAGE - 1; cell >= first; --cell)
+    m_freeCells.push_back(cell);
+}
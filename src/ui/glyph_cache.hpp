@@ -0,0 +1,102 @@
+#pragma once
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+class TrueTypeFont;
+
+// Metrics in font units (one source pixel of the 8x8 glyphs, so a line of
+// text is 8 units tall whichever font draws it)
+struct Character {
+  glm::vec2 uvMin{0.0f};
+  glm::vec2 uvMax{0.0f};
+  glm::vec2 size{0.0f};    // quad size, including the distance field border
+  glm::vec2 bearing{0.0f}; // quad offset from the pen position
+  float advance = 0.0f;
+  GLuint texture = 0; // 0 while the glyph has nothing to draw
+};
+
+// TrueType glyphs rasterized on demand as distance fields into R8 pages of
+// fixed-size cells. get() only queues a missing glyph; update() rasterizes
+// the queue within UPLOAD_BUDGET_MS per frame, so new text never stalls a
+// frame. Once every page is full the least recently used cells are reused.
+class GlyphCache {
+public:
+  // Rasterized line height in texels, 4 texels per font unit
+  static constexpr int PIXEL_HEIGHT = 32;
+  static constexpr float TEXELS_PER_UNIT = PIXEL_HEIGHT / 8.0f;
+  // Distance field border; the field encodes +-SDF_PADDING texels
+  static constexpr int SDF_PADDING = 4;
+  static constexpr int CELL_SIZE = 48;
+  static constexpr int PAGE_SIZE = 1024;
+  static constexpr int CELLS_PER_ROW = PAGE_SIZE / CELL_SIZE;
+  static constexpr int CELLS_PER_PAGE = CELLS_PER_ROW * CELLS_PER_ROW;
+  static constexpr int MAX_PAGES = 2;
+  static constexpr double UPLOAD_BUDGET_MS = 1.0;
+
+private:
+  static constexpr int PENDING = -1; // queued for rasterization
+  static constexpr int EMPTY = -2;   // whitespace, nothing to upload
+
+  struct Entry {
+    Character character;
+    int cell = PENDING;
+    uint64_t lastUsed = 0;
+  };
+
+  std::vector<unsigned char> m_fontData;
+  std::unique_ptr<TrueTypeFont> m_font;
+  float m_scale = 0.0f; // font design units to texels
+  float m_baseline = 0.0f;
+
+  std::vector<GLuint> m_pages;
+  std::vector<int> m_freeCells;
+  std::unordered_map<char32_t, Entry> m_entries;
+  std::vector<char32_t> m_pending;
+
+  uint64_t m_frame = 1;
+  // Frame at which every page was found full. Text drawn since then has
+  // touched its glyphs, so anything older is off screen and can go.
+  uint64_t m_markFrame = 0;
+  uint64_t m_generation = 0;
+
+public:
+  GlyphCache();
+  ~GlyphCache();
+  GlyphCache(const GlyphCache &) = delete;
+  GlyphCache &operator=(const GlyphCache &) = delete;
+
+  // Takes a whole .ttf file (or the first font of a .ttc); false if it has
+  // no TrueType outlines or Unicode character map
+  bool loadFont(std::vector<unsigned char> ttf);
+  bool isLoaded() const { return m_font != nullptr; }
+
+  // Layout of code_point, marked as used this frame. A glyph that is still
+  // queued already has its advance but no texture.
+  const Character &get(char32_t code_point);
+  // Rasterizes queued glyphs; once per frame, before text is drawn
+  void update();
+  // Rasterizes every queued glyph regardless of the budget, so the frame
+  // does not depend on how fast this machine is (headless captures)
+  void flush();
+  // Changes whenever glyphs land or are evicted. Layouts built against an
+  // older generation must be rebuilt.
+  uint64_t getGeneration() const { return m_generation; }
+  size_t getPendingCount() const { return m_pending.size(); }
+
+private:
+  std::optional<int> _acquireCell();
+  void _evictUnused();
+  void _newPage();
+  void _rasterizePending(std::chrono::duration<double, std::milli> budget);
+  // false when no cell could be freed this frame
+  bool _rasterize(char32_t code_point, Entry &entry);
+};
@@ -37,9 +37,3 @@ GridBox::~GridBox() {
   glDeleteVertexArrays(1, &m_vao);
   glDeleteBuffers(1, &m_vbo);
 }
-
-void GridBox::render(const glm::mat4 &view, const glm::mat4 &projection) {
-  // You can use your existing Tetromino shader or a simple solid color shader
-  glBindVertexArray(m_vao);
-  glDrawArrays(GL_LINES, 0, m_vertexCount);
-}
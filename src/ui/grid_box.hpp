@@ -1,13 +1,17 @@
 #pragma once
 
 #include <glad/gl.h>
-#include <glm/glm.hpp>
 
 class GridBox {
 public:
   GridBox(float width, float height, float depth);
   ~GridBox();
-  void render(const glm::mat4 &view, const glm::mat4 &projection);
+  GridBox(const GridBox &) = delete;
+  GridBox &operator=(const GridBox &) = delete;
+
+  // Drawn as GL_LINES
+  GLuint getVAO() const { return m_vao; }
+  GLsizei getVertexCount() const { return m_vertexCount; }
 
 private:
   unsigned int m_vao, m_vbo;
@@ -0,0 +1,177 @@
+#include "sprite_batch.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+#include "core/shader_manager.hpp"
+
+SpriteBatch::SpriteBatch(StreamBuffer &stream, RenderQueue &queue,
+                         RenderPass pass, uint32_t max_quads)
+    : m_stream(stream), m_queue(queue), m_pass(pass),
+      m_maxQuads(std::min(max_quads, MAX_QUADS)) {
+  _setup_buffers();
+}
+
+SpriteBatch::~SpriteBatch() {
+  glDeleteBuffers(1, &m_ebo);
+  glDeleteVertexArrays(1, &m_vao);
+}
+
+void SpriteBatch::begin() {
+  m_drawCount = 0;
+  m_runs.clear();
+  _reserve();
+}
+
+void SpriteBatch::end() { _flush(); }
+
+void SpriteBatch::addQuad(glm::vec2 pos, glm::vec2 size, glm::vec4 color) {
+  writeQuad(allocate(1, 0), pos, size, glm::vec2(0.0f), glm::vec2(1.0f), color,
+            0.0f);
+}
+
+void SpriteBatch::addQuad(glm::vec2 pos, glm::vec2 size, glm::vec2 uv_min,
+                          glm::vec2 uv_max, glm::vec4 color, GLuint texture) {
+  writeQuad(allocate(1, texture), pos, size, uv_min, uv_max, color,
+            texture != 0 ? 1.0f : 0.0f);
+}
+
+std::span<SpriteVertex> SpriteBatch::allocate(uint32_t quad_count,
+                                              GLuint texture) {
+  uint32_t vertex_count = quad_count * VERTICES_PER_QUAD;
+  auto capacity = [&] {
+    return static_cast<uint32_t>(m_reservation.size / sizeof(SpriteVertex)) /
+           VERTICES_PER_QUAD;
+  };
+
+  if (m_quadCount + quad_count > capacity()) {
+    _flush();
+    if (!_reserve() || quad_count > capacity()) {
+      // Out of stream space this frame, the quads are dropped
+      m_discard.resize(vertex_count);
+      return m_discard;
+    }
+  }
+
+  // A run keeps going while the textures agree; flat quads fit any run
+  bool extends = !m_runs.empty() &&
+                 (texture == 0 || m_runs.back().texture == 0 ||
+                  m_runs.back().texture == texture);
+  if (extends) {
+    Run &run = m_runs.back();
+    if (texture != 0)
+      run.texture = texture;
+    run.quadCount += quad_count;
+  } else {
+    m_runs.push_back({texture, m_quadCount, quad_count});
+  }
+
+  auto vertices = m_reservation.as<SpriteVertex>();
+  std::span<SpriteVertex> out =
+      vertices.subspan(m_quadCount * VERTICES_PER_QUAD, vertex_count);
+  m_quadCount += quad_count;
+  return out;
+}
+
+void SpriteBatch::writeQuad(std::span<SpriteVertex> out, glm::vec2 pos,
+                            glm::vec2 size, glm::vec2 uv_min, glm::vec2 uv_max,
+                            glm::vec4 color, float textured) {
+  static constexpr std::array<glm::vec2, VERTICES_PER_QUAD> corners = {
+      glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec2(1.0f, 1.0f),
+      glm::vec2(0.0f, 1.0f)};
+
+  for (uint32_t i = 0; i < VERTICES_PER_QUAD; ++i) {
+    out[i] = {pos + corners[i] * size,
+              uv_min + corners[i] * (uv_max - uv_min), color, textured};
+  }
+}
+
+bool SpriteBatch::_reserve() {
+  m_reservation = m_stream.reserve(
+      m_maxQuads * VERTICES_PER_QUAD * sizeof(SpriteVertex),
+      sizeof(SpriteVertex));
+  m_quadCount = 0;
+  return static_cast<bool>(m_reservation);
+}
+
+void SpriteBatch::_flush() {
+  if (!m_reservation)
+    return;
+
+  m_stream.commit(m_reservation,
+                  m_quadCount * VERTICES_PER_QUAD * sizeof(SpriteVertex));
+
+  DrawPacket packet;
+  packet.pass = m_pass;
+  packet.material.shader = ShaderType::UI;
+  packet.material.flags = m_pass != RenderPass::UI ? Material::HUD : 0;
+  packet.vao = m_vao;
+  packet.indexType = GL_UNSIGNED_SHORT;
+  packet.vertexBuffer = m_reservation.buffer;
+  packet.vertexOffset = m_reservation.offset;
+  packet.vertexStride = sizeof(SpriteVertex);
+
+  for (const Run &run : m_runs) {
+    packet.material.texture = run.texture;
+    packet.first = static_cast<GLint>(run.firstQuad * 6 * sizeof(uint16_t));
+    packet.count = static_cast<GLsizei>(run.quadCount * 6);
+    m_queue.submit(packet);
+    ++m_drawCount;
+  }
+
+  m_reservation = {};
+  m_quadCount = 0;
+  m_runs.clear();
+}
+
+void SpriteBatch::_setup_buffers() {
+  static_assert(MAX_QUADS * VERTICES_PER_QUAD <= 65536,
+                "quad indices must fit in 16 bits");
+
+  // Two triangles per quad, shared by every frame
+  std::vector<uint16_t> indices(m_maxQuads * 6);
+  for (uint32_t q = 0; q < m_maxQuads; ++q) {
+    uint16_t base = static_cast<uint16_t>(q * VERTICES_PER_QUAD);
+    uint16_t *quad = &indices[q * 6];
+    quad[0] = base;
+    quad[1] = base + 1;
+    quad[2] = base + 2;
+    quad[3] = base;
+    quad[4] = base + 2;
+    quad[5] = base + 3;
+  }
+
+  glCreateBuffers(1, &m_ebo);
+  glNamedBufferStorage(m_ebo, indices.size() * sizeof(uint16_t),
+                       indices.data(), 0);
+
+  // Vertices live in the stream buffer, bound per packet
+  glCreateVertexArrays(1, &m_vao);
+
+  // index 0: vec2; position attribute
+  glEnableVertexArrayAttrib(m_vao, 0);
+  glVertexArrayAttribFormat(m_vao, 0, 2, GL_FLOAT, GL_FALSE,
+                            offsetof(SpriteVertex, pos));
+  glVertexArrayAttribBinding(m_vao, 0, 0);
+
+  // index 1: vec2; uv attribute
+  glEnableVertexArrayAttrib(m_vao, 1);
+  glVertexArrayAttribFormat(m_vao, 1, 2, GL_FLOAT, GL_FALSE,
+                            offsetof(SpriteVertex, uv));
+  glVertexArrayAttribBinding(m_vao, 1, 0);
+
+  // index 2: vec4; color attribute
+  glEnableVertexArrayAttrib(m_vao, 2);
+  glVertexArrayAttribFormat(m_vao, 2, 4, GL_FLOAT, GL_FALSE,
+                            offsetof(SpriteVertex, color));
+  glVertexArrayAttribBinding(m_vao, 2, 0);
+
+  // index 3: float; textured flag
+  glEnableVertexArrayAttrib(m_vao, 3);
+  glVertexArrayAttribFormat(m_vao, 3, 1, GL_FLOAT, GL_FALSE,
+                            offsetof(SpriteVertex, textured));
+  glVertexArrayAttribBinding(m_vao, 3, 0);
+
+  glVertexArrayElementBuffer(m_vao, m_ebo);
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include "core/render_queue.hpp"
+#include "core/stream_buffer.hpp"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+struct SpriteVertex {
+  glm::vec2 pos;
+  glm::vec2 uv;
+  glm::vec4 color;
+  // 0 = flat color, 1 = sample the batch texture, 2 = distance field in the
+  // texture's alpha (text)
+  float textured;
+};
+
+// Writes UI quads straight into a StreamBuffer reservation and submits one
+// packet per run of quads sharing a texture. Untextured quads never break a
+// run, so a HUD of text and panels is a single draw.
+class SpriteBatch {
+public:
+  static constexpr uint32_t MAX_QUADS = 4096;
+  static constexpr uint32_t VERTICES_PER_QUAD = 4;
+
+  // pass is HUD_BACKGROUND (FrameData::hudProjection) or UI
+  // (FrameData::screenProjection)
+  SpriteBatch(StreamBuffer &stream, RenderQueue &queue, RenderPass pass,
+              uint32_t max_quads = MAX_QUADS);
+  ~SpriteBatch();
+
+  SpriteBatch(const SpriteBatch &) = delete;
+  SpriteBatch &operator=(const SpriteBatch &) = delete;
+
+  void begin();
+  void end();
+
+  void addQuad(glm::vec2 pos, glm::vec2 size, glm::vec4 color);
+  void addQuad(glm::vec2 pos, glm::vec2 size, glm::vec2 uv_min,
+               glm::vec2 uv_max, glm::vec4 color, GLuint texture);
+
+  // Reserves quad_count (<= max_quads) quads drawn with texture; fill all
+  // VERTICES_PER_QUAD vertices of each in corner order (0,0) (1,0) (1,1) (0,1)
+  std::span<SpriteVertex> allocate(uint32_t quad_count, GLuint texture);
+
+  uint32_t getDrawCount() const { return m_drawCount; }
+
+  static void writeQuad(std::span<SpriteVertex> out, glm::vec2 pos,
+                        glm::vec2 size, glm::vec2 uv_min, glm::vec2 uv_max,
+                        glm::vec4 color, float textured);
+
+private:
+  struct Run {
+    GLuint texture; // 0 until a textured quad joins the run
+    uint32_t firstQuad;
+    uint32_t quadCount;
+  };
+
+  StreamBuffer &m_stream;
+  RenderQueue &m_queue;
+  RenderPass m_pass;
+  StreamBuffer::Allocation m_reservation;
+  uint32_t m_quadCount = 0; // quads written into m_reservation
+  std::vector<Run> m_runs;
+  std::vector<SpriteVertex> m_discard; // target when the stream is full
+  uint32_t m_maxQuads;
+  uint32_t m_drawCount = 0;
+
+  GLuint m_vao = 0;
+  GLuint m_ebo = 0;
+
+  bool _reserve();
+  void _flush();
+  void _setup_buffers();
+};
@@ -0,0 +1,437 @@
+#include "truetype.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace {
+
+// Curves are flattened to lines within this many texels
+constexpr float FLATNESS = 0.05f;
+constexpr int MAX_CURVE_SEGMENTS = 16;
+// Bounds on what a malformed font can make one glyph cost: glyphs visited
+// through compound references (which can loop), and edges
+constexpr int MAX_OUTLINE_GLYPHS = 64;
+constexpr size_t MAX_EDGES = 16384;
+
+// Simple glyph point flags
+constexpr uint8_t ON_CURVE = 0x01;
+constexpr uint8_t X_SHORT = 0x02;
+constexpr uint8_t Y_SHORT = 0x04;
+constexpr uint8_t REPEAT = 0x08;
+constexpr uint8_t X_SAME_OR_POSITIVE = 0x10;
+constexpr uint8_t Y_SAME_OR_POSITIVE = 0x20;
+
+// Compound glyph component flags
+constexpr uint16_t ARGS_ARE_WORDS = 0x0001;
+constexpr uint16_t ARGS_ARE_XY_VALUES = 0x0002;
+constexpr uint16_t HAS_SCALE = 0x0008;
+constexpr uint16_t MORE_COMPONENTS = 0x0020;
+constexpr uint16_t HAS_XY_SCALE = 0x0040;
+constexpr uint16_t HAS_2X2 = 0x0080;
+
+constexpr uint32_t tag(const char (&name)[5]) {
+  return uint32_t(uint8_t(name[0])) << 24 | uint32_t(uint8_t(name[1])) << 16 |
+         uint32_t(uint8_t(name[2])) << 8 | uint32_t(uint8_t(name[3]));
+}
+
+} // namespace
+
+bool TrueTypeFont::load(std::span<const unsigned char> data) {
+  m_data = data;
+
+  size_t font = 0;
+  if (_u32(0) == tag("ttcf"))
+    font = _u32(12);
+  uint32_t version = _u32(font);
+  size_t head = _findTable(font, "head");
+  size_t hhea = _findTable(font, "hhea");
+  size_t maxp = _findTable(font, "maxp");
+  size_t cmap = _findTable(font, "cmap");
+  m_loca = _findTable(font, "loca");
+  m_glyf = _findTable(font, "glyf");
+  m_hmtx = _findTable(font, "hmtx");
+  if ((version != 0x00010000 && version != tag("true")) || !head || !hhea ||
+      !maxp || !cmap || !m_loca || !m_glyf || !m_hmtx) {
+    m_data = {};
+    return false;
+  }
+
+  m_longOffsets = _i16(head + 50) != 0;
+  m_glyphCount = _u16(maxp + 4);
+  m_ascent = _i16(hhea + 4);
+  m_descent = _i16(hhea + 6);
+  m_metricCount = _u16(hhea + 34);
+
+  // A Unicode map, the full repertoire (format 12) over the BMP (format 4)
+  m_cmap = 0;
+  int best = 0;
+  for (size_t i = 0; i < _u16(cmap + 2); ++i) {
+    size_t record = cmap + 4 + 8 * i;
+    uint16_t platform = _u16(record);
+    uint16_t encoding = _u16(record + 2);
+    size_t subtable = cmap + _u32(record + 4);
+    bool unicode =
+        platform == 0 || (platform == 3 && (encoding == 1 || encoding == 10));
+    uint16_t format = _u16(subtable);
+    int rank = !unicode ? 0 : format == 12 ? 2 : format == 4 ? 1 : 0;
+    if (rank > best) {
+      best = rank;
+      m_cmap = subtable;
+    }
+  }
+
+  if (best == 0 || m_glyphCount == 0 || m_metricCount == 0 ||
+      m_ascent == m_descent) {
+    m_data = {};
+    return false;
+  }
+  return true;
+}
+
+float TrueTypeFont::scaleForPixelHeight(float pixels) const {
+  return pixels / static_cast<float>(m_ascent - m_descent);
+}
+
+int TrueTypeFont::findGlyph(char32_t code_point) const {
+  uint32_t glyph = 0;
+
+  if (_u16(m_cmap) == 12) {
+    // Groups of consecutive code points, sorted
+    uint32_t lo = 0, hi = _u32(m_cmap + 12);
+    while (lo < hi) {
+      uint32_t mid = lo + (hi - lo) / 2;
+      size_t group = m_cmap + 16 + 12 * size_t(mid);
+      uint32_t first = _u32(group);
+      if (code_point < first) {
+        hi = mid;
+      } else if (code_point > _u32(group + 4)) {
+        lo = mid + 1;
+      } else {
+        glyph = _u32(group + 8) + (code_point - first);
+        break;
+      }
+    }
+  } else if (code_point <= 0xFFFF) {
+    // Segments sorted by their last code point, in four parallel arrays
+    size_t segments_x2 = _u16(m_cmap + 6);
+    size_t ends = m_cmap + 14;
+    size_t starts = ends + segments_x2 + 2;
+    size_t deltas = starts + segments_x2;
+    size_t ranges = deltas + segments_x2;
+
+    for (size_t i = 0; i < segments_x2; i += 2) {
+      if (_u16(ends + i) < code_point)
+        continue;
+      uint16_t first = _u16(starts + i);
+      if (code_point < first)
+        break;
+
+      uint16_t delta = _u16(deltas + i);
+      uint16_t range = _u16(ranges + i);
+      if (range == 0) {
+        glyph = (code_point + delta) & 0xFFFF;
+      } else {
+        // The offset is relative to the range entry itself
+        uint16_t id = _u16(ranges + i + range + 2 * (code_point - first));
+        glyph = id == 0 ? 0 : (id + delta) & 0xFFFF;
+      }
+      break;
+    }
+  }
+
+  return glyph < uint32_t(m_glyphCount) ? static_cast<int>(glyph) : 0;
+}
+
+int TrueTypeFont::getAdvance(int glyph) const {
+  // Monospaced tails share the last advance
+  int index = std::clamp(glyph, 0, m_metricCount - 1);
+  return _u16(m_hmtx + 4 * size_t(index));
+}
+
+TrueTypeFont::Field TrueTypeFont::buildField(int glyph, float scale,
+                                             int padding,
+                                             unsigned char on_edge,
+                                             float distance_scale,
+                                             int max_size) const {
+  Field field;
+  std::vector<Edge> edges;
+  int budget = MAX_OUTLINE_GLYPHS;
+  _appendOutline(glyph, glm::mat3(1.0f), FLATNESS / scale, budget, edges);
+  if (edges.empty())
+    return field;
+
+  // To texels, y down from the baseline
+  glm::vec2 lo(FLT_MAX), hi(-FLT_MAX);
+  for (Edge &edge : edges) {
+    edge.a = glm::vec2(edge.a.x, -edge.a.y) * scale;
+    edge.b = glm::vec2(edge.b.x, -edge.b.y) * scale;
+    lo = glm::min(lo, glm::min(edge.a, edge.b));
+    hi = glm::max(hi, glm::max(edge.a, edge.b));
+  }
+
+  glm::vec2 extent = glm::ceil(hi) - glm::floor(lo) + 2.0f * padding;
+  if (extent.x > max_size || extent.y > max_size)
+    return field;
+
+  glm::ivec2 first = glm::ivec2(glm::floor(lo)) - padding;
+  glm::ivec2 last = glm::ivec2(glm::ceil(hi)) + padding;
+  field.width = last.x - first.x;
+  field.height = last.y - first.y;
+  field.offset = first;
+  field.texels.resize(size_t(field.width) * field.height);
+
+  for (int y = 0; y < field.height; ++y) {
+    for (int x = 0; x < field.width; ++x) {
+      glm::vec2 p = glm::vec2(first) + glm::vec2(x + 0.5f, y + 0.5f);
+      float nearest = FLT_MAX;
+      int winding = 0;
+
+      for (const Edge &edge : edges) {
+        glm::vec2 ab = edge.b - edge.a;
+        glm::vec2 ap = p - edge.a;
+        float length2 = glm::dot(ab, ab);
+        float t = length2 > 0.0f
+                      ? std::clamp(glm::dot(ap, ab) / length2, 0.0f, 1.0f)
+                      : 0.0f;
+        glm::vec2 d = ap - ab * t;
+        nearest = std::min(nearest, glm::dot(d, d));
+
+        // Nonzero winding, counted along a ray towards +x
+        if ((edge.a.y <= p.y) != (edge.b.y <= p.y)) {
+          float crossing = edge.a.x + (p.y - edge.a.y) * ab.x / ab.y;
+          if (crossing > p.x)
+            winding += edge.b.y > edge.a.y ? 1 : -1;
+        }
+      }
+
+      float distance = std::sqrt(nearest) * (winding != 0 ? 1.0f : -1.0f);
+      float value = std::clamp(on_edge + distance * distance_scale, 0.0f,
+                               255.0f);
+      field.texels[size_t(y) * field.width + x] =
+          static_cast<unsigned char>(value);
+    }
+  }
+  return field;
+}
+
+uint8_t TrueTypeFont::_u8(size_t offset) const {
+  return offset < m_data.size() ? m_data[offset] : 0;
+}
+
+uint16_t TrueTypeFont::_u16(size_t offset) const {
+  if (offset + 2 > m_data.size())
+    return 0;
+  return static_cast<uint16_t>(m_data[offset] << 8 | m_data[offset + 1]);
+}
+
+int16_t TrueTypeFont::_i16(size_t offset) const {
+  return static_cast<int16_t>(_u16(offset));
+}
+
+uint32_t TrueTypeFont::_u32(size_t offset) const {
+  return uint32_t(_u16(offset)) << 16 | _u16(offset + 2);
+}
+
+size_t TrueTypeFont::_findTable(size_t font, const char (&name)[5]) const {
+  for (size_t i = 0; i < _u16(font + 4); ++i) {
+    size_t record = font + 12 + 16 * i;
+    if (_u32(record) == tag(name)) {
+      size_t offset = _u32(record + 8);
+      return offset < m_data.size() ? offset : 0;
+    }
+  }
+  return 0;
+}
+
+bool TrueTypeFont::_glyphRange(int glyph, size_t &begin, size_t &end) const {
+  if (glyph < 0 || glyph >= m_glyphCount)
+    return false;
+
+  size_t index = size_t(glyph);
+  if (m_longOffsets) {
+    begin = _u32(m_loca + 4 * index);
+    end = _u32(m_loca + 4 * index + 4);
+  } else {
+    begin = 2 * size_t(_u16(m_loca + 2 * index));
+    end = 2 * size_t(_u16(m_loca + 2 * index + 2));
+  }
+  // Equal offsets mean no outline
+  if (begin >= end)
+    return false;
+
+  begin += m_glyf;
+  end += m_glyf;
+  return end <= m_data.size();
+}
+
+void TrueTypeFont::_appendOutline(int glyph, const glm::mat3 &transform,
+                                  float tolerance, int &budget,
+                                  std::vector<Edge> &edges) const {
+  size_t begin, end;
+  if (budget-- <= 0 || !_glyphRange(glyph, begin, end))
+    return;
+
+  int contours = _i16(begin);
+  if (contours < 0) {
+    // Compound: other glyphs, each placed by its own transform
+    size_t pos = begin + 10;
+    uint16_t flags;
+    do {
+      flags = _u16(pos);
+      int component = _u16(pos + 2);
+      pos += 4;
+
+      glm::vec2 offset;
+      if (flags & ARGS_ARE_WORDS) {
+        offset = glm::vec2(_i16(pos), _i16(pos + 2));
+        pos += 4;
+      } else {
+        offset = glm::vec2(int8_t(_u8(pos)), int8_t(_u8(pos + 1)));
+        pos += 2;
+      }
+      // Anchoring by matching points is not supported
+      if (!(flags & ARGS_ARE_XY_VALUES))
+        offset = glm::vec2(0.0f);
+
+      auto f2dot14 = [&](size_t at) { return _i16(at) / 16384.0f; };
+      glm::mat2 linear(1.0f);
+      if (flags & HAS_SCALE) {
+        linear = glm::mat2(f2dot14(pos));
+        pos += 2;
+      } else if (flags & HAS_XY_SCALE) {
+        linear[0][0] = f2dot14(pos);
+        linear[1][1] = f2dot14(pos + 2);
+        pos += 4;
+      } else if (flags & HAS_2X2) {
+        linear = glm::mat2(f2dot14(pos), f2dot14(pos + 2), f2dot14(pos + 4),
+                           f2dot14(pos + 6));
+        pos += 8;
+      }
+
+      glm::mat3 local(glm::vec3(linear[0], 0.0f), glm::vec3(linear[1], 0.0f),
+                      glm::vec3(offset, 1.0f));
+      _appendOutline(component, transform * local, tolerance, budget, edges);
+    } while ((flags & MORE_COMPONENTS) && pos < end);
+    return;
+  }
+
+  if (contours == 0)
+    return;
+
+  size_t end_points = begin + 10;
+  int point_count = _u16(end_points + 2 * size_t(contours - 1)) + 1;
+  size_t pos = end_points + 2 * size_t(contours);
+  pos += 2 + _u16(pos); // hinting instructions
+
+  std::vector<uint8_t> flags(point_count);
+  for (int i = 0; i < point_count;) {
+    uint8_t flag = _u8(pos++);
+    int repeat = 1;
+    if (flag & REPEAT)
+      repeat += _u8(pos++);
+    for (; repeat > 0 && i < point_count; --repeat)
+      flags[i++] = flag;
+  }
+
+  // Coordinates are deltas: all x, then all y
+  std::vector<glm::vec2> points(point_count);
+  int coordinate = 0;
+  for (int i = 0; i < point_count; ++i) {
+    if (flags[i] & X_SHORT) {
+      int delta = _u8(pos++);
+      coordinate += (flags[i] & X_SAME_OR_POSITIVE) ? delta : -delta;
+    } else if (!(flags[i] & X_SAME_OR_POSITIVE)) {
+      coordinate += _i16(pos);
+      pos += 2;
+    }
+    points[i].x = static_cast<float>(coordinate);
+  }
+  coordinate = 0;
+  for (int i = 0; i < point_count; ++i) {
+    if (flags[i] & Y_SHORT) {
+      int delta = _u8(pos++);
+      coordinate += (flags[i] & Y_SAME_OR_POSITIVE) ? delta : -delta;
+    } else if (!(flags[i] & Y_SAME_OR_POSITIVE)) {
+      coordinate += _i16(pos);
+      pos += 2;
+    }
+    points[i].y = static_cast<float>(coordinate);
+  }
+  for (glm::vec2 &point : points)
+    point = glm::vec2(transform * glm::vec3(point, 1.0f));
+
+  auto line = [&](glm::vec2 a, glm::vec2 b) {
+    if (edges.size() < MAX_EDGES)
+      edges.push_back({a, b});
+  };
+  auto curve = [&](glm::vec2 a, glm::vec2 control, glm::vec2 b) {
+    // A quadratic strays |a - 2c + b| / 4 from its chord, and a quarter of
+    // that per halving of the step
+    float bulge = glm::length(a - 2.0f * control + b) / 4.0f;
+    int segments = std::clamp(
+        static_cast<int>(std::ceil(std::sqrt(bulge / tolerance))), 1,
+        MAX_CURVE_SEGMENTS);
+    glm::vec2 previous = a;
+    for (int i = 1; i <= segments; ++i) {
+      float t = static_cast<float>(i) / segments;
+      glm::vec2 next = (1 - t) * (1 - t) * a + 2 * (1 - t) * t * control +
+                       t * t * b;
+      line(previous, next);
+      previous = next;
+    }
+  };
+
+  int first = 0;
+  for (int contour = 0; contour < contours; ++contour) {
+    int last = std::min<int>(_u16(end_points + 2 * size_t(contour)),
+                             point_count - 1);
+    int count = last - first + 1;
+    if (count < 2) {
+      first = last + 1;
+      continue;
+    }
+
+    // Two off-curve points in a row imply an on-curve one between them.
+    // Start on a point that is on the curve, or on such a midpoint.
+    auto on = [&](int i) { return (flags[i] & ON_CURVE) != 0; };
+    glm::vec2 start;
+    int next = first, stop = last;
+    if (on(first)) {
+      start = points[first];
+      next = first + 1;
+    } else if (on(last)) {
+      start = points[last];
+      stop = last - 1;
+    } else {
+      start = (points[first] + points[last]) * 0.5f;
+    }
+
+    glm::vec2 current = start, control{0.0f};
+    bool has_control = false;
+    for (int i = next; i <= stop; ++i) {
+      if (on(i)) {
+        if (has_control)
+          curve(current, control, points[i]);
+        else
+          line(current, points[i]);
+        current = points[i];
+        has_control = false;
+      } else {
+        if (has_control) {
+          glm::vec2 middle = (control + points[i]) * 0.5f;
+          curve(current, control, middle);
+          current = middle;
+        }
+        control = points[i];
+        has_control = true;
+      }
+    }
+    if (has_control)
+      curve(current, control, start);
+    else
+      line(current, start);
+
+    first = last + 1;
+  }
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Reader for the parts of a TrueType font that GlyphCache draws from:
+// character map, horizontal metrics and quadratic glyph outlines (simple
+// and compound). CFF outlines (.otf with an 'OTTO' tag) are not supported.
+// The font keeps a view of the file data, which has to outlive it.
+class TrueTypeFont {
+public:
+  // Distance field of one glyph: on_edge on the outline, rising inside,
+  // rows from the top
+  struct Field {
+    std::vector<unsigned char> texels; // width * height, row major
+    int width = 0;
+    int height = 0;
+    glm::ivec2 offset{0}; // top-left texel from the pen on the baseline
+  };
+
+private:
+  struct Edge {
+    glm::vec2 a, b;
+  };
+
+  std::span<const unsigned char> m_data;
+  size_t m_cmap = 0; // chosen Unicode subtable
+  size_t m_loca = 0;
+  size_t m_glyf = 0;
+  size_t m_hmtx = 0;
+  int m_glyphCount = 0;
+  int m_metricCount = 0;
+  bool m_longOffsets = false;
+  int m_ascent = 0;
+  int m_descent = 0;
+
+public:
+  // false if the data is not a TrueType font (or a collection of them,
+  // whose first font is used)
+  bool load(std::span<const unsigned char> data);
+
+  // Font units to pixels for a line height of `pixels`, ascent to descent
+  float scaleForPixelHeight(float pixels) const;
+  int getAscent() const { return m_ascent; }
+
+  // 0 (the missing glyph) for code points the font lacks
+  int findGlyph(char32_t code_point) const;
+  // In font units
+  int getAdvance(int glyph) const;
+
+  // Signed distance field of the glyph at `scale`, with `padding` texels
+  // around its box; values move `distance_scale` away from on_edge per
+  // texel of distance. Empty for glyphs without an outline (spaces) and
+  // for fields wider or taller than max_size.
+  Field buildField(int glyph, float scale, int padding, unsigned char on_edge,
+                   float distance_scale, int max_size) const;
+
+private:
+  uint8_t _u8(size_t offset) const;
+  uint16_t _u16(size_t offset) const;
+  int16_t _i16(size_t offset) const;
+  uint32_t _u32(size_t offset) const;
+  size_t _findTable(size_t font, const char (&tag)[5]) const;
+  bool _glyphRange(int glyph, size_t &begin, size_t &end) const;
+  // Appends the glyph's outline as line segments in font units, curves
+  // flattened to within `tolerance` font units. Each glyph visited, the
+  // components of compound ones included, uses up one of `budget`.
+  void _appendOutline(int glyph, const glm::mat3 &transform, float tolerance,
+                      int &budget, std::vector<Edge> &edges) const;
+};
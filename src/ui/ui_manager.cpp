@@ -1,146 +1,155 @@
 #include "ui_manager.hpp"
+#include "ui/utf8.hpp"
 
 #include "glad/gl.h"
-#include <algorithm>
-#include <glm/gtc/matrix_transform.hpp>
 
-#include "core/geometry.hpp"
-#include "core/shader_manager.hpp"
-#include "glm/fwd.hpp"
+#include <algorithm>
 
 // StaticElement
-StaticElement::StaticElement(std::string name, UIHitbox box, glm::vec4 color)
+StaticElement::StaticElement(UIHitbox box, glm::vec4 color)
     : color(color), hasTexture(false) {
-  this->name = std::move(name);
   this->bounds = box;
 }
 
-StaticElement::StaticElement(std::string name, UIHitbox box, GLuint tex_id)
-    : textureID(tex_id), hasTexture(true) {
-  this->name = std::move(name);
+StaticElement::StaticElement(UIHitbox box, GLuint tex_id)
+    : StaticElement(box, AtlasRegion{tex_id}) {}
+
+StaticElement::StaticElement(UIHitbox box, AtlasRegion image)
+    : image(image), hasTexture(true) {
   this->bounds = box;
 }
 
-void StaticElement::draw(const Shader &shader) {
-  glm::mat4 model = glm::mat4(1.0f);
-  model = glm::translate(model, glm::vec3(bounds.x, bounds.y, 0.0f));
-  model = glm::scale(model, glm::vec3(bounds.w, bounds.h, 1.0f));
-
-  shader.setMat4("u_model", model);
-  shader.setVec4("u_color", color);
-  shader.setBool("u_hasTexture", hasTexture);
-
-  if (hasTexture) {
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, textureID);
-    shader.setInt("u_icon", 0);
-  }
+void StaticElement::draw(SpriteBatch &batch) const {
+  glm::vec2 pos(bounds.x, bounds.y);
+  glm::vec2 size(bounds.w, bounds.h);
 
-  glDrawArrays(GL_TRIANGLES, 0, 6);
+  if (hasTexture)
+    batch.addQuad(pos, size, image.uvMin, image.uvMax, color, image.texture);
+  else
+    batch.addQuad(pos, size, color);
 }
 
 // InteractiveElement
-InteractiveElement::InteractiveElement(std::string name, UIHitbox box,
-                                       GLuint tex_id, std::function<void()> cb)
-    : StaticElement(std::move(name), box, tex_id), onClick(std::move(cb)) {}
+InteractiveElement::InteractiveElement(UIHitbox box, GLuint tex_id,
+                                       std::function<void()> cb)
+    : StaticElement(box, tex_id), onClick(std::move(cb)) {}
 
-InteractiveElement::InteractiveElement(std::string name, UIHitbox box,
-                                       glm::vec4 color,
+InteractiveElement::InteractiveElement(UIHitbox box, AtlasRegion image,
                                        std::function<void()> cb)
-    : StaticElement(std::move(name), box, color), onClick(std::move(cb)) {}
+    : StaticElement(box, image), onClick(std::move(cb)) {}
+
+InteractiveElement::InteractiveElement(UIHitbox box, glm::vec4 color,
+                                       std::function<void()> cb)
+    : StaticElement(box, color), onClick(std::move(cb)) {}
 
 // TextElement
-TextElement::TextElement(std::string name, UIHitbox box, std::string text,
-                         const BitmapFont &font, glm::vec4 color, float scale)
-    : text(std::move(text)), font(font), color(color), scale(scale) {
-  this->name = std::move(name);
+TextElement::TextElement(UIHitbox box, std::string text, BitmapFont &font,
+                         glm::vec4 color, float scale)
+    : text(std::move(text)), font(&font), color(color), scale(scale) {
   this->bounds = box;
 }
 
-void TextElement::draw(const Shader &shader) {
-  shader.setVec4("u_color", color);
-  shader.setBool("u_hasTexture", true);
-
-  glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_2D, font.getTexID());
-  shader.setInt("u_icon", 0);
+void TextElement::draw(SpriteBatch &batch) {
+  layout();
 
-  float currentX = bounds.x;
-  float currentY = bounds.y;
+  // Only the origin and color are applied per frame
+  glm::vec2 origin(bounds.x, bounds.y);
+  size_t next = 0;
 
-  for (char c : text) {
-    const Character &ch = font.getCharacter(c);
+  for (const GlyphRun &run : m_runs) {
+    std::span<SpriteVertex> out = batch.allocate(run.quadCount, run.texture);
 
-    float w = ch.size.x * scale;
-    float h = ch.size.y * scale;
-
-    glm::mat4 model = glm::mat4(1.0f);
-    model = glm::translate(model, glm::vec3(currentX, currentY, 0.0f));
-    model = glm::scale(model, glm::vec3(w, h, 1.0f));
+    // out is write-combined mapped memory, so only ever store into it
+    for (SpriteVertex &slot : out) {
+      SpriteVertex vertex = m_glyphCache[next++];
+      vertex.pos += origin;
+      vertex.color = color;
+      slot = vertex;
+    }
+  }
+}
 
-    shader.setMat4("u_model", model);
-    shader.setVec2("u_uv_min", ch.uvMin);
-    shader.setVec2("u_uv_max", ch.uvMax);
+bool TextElement::_isStale() const {
+  return text != m_cachedText || scale != m_cachedScale ||
+         font->getGeneration() != m_cachedGeneration;
+}
 
-    glDrawArrays(GL_TRIANGLES, 0, 6);
+void TextElement::_rebuildGlyphCache() {
+  m_cachedText = text;
+  m_cachedScale = scale;
+  m_cachedGeneration = font->getGeneration();
+  m_glyphCache.clear();
+  m_runs.clear();
+
+  float currentX = 0.0f;
+  for (size_t pos = 0; pos < text.size();) {
+    const Character &ch = font->getCharacter(utf8::decode(text, pos));
+
+    // Whitespace and glyphs still being rasterized only advance the pen
+    if (ch.texture != 0) {
+      glm::vec2 size = ch.size * scale;
+      glm::vec2 quadPos = glm::vec2(currentX, 0.0f) + ch.bearing * scale;
+
+      size_t first = m_glyphCache.size();
+      m_glyphCache.resize(first + SpriteBatch::VERTICES_PER_QUAD);
+      SpriteBatch::writeQuad(std::span(m_glyphCache).subspan(first),
+                             quadPos, size, ch.uvMin, ch.uvMax,
+                             glm::vec4(1.0f), 2.0f);
+
+      if (m_runs.empty() || m_runs.back().texture != ch.texture)
+        m_runs.push_back({ch.texture, 0});
+      ++m_runs.back().quadCount;
+    }
 
     currentX += ch.advance * scale;
   }
-
-  // Reset UVs for next elements
-  shader.setVec2("u_uv_min", glm::vec2(0.0f, 0.0f));
-  shader.setVec2("u_uv_max", glm::vec2(1.0f, 1.0f));
+  m_cachedWidth = currentX;
 }
 
-// UIManager
-UIManager::UIManager() { _setup_buffers(); }
+float TextElement::getWidth() {
+  layout();
+  return m_cachedWidth;
+}
 
-UIManager::~UIManager() {
-  glDeleteBuffers(1, &m_vbo);
-  glDeleteVertexArrays(1, &m_vao);
+void TextElement::layout() {
+  if (_isStale())
+    _rebuildGlyphCache();
 }
 
-void UIManager::addStaticElement(std::string name, UIHitbox box,
-                                 glm::vec4 color) {
-  m_elements.push_back(
-      std::make_unique<StaticElement>(std::move(name), box, color));
+// UIManager
+StaticHandle UIManager::addStaticElement(UIHitbox box, glm::vec4 color) {
+  return _add(StaticElement(box, color));
 }
 
-void UIManager::addStaticElement(std::string name, UIHitbox box,
-                                 GLuint tex_id) {
-  m_elements.push_back(
-      std::make_unique<StaticElement>(std::move(name), box, tex_id));
+StaticHandle UIManager::addStaticElement(UIHitbox box, GLuint tex_id) {
+  return _add(StaticElement(box, tex_id));
 }
 
-void UIManager::addInteractiveElement(std::string name, UIHitbox box,
-                                      GLuint tex_id, std::function<void()> cb) {
-  auto element = std::make_unique<InteractiveElement>(std::move(name), box,
-                                                      tex_id, std::move(cb));
-  m_interactives.push_back(element.get());
-  m_elements.push_back(std::move(element));
+StaticHandle UIManager::addStaticElement(UIHitbox box, AtlasRegion image) {
+  return _add(StaticElement(box, image));
 }
 
-void UIManager::addInteractiveElement(std::string name, UIHitbox box,
-                                      glm::vec4 color,
-                                      std::function<void()> cb) {
-  auto element = std::make_unique<InteractiveElement>(std::move(name), box,
-                                                      color, std::move(cb));
-  m_interactives.push_back(element.get());
-  m_elements.push_back(std::move(element));
+InteractiveHandle UIManager::addInteractiveElement(UIHitbox box, GLuint tex_id,
+                                                   std::function<void()> cb) {
+  return _add(InteractiveElement(box, tex_id, std::move(cb)));
 }
 
-void UIManager::addTextElement(std::string name, UIHitbox box, std::string text,
-                               const BitmapFont &font, glm::vec4 color,
-                               float scale) {
-  m_elements.push_back(std::make_unique<TextElement>(
-      std::move(name), box, std::move(text), font, color, scale));
+InteractiveHandle UIManager::addInteractiveElement(UIHitbox box,
+                                                   AtlasRegion image,
+                                                   std::function<void()> cb) {
+  return _add(InteractiveElement(box, image, std::move(cb)));
 }
 
-UIBase *UIManager::getElement(const std::string &name) {
-  auto it = std::ranges::find_if(
-      m_elements, [&name](const auto &el) { return el->name == name; });
+InteractiveHandle UIManager::addInteractiveElement(UIHitbox box,
+                                                   glm::vec4 color,
+                                                   std::function<void()> cb) {
+  return _add(InteractiveElement(box, color, std::move(cb)));
+}
 
-  return it != m_elements.end() ? it->get() : nullptr;
+TextHandle UIManager::addTextElement(UIHitbox box, std::string text,
+                                     BitmapFont &font, glm::vec4 color,
+                                     float scale) {
+  return _add(TextElement(box, std::move(text), font, color, scale));
 }
 
 bool UIManager::handleClick(double mouseX, double mouseY) {
@@ -148,74 +157,60 @@ bool UIManager::handleClick(double mouseX, double mouseY) {
   float vx = (float)mouseX * (m_virtualWidth / (float)m_lastWindowWidth);
   float vy = (float)mouseY * (m_virtualHeight / (float)m_lastWindowHeight);
 
-  for (auto it = m_interactives.rbegin(); it != m_interactives.rend(); ++it) {
-    if ((*it)->visible && (*it)->bounds.contains(vx, vy)) {
-      if ((*it)->onClick) {
-        (*it)->onClick();
-        return true;
-      }
+  // Topmost (last drawn) first
+  std::span<InteractiveElement> interactives = m_interactives.items();
+  for (auto it = interactives.rbegin(); it != interactives.rend(); ++it) {
+    if (it->visible && it->bounds.contains(vx, vy) && it->onClick) {
+      it->onClick();
+      return true;
     }
   }
   return false;
 }
 
-void UIManager::render(int windowWidth, int windowHeight) {
-  Shader &shader = ShaderManager::getShader(ShaderType::UI);
-  shader.use();
+void UIManager::layoutText() {
+  for (TextElement &text : m_texts.items()) {
+    if (text.visible)
+      text.layout();
+  }
+}
 
+void UIManager::render(int windowWidth, int windowHeight) {
   m_lastWindowWidth = windowWidth;
   m_lastWindowHeight = windowHeight;
-  m_virtualHeight = 40.0f;
+  m_virtualHeight = VIRTUAL_HEIGHT;
   float aspect = (float)windowWidth / (float)windowHeight;
   m_virtualWidth = m_virtualHeight * aspect;
 
-  glm::mat4 projection =
-      glm::ortho(0.0f, m_virtualWidth, m_virtualHeight, 0.0f);
-  shader.setMat4("u_projection", projection);
-
-  glDisable(GL_DEPTH_TEST);
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-  glBindVertexArray(m_vao);
-
-  for (const auto &el : m_elements) {
-    if (el->visible)
-      el->draw(shader);
+  // The matching projection is FrameData::screenProjection
+  m_batch.begin();
+  // Each pool is already in order; merge them
+  std::span<StaticElement> statics = m_statics.items();
+  std::span<InteractiveElement> interactives = m_interactives.items();
+  std::span<TextElement> texts = m_texts.items();
+  size_t s = 0, i = 0, t = 0;
+  while (true) {
+    uint32_t next_static = s < statics.size() ? statics[s].order : UINT32_MAX;
+    uint32_t next_interactive =
+        i < interactives.size() ? interactives[i].order : UINT32_MAX;
+    uint32_t next_text = t < texts.size() ? texts[t].order : UINT32_MAX;
+    uint32_t next = std::min({next_static, next_interactive, next_text});
+    if (next == UINT32_MAX)
+      break;
+
+    if (next == next_static) {
+      if (statics[s].visible)
+        statics[s].draw(m_batch);
+      ++s;
+    } else if (next == next_interactive) {
+      if (interactives[i].visible)
+        interactives[i].draw(m_batch);
+      ++i;
+    } else {
+      if (texts[t].visible)
+        texts[t].draw(m_batch);
+      ++t;
+    }
   }
-
-  glEnable(GL_DEPTH_TEST);
-}
-
-GLuint UIManager::getVAO() const { return m_vao; }
-
-void UIManager::_setup_buffers() {
-  UIVertex vertices[] = {
-      {{0.0f, 0.0f}, {0.0f, 0.0f}}, {{0.0f, 1.0f}, {0.0f, 1.0f}},
-      {{1.0f, 1.0f}, {1.0f, 1.0f}}, {{0.0f, 0.0f}, {0.0f, 0.0f}},
-      {{1.0f, 1.0f}, {1.0f, 1.0f}}, {{1.0f, 0.0f}, {1.0f, 0.0f}}};
-
-  // Create UI VBO
-  glCreateBuffers(1, &m_vbo);
-  glNamedBufferStorage(m_vbo, sizeof(vertices), vertices, 0);
-
-  // Setup UI VAO
-  glCreateVertexArrays(1, &m_vao);
-
-  // index 0: vec2; position attribute
-  glEnableVertexArrayAttrib(m_vao, 0);
-  glVertexArrayAttribFormat(m_vao, 0, 2, GL_FLOAT, GL_FALSE,
-                            offsetof(UIVertex, pos));
-  glVertexArrayAttribBinding(m_vao, 0, 0);
-
-  // index 1: vec2; position attribute
-  glEnableVertexArrayAttrib(m_vao, 1);
-  glVertexArrayAttribFormat(m_vao, 1, 2, GL_FLOAT, GL_FALSE,
-                            offsetof(UIVertex, uv));
-  glVertexArrayAttribBinding(m_vao, 1, 0);
-
-  // Link VAO <-> VBO
-  glVertexArrayVertexBuffer(m_vao, 0, m_vbo, 0, sizeof(UIVertex));
-
-  glEnable(GL_DEPTH_TEST);
+  m_batch.end();
 }
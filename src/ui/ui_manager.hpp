@@ -3,11 +3,21 @@
 #include <glad/gl.h>
 #include <glm/glm.hpp>
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <format>
 #include <functional>
-#include <memory>
+#include <span>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 
+#include "core/observable.hpp"
+#include "core/texture_atlas.hpp"
+#include "sprite_batch.hpp"
+
 struct UIHitbox {
   float x, y, w, h;
 
@@ -16,27 +26,26 @@ struct UIHitbox {
   }
 };
 
-class UIBase {
-public:
-  std::string name;
+// Common fields, no virtuals: UIManager keeps every element type in its
+// own array and draws each array in a tight loop
+struct UIBase {
   UIHitbox bounds;
   bool visible = true;
-
-public:
-  virtual ~UIBase() = default;
-  virtual void draw(const class Shader &shader) = 0;
+  uint32_t order = 0; // set by UIManager; draw order across all types
 };
 
 class StaticElement : public UIBase {
 public:
-  GLuint textureID = 0;
+  // An atlas sub-rect, or a whole texture with UVs 0..1
+  AtlasRegion image;
   glm::vec4 color = {1.0f, 1.0f, 1.0f, 1.0f};
   bool hasTexture = false;
 
 public:
-  StaticElement(std::string name, UIHitbox box, glm::vec4 color);
-  StaticElement(std::string name, UIHitbox box, GLuint tex_id);
-  void draw(const class Shader &shader) override;
+  StaticElement(UIHitbox box, glm::vec4 color);
+  StaticElement(UIHitbox box, GLuint tex_id);
+  StaticElement(UIHitbox box, AtlasRegion image);
+  void draw(SpriteBatch &batch) const;
 };
 
 class InteractiveElement : public StaticElement {
@@ -44,62 +53,227 @@ public:
   std::function<void()> onClick;
 
 public:
-  InteractiveElement(std::string name, UIHitbox box, GLuint tex_id,
-                     std::function<void()> cb);
-  InteractiveElement(std::string name, UIHitbox box, glm::vec4 color,
+  InteractiveElement(UIHitbox box, GLuint tex_id, std::function<void()> cb);
+  InteractiveElement(UIHitbox box, AtlasRegion image,
                      std::function<void()> cb);
+  InteractiveElement(UIHitbox box, glm::vec4 color, std::function<void()> cb);
 };
 
 #include "font.hpp"
 
 class TextElement : public UIBase {
 public:
-  std::string text;
-  const BitmapFont &font;
+  std::string text; // UTF-8
+  BitmapFont *font;
   glm::vec4 color = {1.0f, 1.0f, 1.0f, 1.0f};
   float scale = 1.0f;
 
 public:
-  TextElement(std::string name, UIHitbox box, std::string text,
-              const BitmapFont &font, glm::vec4 color, float scale = 1.0f);
-  void draw(const class Shader &shader) override;
+  TextElement(UIHitbox box, std::string text, BitmapFont &font,
+              glm::vec4 color, float scale = 1.0f);
+  void draw(SpriteBatch &batch);
+  // Reuses the string's capacity, so it only allocates when the text grows
+  // past its longest length so far
+  void setText(std::string_view value) { text.assign(value); }
+  // Laid-out width, from the same cache as the glyph quads
+  float getWidth();
+  // Rebuilds the quads if stale, queueing glyphs the font is missing
+  void layout();
+
+private:
+  // Consecutive glyphs on the same texture (atlas or glyph cache page)
+  struct GlyphRun {
+    GLuint texture;
+    uint32_t quadCount;
+  };
+
+  // Glyph quads relative to bounds origin, rebuilt when the text, scale or
+  // the font's glyph generation change
+  std::vector<SpriteVertex> m_glyphCache;
+  std::vector<GlyphRun> m_runs;
+  std::string m_cachedText;
+  float m_cachedScale = 0.0f;
+  uint64_t m_cachedGeneration = 0;
+  float m_cachedWidth = 0.0f;
+
+  bool _isStale() const;
+  void _rebuildGlyphCache();
+};
+
+// Fixed-capacity text, for formatting without touching the heap. Output
+// longer than N is cut off.
+template <size_t N> struct InlineText {
+  std::array<char, N> buffer;
+  size_t size = 0;
+
+  std::string_view view() const { return {buffer.data(), size}; }
+};
+
+template <size_t N = 64, typename... Args>
+InlineText<N> formatInline(std::format_string<Args...> fmt, Args &&...args) {
+  InlineText<N> text;
+  auto result = std::format_to_n(text.buffer.data(), N, fmt,
+                                 std::forward<Args>(args)...);
+  text.size = std::min<size_t>(result.size, N);
+  return text;
+}
+
+// Refers to one element of a UIManager. Stays valid while the element
+// exists; after remove() the generation no longer matches and lookups
+// return nullptr. A default handle refers to nothing.
+template <typename T> struct UIHandle {
+  static constexpr uint32_t INVALID = UINT32_MAX;
+
+  uint32_t index = INVALID;
+  uint32_t generation = 0;
+
+  bool isValid() const { return index != INVALID; }
+};
+
+using StaticHandle = UIHandle<StaticElement>;
+using InteractiveHandle = UIHandle<InteractiveElement>;
+using TextHandle = UIHandle<TextElement>;
+
+// Elements of one type, packed in insertion order, so `order` ascends.
+// Handles index a slot table that points into the packed array.
+template <typename T> class UIPool {
+private:
+  struct Slot {
+    uint32_t item;
+    uint32_t generation;
+  };
+
+  std::vector<T> m_items;
+  std::vector<uint32_t> m_itemSlots; // slot of each item
+  std::vector<Slot> m_slots;
+  std::vector<uint32_t> m_freeSlots;
+
+public:
+  UIHandle<T> add(T element) {
+    uint32_t slot;
+    if (!m_freeSlots.empty()) {
+      slot = m_freeSlots.back();
+      m_freeSlots.pop_back();
+    } else {
+      slot = static_cast<uint32_t>(m_slots.size());
+      m_slots.push_back({UIHandle<T>::INVALID, 0});
+    }
+
+    m_slots[slot].item = static_cast<uint32_t>(m_items.size());
+    m_items.push_back(std::move(element));
+    m_itemSlots.push_back(slot);
+    return {slot, m_slots[slot].generation};
+  }
+
+  T *get(UIHandle<T> handle) {
+    if (handle.index >= m_slots.size())
+      return nullptr;
+    const Slot &slot = m_slots[handle.index];
+    if (slot.generation != handle.generation ||
+        slot.item == UIHandle<T>::INVALID)
+      return nullptr;
+    return &m_items[slot.item];
+  }
+
+  // Keeps the remaining elements in order, so it is O(n); removal is rare
+  void remove(UIHandle<T> handle) {
+    if (!get(handle))
+      return;
+
+    Slot &slot = m_slots[handle.index];
+    m_items.erase(m_items.begin() + slot.item);
+    m_itemSlots.erase(m_itemSlots.begin() + slot.item);
+    for (uint32_t i = slot.item; i < m_items.size(); ++i)
+      m_slots[m_itemSlots[i]].item = i;
+
+    slot.item = UIHandle<T>::INVALID;
+    ++slot.generation;
+    m_freeSlots.push_back(handle.index);
+  }
+
+  std::span<T> items() { return m_items; }
 };
 
 class UIManager {
 private:
-  std::vector<std::unique_ptr<UIBase>> m_elements;
-  std::vector<InteractiveElement *> m_interactives;
-  GLuint m_vao = 0;
-  GLuint m_vbo = 0;
+  UIPool<StaticElement> m_statics;
+  UIPool<InteractiveElement> m_interactives;
+  UIPool<TextElement> m_texts;
+  SpriteBatch m_batch;
+  uint32_t m_nextOrder = 0;
   float m_virtualWidth = 1.0f;
   float m_virtualHeight = 1.0f;
   int m_lastWindowWidth = 1;
   int m_lastWindowHeight = 1;
 
 public:
-  UIManager();
-  ~UIManager();
+  // UI is laid out in a virtual space this many units tall
+  static constexpr float VIRTUAL_HEIGHT = 40.0f;
+
+  UIManager(StreamBuffer &stream, RenderQueue &queue)
+      : m_batch(stream, queue, RenderPass::UI) {}
 
-  void addStaticElement(std::string name, UIHitbox box, glm::vec4 color);
-  void addStaticElement(std::string name, UIHitbox box, GLuint tex_id);
-  void addInteractiveElement(std::string name, UIHitbox box, GLuint tex_id,
-                             std::function<void()> cb);
-  void addInteractiveElement(std::string name, UIHitbox box, glm::vec4 color,
-                             std::function<void()> cb);
-  void addTextElement(std::string name, UIHitbox box, std::string text,
-                      const BitmapFont &font, glm::vec4 color,
-                      float scale = 1.0f);
+  StaticHandle addStaticElement(UIHitbox box, glm::vec4 color);
+  StaticHandle addStaticElement(UIHitbox box, GLuint tex_id);
+  // Prefer atlas images (TextureManager::getUIAtlas()): quads sharing a
+  // page batch into one draw with the text
+  StaticHandle addStaticElement(UIHitbox box, AtlasRegion image);
+  InteractiveHandle addInteractiveElement(UIHitbox box, GLuint tex_id,
+                                          std::function<void()> cb);
+  InteractiveHandle addInteractiveElement(UIHitbox box, glm::vec4 color,
+                                          std::function<void()> cb);
+  InteractiveHandle addInteractiveElement(UIHitbox box, AtlasRegion image,
+                                          std::function<void()> cb);
+  TextHandle addTextElement(UIHitbox box, std::string text,
+                            BitmapFont &font, glm::vec4 color,
+                            float scale = 1.0f);
+
+  // nullptr once the element has been removed
+  template <typename T> T *get(UIHandle<T> handle) {
+    return _pool<T>().get(handle);
+  }
+  template <typename T> void remove(UIHandle<T> handle) {
+    _pool<T>().remove(handle);
+  }
 
-  UIBase *getElement(const std::string &name);
+  // Keeps a text element showing value. It is formatted only when the value
+  // changes, into a stack buffer, so a steady HUD costs nothing per frame.
+  // value must outlive the UIManager.
+  template <typename T>
+  void bindText(TextHandle handle, Observable<T> &value,
+                std::format_string<const T &> fmt) {
+    value.subscribe([this, handle, fmt](const T &current) {
+      if (TextElement *element = get(handle))
+        element->setText(formatInline(fmt, current).view());
+    });
+  }
 
+  // Submits the visible elements to the UI pass in the order they were
+  // added, whatever their type, so later elements draw on top
   void render(int window_width, int window_height);
+  // Lays out visible text ahead of render(), so the glyphs it needs can be
+  // rasterized first
+  void layoutText();
   bool handleClick(double pos_x, double pos_y);
 
   float getVirtualWidth() const { return m_virtualWidth; }
   float getVirtualHeight() const { return m_virtualHeight; }
 
-  GLuint getVAO() const;
+  // Draw packets submitted by the last render()
+  uint32_t getDrawCount() const { return m_batch.getDrawCount(); }
 
 private:
-  void _setup_buffers();
+  template <typename T> UIHandle<T> _add(T element) {
+    element.order = m_nextOrder++;
+    return _pool<T>().add(std::move(element));
+  }
+
+  template <typename T> UIPool<T> &_pool() {
+    if constexpr (std::is_same_v<T, StaticElement>)
+      return m_statics;
+    else if constexpr (std::is_same_v<T, InteractiveElement>)
+      return m_interactives;
+    else
+      return m_texts;
+  }
 };
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace utf8 {
+
+constexpr char32_t REPLACEMENT = 0xFFFD;
+
+// Decodes the code point starting at text[pos] and moves pos past it.
+// Malformed, overlong and surrogate sequences decode to REPLACEMENT and
+// skip a single byte, so decoding always makes progress.
+constexpr char32_t decode(std::string_view text, size_t &pos) {
+  unsigned char lead = static_cast<unsigned char>(text[pos++]);
+  if (lead < 0x80)
+    return lead;
+
+  int length;
+  char32_t code;
+  char32_t minimum;
+  if ((lead & 0xE0) == 0xC0) {
+    length = 1;
+    code = lead & 0x1F;
+    minimum = 0x80;
+  } else if ((lead & 0xF0) == 0xE0) {
+    length = 2;
+    code = lead & 0x0F;
+    minimum = 0x800;
+  } else if ((lead & 0xF8) == 0xF0) {
+    length = 3;
+    code = lead & 0x07;
+    minimum = 0x10000;
+  } else {
+    return REPLACEMENT;
+  }
+
+  if (pos + length > text.size())
+    return REPLACEMENT;
+  for (int i = 0; i < length; ++i) {
+    unsigned char next = static_cast<unsigned char>(text[pos + i]);
+    if ((next & 0xC0) != 0x80)
+      return REPLACEMENT;
+    code = (code << 6) | (next & 0x3F);
+  }
+
+  if (code < minimum || code > 0x10FFFF || (code >= 0xD800 && code < 0xE000))
+    return REPLACEMENT;
+
+  pos += length;
+  return code;
+}
+
+} // namespace utf8
@@ -0,0 +1,112 @@
+// Packs a directory tree into one assets.pak (see
+// src/core/asset_archive_format.hpp).
+//
+// usage: pack_assets <output.pak> <assets dir>
+
+#include "core/asset_archive_format.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <print>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct PackedFile {
+  std::string name;
+  std::vector<char> data;
+  uint64_t hash;
+};
+
+static uint64_t alignUp(uint64_t value) {
+  uint64_t a = asset_archive::ALIGNMENT;
+  return (value + a - 1) / a * a;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc != 3) {
+    std::println(stderr, "usage: pack_assets <output.pak> <assets dir>");
+    return 1;
+  }
+
+  fs::path output = argv[1];
+  fs::path root = argv[2];
+
+  std::vector<PackedFile> files;
+  for (const fs::directory_entry &entry :
+       fs::recursive_directory_iterator(root)) {
+    if (!entry.is_regular_file())
+      continue;
+
+    std::ifstream in(entry.path(), std::ios::binary);
+    if (!in) {
+      std::println(stderr, "pack_assets: cannot read {}",
+                   entry.path().string());
+      return 1;
+    }
+
+    PackedFile file;
+    file.name = entry.path().lexically_relative(root).generic_string();
+    file.data.assign(std::istreambuf_iterator<char>(in), {});
+    file.hash = asset_archive::hashName(file.name);
+    files.push_back(std::move(file));
+  }
+
+  // The runtime binary-searches the index
+  std::ranges::sort(files, [](const PackedFile &a, const PackedFile &b) {
+    return a.hash != b.hash ? a.hash < b.hash : a.name < b.name;
+  });
+
+  std::vector<asset_archive::Entry> entries(files.size());
+  std::string names;
+  for (size_t i = 0; i < files.size(); ++i) {
+    entries[i].nameHash = files[i].hash;
+    entries[i].nameOffset = 0; // fixed up below
+    entries[i].nameLength = static_cast<uint32_t>(files[i].name.size());
+    entries[i].dataSize = files[i].data.size();
+    names += files[i].name;
+  }
+
+  uint64_t names_start = sizeof(asset_archive::Header) +
+                         entries.size() * sizeof(asset_archive::Entry);
+  uint64_t cursor = alignUp(names_start + names.size());
+  uint32_t name_cursor = static_cast<uint32_t>(names_start);
+  for (asset_archive::Entry &entry : entries) {
+    entry.nameOffset = name_cursor;
+    name_cursor += entry.nameLength;
+    entry.dataOffset = cursor;
+    cursor = alignUp(cursor + entry.dataSize);
+  }
+
+  asset_archive::Header header{};
+  std::memcpy(header.magic, asset_archive::MAGIC, sizeof(header.magic));
+  header.version = asset_archive::VERSION;
+  header.entryCount = static_cast<uint32_t>(entries.size());
+
+  std::ofstream out(output, std::ios::binary | std::ios::trunc);
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  out.write(reinterpret_cast<const char *>(entries.data()),
+            entries.size() * sizeof(asset_archive::Entry));
+  out.write(names.data(), names.size());
+
+  static const char padding[asset_archive::ALIGNMENT] = {};
+  uint64_t written = names_start + names.size();
+  for (size_t i = 0; i < files.size(); ++i) {
+    out.write(padding, entries[i].dataOffset - written);
+    out.write(files[i].data.data(), files[i].data.size());
+    written = entries[i].dataOffset + entries[i].dataSize;
+  }
+
+  if (!out) {
+    std::println(stderr, "pack_assets: cannot write {}", output.string());
+    return 1;
+  }
+
+  std::println("pack_assets: {} files, {} bytes -> {}", files.size(), written,
+               output.string());
+  return 0;
+}